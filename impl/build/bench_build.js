@@ -0,0 +1,60 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+//Builds the icpp runtime microbenchmarks (not part of build_all) -- node ./bench_build.js then run output/stackbench, output/sortcheck, output/mapcheck, or output/heapimagecheck
+
+const fsx = require("fs-extra");
+const path = require("path");
+const proc = require('child_process');
+
+const rootsrc = path.join(__dirname, "../", "src/tooling/icpp/interpreter");
+const apisrc = path.join(__dirname, "../", "src/tooling/api_parse");
+const benchsrc = path.join(__dirname, "../", "src/tooling/icpp/bench");
+
+//everything but the runner (it has the icpp main)
+const interpfiles = fsx.readdirSync(rootsrc).filter((ff) => ff.endsWith(".cpp") && ff !== "runner.cpp").map((ff) => path.join(rootsrc, ff));
+const cppfiles = [apisrc, path.join(rootsrc, "runtime")].map((pp) => pp + "/*.cpp").concat(interpfiles);
+
+const includebase = path.join(__dirname, "include");
+const includeheaders = [path.join(includebase, "headers/json")];
+const outexec = path.join(__dirname, "output");
+
+const benches = ["stackbench", "sortcheck", "mapcheck", "heapimagecheck"];
+
+let compiler = "";
+let ccflags = "";
+let includes = " ";
+if(process.platform === "darwin") {
+    compiler = "clang++";
+    ccflags = "-O2 -g -DBSQ_DEBUG_BUILD -Wall -std=c++20";
+    includes = includeheaders.map((ih) => `-I ${ih}`).join(" ");
+}
+else if(process.platform === "linux") {
+    compiler = "clang++";
+    ccflags = "-O2 -g -DBSQ_DEBUG_BUILD -Wall -std=c++20 -pthread";
+    includes = includeheaders.map((ih) => `-I ${ih}`).join(" ");
+}
+else {
+    console.log("The benchmarks are only built on linux and macos");
+    process.exit(1);
+}
+
+fsx.ensureDirSync(outexec);
+
+for(let i = 0; i < benches.length; ++i) {
+    const outfile = "-o " + path.join(outexec, benches[i]);
+    const command = `${compiler} ${ccflags} ${includes} ${outfile} ${path.join(benchsrc, benches[i] + ".cpp")} ${cppfiles.join(" ")}`;
+
+    console.log(command);
+
+    try {
+        const outstr = proc.execSync(command).toString();
+        console.log(`${outstr}`);
+    }
+    catch (ex) {
+        console.log(ex.toString());
+        process.exit(1);
+    }
+}
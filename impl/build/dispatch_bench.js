@@ -0,0 +1,140 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+//Compares the threaded and the switch op loop (not part of build_all) -- run build_all first (for bin/cmd/bosque.js) then node ./dispatch_bench.js [runs]
+//Builds an -O2 icpp for each dispatch mode, compiles the nbody, lcr, and order apps to bytecode, and reports the median of the runs for each app and mode
+
+const fsx = require("fs-extra");
+const path = require("path");
+const proc = require('child_process');
+
+const rootsrc = path.join(__dirname, "../", "src/tooling/icpp/interpreter");
+const apisrc = path.join(__dirname, "../", "src/tooling/api_parse");
+const cppfiles = [apisrc, rootsrc, path.join(rootsrc, "runtime")].map((pp) => pp + "/*.cpp");
+
+const includebase = path.join(__dirname, "include");
+const includeheaders = [path.join(includebase, "headers/json")];
+const outexec = path.join(__dirname, "output", "dispatch");
+
+const bosquecmd = path.join(__dirname, "../", "bin/cmd/bosque.js");
+const appsrc = path.join(__dirname, "../", "src/test/apps");
+
+const runs = process.argv.length > 2 ? Number.parseInt(process.argv[2]) : 20;
+
+//the entrypoint and API JSON args each app is run with
+const apps = [
+    {name: "nbody", main: "Main::main", args: []},
+    {name: "lcr", main: "Main::hqlaAmount", args: [[], [], 1000000.0]},
+    {name: "order", main: "Main::main", args: [["Main::BuyRequest", {id: "rq1", requestPrice: ["Main::Market", {}], quantity: 5, product: "apples"}], 10.0, 100, []]}
+];
+
+const modes = [
+    {name: "threaded", flags: ""},
+    {name: "switch", flags: " -DBSQ_SWITCH_DISPATCH"}
+];
+
+let compiler = "";
+let ccflags = "";
+let includes = " ";
+if(process.platform === "darwin") {
+    compiler = "clang++";
+    ccflags = "-O2 -g -DBSQ_DEBUG_BUILD -Wall -std=c++20";
+    includes = includeheaders.map((ih) => `-I ${ih}`).join(" ");
+}
+else if(process.platform === "linux") {
+    compiler = "clang++";
+    ccflags = "-O2 -g -DBSQ_DEBUG_BUILD -Wall -std=c++20 -pthread";
+    includes = includeheaders.map((ih) => `-I ${ih}`).join(" ");
+}
+else {
+    console.log("The dispatch comparison is only built on linux and macos (MSVC always uses the switch loop)");
+    process.exit(1);
+}
+
+if(!Number.isInteger(runs) || runs <= 0) {
+    console.log("Usage: node ./dispatch_bench.js [runs]");
+    process.exit(1);
+}
+
+function execOrExit(command, cwd) {
+    console.log(command);
+
+    try {
+        proc.execSync(command, {cwd: cwd, stdio: "inherit"});
+    }
+    catch (ex) {
+        console.log(ex.toString());
+        process.exit(1);
+    }
+}
+
+function median(vals) {
+    const svals = [...vals].sort((a, b) => a - b);
+    return svals[Math.floor(svals.length / 2)];
+}
+
+fsx.ensureDirSync(outexec);
+
+for(let i = 0; i < modes.length; ++i) {
+    const outfile = "-o " + path.join(outexec, "icpp_" + modes[i].name);
+    execOrExit(`${compiler} ${ccflags}${modes[i].flags} ${includes} ${outfile} ${cppfiles.join(" ")}`, __dirname);
+}
+
+//bosque build bytecode writes the app into its bin directory
+for(let i = 0; i < apps.length; ++i) {
+    const appdir = path.join(appsrc, apps[i].name);
+    execOrExit(`node ${bosquecmd} build bytecode ${path.join(appdir, "package.json")}`, appdir);
+
+    const bytecode = fsx.readdirSync(path.join(appdir, "bin")).filter((ff) => ff.endsWith(".json"));
+    if(bytecode.length !== 1) {
+        console.log(`Expected one bytecode file in ${path.join(appdir, "bin")}`);
+        process.exit(1);
+    }
+    apps[i].bytecode = path.join(appdir, "bin", bytecode[0]);
+}
+
+//wall time includes loading the bytecode -- the icpp time is just the run of the entrypoint (ms resolution)
+let results = [];
+for(let i = 0; i < apps.length; ++i) {
+    const input = JSON.stringify({main: apps[i].main, args: apps[i].args});
+
+    for(let j = 0; j < modes.length; ++j) {
+        const exe = path.join(outexec, "icpp_" + modes[j].name);
+
+        let walltimes = [];
+        let icpptimes = [];
+        for(let k = 0; k < runs; ++k) {
+            const start = process.hrtime.bigint();
+            const res = proc.spawnSync(exe, [apps[i].bytecode, input], {env: {...process.env, ICPP_OUTPUT_MODE: "json"}});
+            const end = process.hrtime.bigint();
+
+            let robj = undefined;
+            try {
+                robj = JSON.parse(res.stdout.toString());
+            }
+            catch (ex) {
+                ;
+            }
+
+            if(res.status !== 0 || robj === undefined || robj["status"] !== "success") {
+                console.log(`${apps[i].name} failed with ${modes[j].name} dispatch -- ${res.stdout.toString()}${res.stderr.toString()}`);
+                process.exit(1);
+            }
+
+            walltimes.push(Number(end - start) / 1000000);
+            icpptimes.push(robj["time"]);
+        }
+
+        results.push({app: apps[i].name, mode: modes[j].name, wall: median(walltimes), icpp: median(icpptimes)});
+    }
+}
+
+console.log(`\nMedian of ${runs} runs (ms)`);
+for(let i = 0; i < apps.length; ++i) {
+    const threaded = results.find((rr) => rr.app === apps[i].name && rr.mode === "threaded");
+    const sswitch = results.find((rr) => rr.app === apps[i].name && rr.mode === "switch");
+
+    console.log(`${apps[i].name.padEnd(8)} threaded wall ${threaded.wall.toFixed(2)} icpp ${threaded.icpp} | switch wall ${sswitch.wall.toFixed(2)} icpp ${sswitch.icpp} | switch/threaded wall ${(sswitch.wall / threaded.wall).toFixed(3)}`);
+}
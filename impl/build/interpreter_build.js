@@ -28,7 +28,7 @@ if(process.platform === "darwin") {
 }
 else if(process.platform === "linux") {
     compiler = "clang++";
-    ccflags = "-O0 -g -DBSQ_DEBUG_BUILD -Wall -std=c++20";
+    ccflags = "-O0 -g -DBSQ_DEBUG_BUILD -Wall -std=c++20 -pthread";
     includes = includeheaders.map((ih) => `-I ${ih}`).join(" ");
     outfile = "-o " + outexec + "/icpp";
 }
@@ -39,6 +39,16 @@ else {
     outfile = "/Fo:\"" + outobj + "/\"" + " " + "/Fd:\"" + outexec + "/\"" + " " + "/Fe:\"" + outexec + "\\icpp.exe\"";
 }
 
+//set BSQ_SWITCH_DISPATCH in the environment to build with the portable switch op loop instead of threaded dispatch
+if(process.env.BSQ_SWITCH_DISPATCH !== undefined && process.platform !== "win32") {
+    ccflags = ccflags + " -DBSQ_SWITCH_DISPATCH";
+}
+
+//set BSQ_PROFILE in the environment to build in the profiler (--profile or ICPP_PROFILE)
+if(process.env.BSQ_PROFILE !== undefined) {
+    ccflags = ccflags + (process.platform !== "win32" ? " -DBSQ_PROFILE" : " /D \"BSQ_PROFILE\"");
+}
+
 const command = `${compiler} ${ccflags} ${includes} ${outfile} ${cppfiles.join(" ")}`;
 
 fsx.ensureDirSync(outexec);
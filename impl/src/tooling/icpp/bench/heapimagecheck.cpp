@@ -0,0 +1,254 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+//Check the heap image round trip -- save a shared tree of constants and a String | None union holding a heap string, load them back (and collect over them), and make sure
+//stale, truncated, and corrupted images are rejected before anything is patched so the loader falls back to the initializers
+//Build with build/bench_build.js and run as heapimagecheck [imagefile] -- exits with 1 if a check fails
+
+#include "../interpreter/heap_image.h"
+#include "../interpreter/op_eval.h"
+
+#include <fstream>
+#include <functional>
+
+#define CHECK_TREE_DEPTH 12
+
+#define CHECK_TYPE_ID_NODE 26
+#define CHECK_TYPE_ID_UNION 27
+#define CHECK_TYPE_ID_REGEX_STRUCT 28
+#define CHECK_TYPE_COUNT 29
+
+//the constant buffer holds the two tree slots and the String | None union (type word + 16 byte String) at the end
+#define CHECK_UNION_OFFSET 40
+#define CHECK_UNION_STRING "a string too long to be inlined"
+
+//A node with two child pointers and an id (so the shape and the payload can both be checked after the load)
+class CheckNodeType : public BSQType
+{
+public:
+    CheckNodeType(BSQTypeID tid, RefMask heapmask) : BSQType(tid, BSQTypeLayoutKind::Ref, BSQTypeSizeInfo{24, 8, 8, heapmask, "2"}, REF_GC_FUNCTOR_SET, {}, nullptr, nullptr, "CheckNode") {;}
+    virtual ~CheckNodeType() {;}
+
+    void clearValue(StorageLocationPtr trgt) const override final
+    {
+        ;
+    }
+
+    void storeValue(StorageLocationPtr trgt, StorageLocationPtr src) const override final
+    {
+        ;
+    }
+
+    StorageLocationPtr indexStorageLocationOffset(StorageLocationPtr src, size_t offset) const override final
+    {
+        return nullptr;
+    }
+};
+
+static const CheckNodeType* s_nodetype = nullptr;
+static const BSQUnionInlineType* s_uniontype = nullptr;
+
+static void* buildTree(size_t depth, uintptr_t id)
+{
+    if(depth == 0)
+    {
+        return nullptr;
+    }
+
+    //the whole tree fits in the nursery so nothing is moved while the children are unrooted
+    void* l = buildTree(depth - 1, id * 2);
+    void* r = buildTree(depth - 1, id * 2 + 1);
+
+    Allocator::GlobalAllocator.ensureSpace(s_nodetype);
+    void** node = (void**)Allocator::GlobalAllocator.allocateSafe(s_nodetype);
+    node[0] = l;
+    node[1] = r;
+    node[2] = (void*)id;
+
+    return node;
+}
+
+static bool checkTree(void* node, size_t depth, uintptr_t id)
+{
+    if(node == nullptr)
+    {
+        return depth == 0;
+    }
+
+    GC_META_DATA_WORD w = GC_LOAD_META_DATA_WORD(GC_GET_META_DATA_ADDR(node));
+    if(depth == 0 || GC_TEST_IS_YOUNG(w) || GC_EXTRACT_TYPEID(w) != s_nodetype->tid || GC_EXTRACT_RC(w) < GC_RC_IMMORTAL || (uintptr_t)((void**)node)[2] != id)
+    {
+        return false;
+    }
+
+    return checkTree(((void**)node)[0], depth - 1, id * 2) && checkTree(((void**)node)[1], depth - 1, id * 2 + 1);
+}
+
+static void storeHeapStringUnion()
+{
+    size_t len = strlen(CHECK_UNION_STRING);
+
+    Allocator::GlobalAllocator.ensureSpace(BSQWellKnownType::g_typeStringKRepr32);
+    uint8_t* repr = (uint8_t*)Allocator::GlobalAllocator.allocateSafe(BSQWellKnownType::g_typeStringKRepr32);
+    repr[0] = (uint8_t)len;
+    GC_MEM_COPY(repr + 1, CHECK_UNION_STRING, len);
+
+    uint8_t* uslot = Evaluator::g_constantbuffer + CHECK_UNION_OFFSET;
+    *((const BSQType**)uslot) = BSQWellKnownType::g_typeString;
+    ((BSQString*)(uslot + sizeof(void*)))->u_data = repr;
+}
+
+//the String has to be relocated to a (immortal) copy in the image -- the original is still in the nursery so a copied process pointer would look right otherwise
+static bool checkHeapStringUnion()
+{
+    uint8_t* uslot = Evaluator::g_constantbuffer + CHECK_UNION_OFFSET;
+    const BSQString* str = (const BSQString*)(uslot + sizeof(void*));
+    if(*((const BSQType**)uslot) != BSQWellKnownType::g_typeString || IS_INLINE_STRING(str))
+    {
+        return false;
+    }
+
+    GC_META_DATA_WORD w = GC_LOAD_META_DATA_WORD(GC_GET_META_DATA_ADDR(str->u_data));
+    const uint8_t* repr = (const uint8_t*)str->u_data;
+    size_t len = strlen(CHECK_UNION_STRING);
+
+    return !GC_TEST_IS_YOUNG(w) && GC_EXTRACT_TYPEID(w) == BSQ_TYPE_ID_STRINGREPR_K32 && GC_EXTRACT_RC(w) >= GC_RC_IMMORTAL && repr[0] == len && memcmp(repr + 1, CHECK_UNION_STRING, len) == 0;
+}
+
+//the relocation table is at the end of the image (reloccount is the last header field) -- each entry is {pos, kind}
+static uint64_t* relocEntry(std::vector<char>& image, size_t i)
+{
+    uint64_t reloccount = *((uint64_t*)(image.data() + 6 * sizeof(uint64_t)));
+    return (uint64_t*)(image.data() + image.size() - (reloccount - i) * 2 * sizeof(uint64_t));
+}
+
+//the object section follows the header, the slot table (offset/pos pairs), and the slot data
+static uint64_t* firstObjectHeader(std::vector<char>& image)
+{
+    uint64_t slotcount = *((uint64_t*)(image.data() + 3 * sizeof(uint64_t)));
+    uint64_t slotbytes = *((uint64_t*)(image.data() + 4 * sizeof(uint64_t)));
+    return (uint64_t*)(image.data() + 7 * sizeof(uint64_t) + slotcount * 2 * sizeof(uint64_t) + slotbytes);
+}
+
+static std::vector<char> readImage(const std::string& imagefile)
+{
+    std::ifstream infile(imagefile, std::ios::binary);
+    return std::vector<char>((std::istreambuf_iterator<char>(infile)), std::istreambuf_iterator<char>());
+}
+
+static void writeImage(const std::string& imagefile, const std::vector<char>& contents)
+{
+    std::ofstream outfile(imagefile, std::ios::binary | std::ios::trunc);
+    outfile.write(contents.data(), contents.size());
+}
+
+//a bad image must be rejected and leave the constant buffer as it was
+static bool checkRejected(const char* what, const std::string& imagefile, const std::vector<char>& contents, uint64_t key, const std::vector<HeapImageConstSlot>& slots)
+{
+    writeImage(imagefile, contents);
+
+    void* before = *((void**)(Evaluator::g_constantbuffer + slots[0].offset));
+    bool ok = !loadHeapImage(imagefile, key, slots, CHECK_TYPE_COUNT) && *((void**)(Evaluator::g_constantbuffer + slots[0].offset)) == before;
+
+    printf("%s -- %s\n", ok ? "ok" : "FAILED", what);
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    std::string imagefile = (argc > 1) ? std::string(argv[1]) : std::string("heapimagecheck.img");
+
+    static const BSQType* typetable[CHECK_TYPE_COUNT];
+    Allocator::GlobalAllocator.initializeTypeSurvival(CHECK_TYPE_COUNT);
+    s_nodetype = new CheckNodeType(CHECK_TYPE_ID_NODE, "221");
+    s_uniontype = new BSQUnionInlineType(CHECK_TYPE_ID_UNION, 3 * sizeof(void*), "511", "String | None", {BSQ_TYPE_ID_NONE, BSQ_TYPE_ID_STRING});
+    typetable[BSQ_TYPE_ID_NONE] = BSQWellKnownType::g_typeNone;
+    typetable[BSQ_TYPE_ID_STRING] = BSQWellKnownType::g_typeString;
+    typetable[BSQ_TYPE_ID_STRINGREPR_K32] = BSQWellKnownType::g_typeStringKRepr32;
+    typetable[BSQ_TYPE_ID_INT] = BSQWellKnownType::g_typeInt;
+    typetable[BSQ_TYPE_ID_REGEX] = BSQWellKnownType::g_typeRegex;
+    typetable[CHECK_TYPE_ID_NODE] = s_nodetype;
+    typetable[CHECK_TYPE_ID_UNION] = s_uniontype;
+    BSQType::g_typetable = typetable;
+
+    Evaluator::g_constantbuffer = (uint8_t*)zxalloc(64);
+    Allocator::GlobalAllocator.setGlobalsMemory(Evaluator::g_constantbuffer, "22222511");
+    std::vector<HeapImageConstSlot> slots = {{8, s_nodetype}, {24, s_nodetype}, {CHECK_UNION_OFFSET, s_uniontype}};
+
+    //two constants sharing one tree -- the image has to keep the sharing
+    *((void**)(Evaluator::g_constantbuffer + 8)) = buildTree(CHECK_TREE_DEPTH, 1);
+    *((void**)(Evaluator::g_constantbuffer + 24)) = *((void**)(Evaluator::g_constantbuffer + 8));
+    storeHeapStringUnion();
+    saveHeapImage(imagefile, 42, slots);
+
+    std::vector<char> image = readImage(imagefile);
+    bool ok = image.size() > 2 * sizeof(uint64_t);
+    if(!ok)
+    {
+        printf("FAILED -- no image written to %s\n", imagefile.c_str());
+        return 1;
+    }
+
+    ok &= checkRejected("stale key", imagefile, image, 43, slots);
+
+    std::vector<char> truncated(image.begin(), image.end() - 1);
+    ok &= checkRejected("truncated image", imagefile, truncated, 42, slots);
+
+    std::vector<char> badpos = image;
+    relocEntry(badpos, 0)[0] = (uint64_t)image.size();
+    ok &= checkRejected("relocation past the end of the image", imagefile, badpos, 42, slots);
+
+    std::vector<char> headerpos = image;
+    relocEntry(headerpos, 0)[0] = 0;
+    ok &= checkRejected("relocation in the header", imagefile, headerpos, 42, slots);
+
+    //heap pointer relocations come first and the word at one is a file offset -- read as a type id it is past the end of the type table
+    std::vector<char> badtype = image;
+    ok &= (relocEntry(badtype, 0)[1] == 0);
+    relocEntry(badtype, 0)[1] = 1;
+    ok &= checkRejected("type id outside the type table", imagefile, badtype, 42, slots);
+
+    std::vector<char> badheader = image;
+    *firstObjectHeader(badheader) = GC_RC_IMMORTAL | (CHECK_TYPE_COUNT + 1);
+    ok &= checkRejected("object header type id outside the type table", imagefile, badheader, 42, slots);
+
+    //still inside the object section but not at the start of an object
+    std::vector<char> midobject = image;
+    *((uint64_t*)(midobject.data() + relocEntry(midobject, 0)[0])) += sizeof(void*);
+    ok &= checkRejected("heap pointer into the middle of an object", imagefile, midobject, 42, slots);
+
+    writeImage(imagefile, image);
+    GC_MEM_ZERO(Evaluator::g_constantbuffer, 64);
+
+    bool loaded = loadHeapImage(imagefile, 42, slots, CHECK_TYPE_COUNT);
+    void* root = *((void**)(Evaluator::g_constantbuffer + 8));
+    bool roundtrip = loaded && root != nullptr && root == *((void**)(Evaluator::g_constantbuffer + 24));
+
+    //the image objects are old and immortal -- collections must leave them where they are
+    for(size_t i = 0; i < 4; ++i)
+    {
+        Allocator::GlobalAllocator.collect();
+    }
+    roundtrip = roundtrip && root == *((void**)(Evaluator::g_constantbuffer + 8)) && checkTree(root, CHECK_TREE_DEPTH, 1) && checkHeapStringUnion();
+
+    printf("%s -- save then load round trip\n", roundtrip ? "ok" : "FAILED");
+    ok &= roundtrip;
+
+    //a Regex nested in a struct constant is a raw pointer with a nop GC mask -- no image may be written for it
+    typetable[CHECK_TYPE_ID_REGEX_STRUCT] = new BSQEntityStructType(CHECK_TYPE_ID_REGEX_STRUCT, 2 * sizeof(void*), "11", {}, "RegexHolder", true, 0, {0, 1}, {0, sizeof(void*)}, {BSQ_TYPE_ID_INT, BSQ_TYPE_ID_REGEX});
+    std::vector<HeapImageConstSlot> regexslots = {{0, typetable[CHECK_TYPE_ID_REGEX_STRUCT]}};
+
+    std::string regeximagefile = imagefile + ".regex";
+    std::remove(regeximagefile.c_str());
+    saveHeapImage(regeximagefile, 42, regexslots);
+
+    bool regexrejected = readImage(regeximagefile).empty();
+    printf("%s -- no image for a Regex nested in a struct\n", regexrejected ? "ok" : "FAILED");
+    ok &= regexrejected;
+    std::remove(regeximagefile.c_str());
+
+    std::remove(imagefile.c_str());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+//Check (and time) the persistent Map tree on sequential inserts (the worst case for an unbalanced tree) -- the maps are
+//rooted in a GC frame so the inserts run with the collector moving the trees and every node is checked afterwards
+//Build with build/bench_build.js and run as mapcheck [size] -- exits with 1 if a tree is out of order, unbalanced, or too tall
+
+#include "../interpreter/collection_eval.h"
+
+#include <chrono>
+#include <cmath>
+
+static const BSQMapTreeType* s_treetype = nullptr;
+static BSQMapTypeFlavor* s_flavor = nullptr;
+
+static void setupMapTypes()
+{
+    static const BSQType* typetable[4];
+
+    Allocator::GlobalAllocator.initializeTypeSurvival(4);
+
+    auto inttype = CONS_BSQ_INT_TYPE(1, "Int");
+    s_treetype = new BSQMapTreeType(2, 40, "22111", "MapTree", 1, 24, 1, 32);
+    auto tupletype = new BSQTupleStructType(3, 16, "11", {}, "[Int, Int]", true, 0, 2, {1, 1}, {0, 8});
+
+    typetable[1] = inttype;
+    typetable[2] = s_treetype;
+    typetable[3] = tupletype;
+    BSQType::g_typetable = typetable;
+
+    s_flavor = new BSQMapTypeFlavor{0, 2, inttype, inttype, tupletype, s_treetype, nullptr};
+}
+
+//check the keys are in order with the expected values, the cached sizes, and the balance at every node -- returns the node count
+static uint64_t checkTree(void* node, int64_t lower, int64_t upper, bool& ok, uint64_t& height)
+{
+    if(node == nullptr)
+    {
+        height = 0;
+        return 0;
+    }
+
+    int64_t key = *((int64_t*)s_treetype->getKeyLocation(node));
+    int64_t value = *((int64_t*)s_treetype->getValueLocation(node));
+    ok &= (lower < key && key < upper && value == key + 1);
+
+    void* l = BSQMapTreeType::getLeft(node);
+    void* r = BSQMapTreeType::getRight(node);
+    ok &= (BSQMapTreeType::isBalanced(l, r) && BSQMapTreeType::isBalanced(r, l));
+
+    uint64_t lheight = 0;
+    uint64_t rheight = 0;
+    uint64_t count = checkTree(l, lower, key, ok, lheight) + checkTree(r, key, upper, ok, rheight) + 1;
+    ok &= (BSQMapTreeType::getSize(node) == count);
+
+    height = std::max(lheight, rheight) + 1;
+    return count;
+}
+
+static bool checkInserts(void** root, size_t count, bool descending)
+{
+    *root = nullptr;
+
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < count; ++i)
+    {
+        int64_t key = descending ? (int64_t)(count - i) : (int64_t)i;
+        int64_t value = key + 1;
+        *root = BSQMapOps::s_add_ne(*s_flavor, *root, s_treetype, &key, &value);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    //every subtree holds at most DELTA / (DELTA + 1) of its parent's weight (size + 1) so the height is bounded by log base 4/3
+    double heightbound = std::ceil(std::log((double)(count + 1)) / std::log((double)(BSQ_MAP_TREE_DELTA + 1) / (double)BSQ_MAP_TREE_DELTA));
+
+    bool ok = true;
+    uint64_t height = 0;
+    uint64_t nodes = checkTree(*root, INT64_MIN, INT64_MAX, ok, height);
+    ok &= (nodes == count && (double)height <= heightbound);
+
+    printf("%s -- %zu %s inserts: height %llu (bound %.0f) %lldms\n", ok ? "ok" : "FAILED", count, descending ? "descending" : "ascending", (unsigned long long)height, heightbound, (long long)std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes = {1, 2, 3, 100, 5000, 1000000};
+    if(argc > 1)
+    {
+        sizes = {(size_t)std::strtoull(argv[1], nullptr, 10)};
+    }
+
+    setupMapTypes();
+
+    void* frame[2] = {nullptr, nullptr};
+    GCStack::pushFrame(frame, "22");
+
+    bool ok = true;
+    for(size_t i = 0; i < sizes.size(); ++i)
+    {
+        ok &= checkInserts(&frame[0], sizes[i], false);
+        ok &= checkInserts(&frame[1], sizes[i], true);
+    }
+
+    GCStack::popFrame();
+
+    return ok ? 0 : 1;
+}
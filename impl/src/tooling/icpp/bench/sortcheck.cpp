@@ -0,0 +1,72 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+//Check (and time) the parallel stable list sort above BSQ_LIST_SORT_PAR_MIN -- lots of duplicate keys so any reordering of equal elements shows up
+//Build with build/bench_build.js and run as sortcheck [size] -- exits with 1 if a result differs from std::stable_sort
+
+#include "../interpreter/collection_eval.h"
+
+#include <chrono>
+#include <random>
+
+struct SortEntry
+{
+    int64_t key;
+    size_t pos;
+};
+
+static bool checkSort(size_t count, size_t nthreads, int64_t keyrange)
+{
+    std::mt19937_64 rng(count + nthreads);
+    std::vector<SortEntry> values(count);
+    for(size_t i = 0; i < count; ++i)
+    {
+        values[i] = SortEntry{(int64_t)(rng() % (uint64_t)keyrange), i};
+    }
+
+    std::vector<StorageLocationPtr> entries(count);
+    for(size_t i = 0; i < count; ++i)
+    {
+        entries[i] = &values[i];
+    }
+    std::vector<StorageLocationPtr> expected = entries;
+
+    auto cmp = [](StorageLocationPtr l, StorageLocationPtr r) {
+        return ((const SortEntry*)l)->key < ((const SortEntry*)r)->key;
+    };
+
+    std::stable_sort(expected.begin(), expected.end(), cmp);
+
+    auto start = std::chrono::steady_clock::now();
+    BSQListOps::par_stable_sort(entries, cmp, nthreads);
+    auto end = std::chrono::steady_clock::now();
+
+    //equal keys must stay in their original order -- so the whole result matches the sequential stable sort
+    bool ok = (entries == expected);
+    printf("%s -- %zu entries %zu threads %lli keys: %lldms\n", ok ? "ok" : "FAILED", count, nthreads, (long long)keyrange, (long long)std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes = {BSQ_LIST_SORT_PAR_MIN, BSQ_LIST_SORT_PAR_MIN + 1, 200003, 1000000};
+    if(argc > 1)
+    {
+        sizes = {(size_t)std::strtoull(argv[1], nullptr, 10)};
+    }
+
+    bool ok = true;
+    for(size_t i = 0; i < sizes.size(); ++i)
+    {
+        for(size_t nthreads = 1; nthreads <= BSQ_LIST_SORT_MAX_THREADS; ++nthreads)
+        {
+            ok &= checkSort(sizes[i], nthreads, 16);
+            ok &= checkSort(sizes[i], nthreads, (int64_t)sizes[i]);
+        }
+    }
+
+    return ok ? 0 : 1;
+}
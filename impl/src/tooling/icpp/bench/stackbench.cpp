@@ -0,0 +1,84 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+//Microbenchmark for the GC frame stack push -- the growable GCStack (a capacity compare and a cold grow path) against the old fixed array with a bound check
+//Build with build/bench_build.js and run as stackbench [rounds] [depth] (depth is capped at the GC frame limit)
+
+#include "../interpreter/runtime/bsqmemory.h"
+
+#include <chrono>
+
+//the pre growable GCStack -- a fixed array of entries with an abort on overflow
+class FixedGCStack
+{
+public:
+    static GCStackEntry frames[2 * BSQ_DEFAULT_MAX_STACK];
+    static uint32_t stackp;
+
+    inline static void pushFrame(void** framep, RefMask mask)
+    {
+        if(FixedGCStack::stackp == 2 * BSQ_DEFAULT_MAX_STACK)
+        {
+            handleStackLimitAbort("GC frame");
+        }
+
+        FixedGCStack::frames[FixedGCStack::stackp++] = { framep, mask };
+    }
+
+    inline static void popFrame()
+    {
+        FixedGCStack::stackp--;
+    }
+};
+
+GCStackEntry FixedGCStack::frames[2 * BSQ_DEFAULT_MAX_STACK];
+uint32_t FixedGCStack::stackp = 0;
+
+//keeps the compiler from dropping the pushes
+static volatile uintptr_t s_sink = 0;
+
+template <typename PUSH, typename POP>
+double timePushes(size_t rounds, uint32_t depth, PUSH push, POP pop)
+{
+    void* frame[4] = { nullptr, nullptr, nullptr, nullptr };
+
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < rounds; ++i)
+    {
+        for(uint32_t j = 0; j < depth; ++j)
+        {
+            push(frame, "2222");
+        }
+        s_sink = s_sink + (uintptr_t)depth;
+
+        for(uint32_t j = 0; j < depth; ++j)
+        {
+            pop();
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    return ns / (double)(rounds * depth);
+}
+
+int main(int argc, char** argv)
+{
+    size_t rounds = (argc > 1) ? (size_t)std::strtoull(argv[1], nullptr, 10) : 20000;
+    uint32_t depth = (argc > 2) ? (uint32_t)std::strtoul(argv[2], nullptr, 10) : 2000;
+    depth = std::min(std::max(depth, (uint32_t)1), GCStack::maxframes - 1);
+
+    //the first round grows the stack from BSQ_INITIAL_STACK up to depth -- time it on its own
+    double growns = timePushes(1, depth, GCStack::pushFrame, GCStack::popFrame);
+
+    double fixedns = timePushes(rounds, depth, FixedGCStack::pushFrame, FixedGCStack::popFrame);
+    double growablens = timePushes(rounds, depth, GCStack::pushFrame, GCStack::popFrame);
+
+    printf("GCStack push (%zu rounds of %u pushes)\n", rounds, depth);
+    printf("  fixed array with bound check: %.2f ns per push\n", fixedns);
+    printf("  growable: %.2f ns per push (first round with the growth %.2f ns per push, capacity %u)\n", growablens, growns, GCStack::capacity);
+
+    return 0;
+}
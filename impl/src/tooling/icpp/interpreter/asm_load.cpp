@@ -4,6 +4,8 @@
 //-------------------------------------------------------------------------------------------------------
 
 #include "asm_load.h"
+#include "asm_opt.h"
+#include "heap_image.h"
 
 const BSQType* jsonLoadBoxedStructType(json v)
 {
@@ -53,7 +55,32 @@ BSQMapTypeFlavor jsonLoadMapFlavor(json v)
 
     const BSQMapTreeType* treetype = dynamic_cast<const BSQMapTreeType*>(BSQType::g_typetable[MarshalEnvironment::g_typenameToIdMap.find(v["treetype"].get<std::string>())->second]);
 
-    return BSQMapTypeFlavor{mtype, mreprtype, keytype, valuetype, tupletype, treetype};   
+    //Maps with a hashable key use the hashed repr (the leaf type has the same K/V layout as the tree node so it is made here)
+    const BSQMapHashLeafType* hashleaftype = nullptr;
+    if(keytype->fpkeyhash != EMPTY_KEY_HASH)
+    {
+        auto lname = BSQMapOps::hashLeafTypeName(v["treetype"].get<std::string>());
+        hashleaftype = new BSQMapHashLeafType(MarshalEnvironment::g_typenameToIdMap.find(lname)->second, treetype, lname);
+        BSQType::g_typetable[hashleaftype->tid] = hashleaftype;
+    }
+
+    return BSQMapTypeFlavor{mtype, mreprtype, keytype, valuetype, tupletype, treetype, hashleaftype};   
+}
+
+void jsonLoadMapHashNodeTypes()
+{
+    for(uint32_t i = 1; i <= BSQ_MAP_HASH_WIDTH; ++i)
+    {
+        auto nname = BSQMapOps::hashNodeTypeName(i);
+
+        std::string maskstr = "1" + std::string(i, '2');
+        auto hmask = (char*)malloc(maskstr.size() + 1);
+        GC_MEM_COPY(hmask, maskstr.c_str(), maskstr.size());
+        hmask[maskstr.size()] = '\0';
+
+        BSQMapOps::g_hashnodetypes[i] = new BSQMapHashNodeType(MarshalEnvironment::g_typenameToIdMap.find(nname)->second, i, hmask, nname);
+        BSQType::g_typetable[BSQMapOps::g_hashnodetypes[i]->tid] = BSQMapOps::g_hashnodetypes[i];
+    }
 }
 
 void initialize(size_t cbuffsize, const RefMask cmask)
@@ -186,7 +213,7 @@ void initializeConst(Evaluator& runner, size_t storageOffset, BSQInvokeID ikey,
     runner.invokeGlobalCons(ccall, Evaluator::g_constantbuffer + storageOffset, gtype, ccall->resultArg);
 }
 
-void loadAssembly(json j, Evaluator& ee)
+void loadAssembly(json j, Evaluator& ee, const std::string& heapimage)
 {
     ////
     //Load the application sources if they are provided
@@ -220,6 +247,17 @@ void loadAssembly(json j, Evaluator& ee)
             MarshalEnvironment::g_typenameToIdMap[tstr] = (BSQTypeID)MarshalEnvironment::g_typenameToIdMap.size();
         }
     });
+
+    //The hashed map node and leaf types are made by the loader (not the emitter) so reserve their ids too
+    for(uint32_t i = 1; i <= BSQ_MAP_HASH_WIDTH; ++i)
+    {
+        MarshalEnvironment::g_typenameToIdMap[BSQMapOps::hashNodeTypeName(i)] = (BSQTypeID)MarshalEnvironment::g_typenameToIdMap.size();
+    }
+
+    auto mflist = j["mapflavors"];
+    std::for_each(mflist.cbegin(), mflist.cend(), [](json fdecl) {
+        MarshalEnvironment::g_typenameToIdMap[BSQMapOps::hashLeafTypeName(fdecl["treetype"].get<std::string>())] = (BSQTypeID)MarshalEnvironment::g_typenameToIdMap.size();
+    });
     
     auto pnlist = j["propertynames"];
     std::for_each(pnlist.cbegin(), pnlist.cend(), [](json pname) {
@@ -256,6 +294,8 @@ void loadAssembly(json j, Evaluator& ee)
     ////
     //Load Types
     BSQType::g_typetable = (const BSQType**)zxalloc(MarshalEnvironment::g_typenameToIdMap.size() * sizeof(const BSQType*));
+    Allocator::GlobalAllocator.initializeTypeSurvival(MarshalEnvironment::g_typenameToIdMap.size());
+
     BSQType::g_typetable[BSQ_TYPE_ID_NONE] = BSQWellKnownType::g_typeNone;
     BSQType::g_typetable[BSQ_TYPE_ID_NOTHING] = BSQWellKnownType::g_typeNothing;
     BSQType::g_typetable[BSQ_TYPE_ID_BOOL] = BSQWellKnownType::g_typeBool;
@@ -300,6 +340,8 @@ void loadAssembly(json j, Evaluator& ee)
         BSQListOps::g_flavormap.emplace(lflavor.entrytype->tid, lflavor);
     });
 
+    jsonLoadMapHashNodeTypes();
+
     auto mflavorlist = j["mapflavors"];
     std::for_each(mflavorlist.cbegin(), mflavorlist.cend(), [](json fdecl) {
         auto mflavor = jsonLoadMapFlavor(fdecl);
@@ -316,14 +358,16 @@ void loadAssembly(json j, Evaluator& ee)
 
     ////
     //Load Literals
+    std::map<uint32_t, const BSQType*> literalslots;
     auto ldlist = j["litdecls"];
-    std::for_each(ldlist.cbegin(), ldlist.cend(), [](json ldecl) {
+    std::for_each(ldlist.cbegin(), ldlist.cend(), [&literalslots](json ldecl) {
         size_t storageOffset;
         const BSQType* gtype; 
         std::string lval;
 
         jsonLoadBSQLiteralDecl(ldecl, storageOffset, gtype, lval);
         initializeLiteral(storageOffset, gtype, lval);
+        literalslots[(uint32_t)storageOffset] = gtype;
     });
 
     ////
@@ -342,14 +386,45 @@ void loadAssembly(json j, Evaluator& ee)
     });
 
     ////
-    //Load Constants
+    //Rewrite the invoke bodies
+    optimizeAssembly(cbuffsize, gmask, literalslots);
+
+    ////
+    //Link the op handlers for dispatch -- must be after any load time rewriting of the invoke bodies
+    ee.linkOpDispatch();
+
+    ////
+    //Load Constants -- from the heap image if there is one for this assembly
+    std::vector<std::pair<BSQInvokeID, HeapImageConstSlot>> constdecls;
     auto cdlist = j["constdecls"];
-    std::for_each(cdlist.cbegin(), cdlist.cend(), [&ee](json ldecl) {
+    std::for_each(cdlist.cbegin(), cdlist.cend(), [&constdecls](json ldecl) {
         size_t storageOffset;
         BSQInvokeID ikey;
         const BSQType* gtype; 
         
         jsonLoadBSQConstantDecl(ldecl, storageOffset, ikey, gtype);
-        initializeConst(ee, storageOffset, ikey, gtype);
+        constdecls.push_back(std::make_pair(ikey, HeapImageConstSlot{storageOffset, gtype}));
+    });
+
+    std::vector<HeapImageConstSlot> constslots;
+    std::transform(constdecls.cbegin(), constdecls.cend(), std::back_inserter(constslots), [](const std::pair<BSQInvokeID, HeapImageConstSlot>& cd) {
+        return cd.second;
     });
+
+    //a stale or damaged image is not loaded -- the initializers run as usual and a fresh image replaces it
+    uint64_t imagekey = !heapimage.empty() ? computeHeapImageKey(j) : 0;
+    if(!heapimage.empty() && loadHeapImage(heapimage, imagekey, constslots, MarshalEnvironment::g_typenameToIdMap.size()))
+    {
+        return;
+    }
+
+    for(size_t i = 0; i < constdecls.size(); ++i)
+    {
+        initializeConst(ee, constdecls[i].second.offset, constdecls[i].first, constdecls[i].second.gtype);
+    }
+
+    if(!heapimage.empty())
+    {
+        saveHeapImage(heapimage, imagekey, constslots);
+    }
 }
@@ -7,4 +7,5 @@
 
 #include "op_eval.h"
 
-void loadAssembly(json j, Evaluator& ee);
+//heapimage is the file the initialized constants are loaded from (or saved to when it is missing or stale) -- empty to always run the initializers
+void loadAssembly(json j, Evaluator& ee, const std::string& heapimage);
@@ -0,0 +1,540 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+#include "asm_opt.h"
+
+//Replace an op that nothing refers to -- it is destructed now (releasing its strings/vectors) and its storage stays in the arena until the body is freed
+void replaceBodyOp(BSQInvokeBodyDecl* idecl, size_t i, InterpOp* nop)
+{
+    delete idecl->body[i];
+    idecl->body[i] = nop;
+}
+
+//Replace an op that the new op keeps a pointer to -- replacedops is its only owner and it is destructed with the body
+void retireBodyOp(BSQInvokeBodyDecl* idecl, size_t i, InterpOp* nop)
+{
+    idecl->replacedops.push_back(idecl->body[i]);
+    idecl->body[i] = nop;
+}
+
+template <OpCodeTag ctag, OpCodeTag ftag>
+InterpOp* tryFuseCompareJumpCond(InterpOp* op, InterpOp* nop)
+{
+    auto cop = static_cast<PrimitiveBinaryCompareOp<ctag>*>(op);
+    auto jop = static_cast<JumpCondOp*>(nop);
+
+    //only when the jump is on the result of the compare
+    if((cop->trgt.kind != jop->arg.kind) || (cop->trgt.offset != jop->arg.location))
+    {
+        return nullptr;
+    }
+
+    return new PrimitiveBinaryCompareJumpCondOp<ftag>(cop->sinfo, cop->trgt, cop->larg, cop->rarg, jop->toffset + 1, jop->foffset + 1, cop);
+}
+
+InterpOp* tryFuseCompare(InterpOp* op, InterpOp* nop)
+{
+    if(nop->tag != OpCodeTag::JumpCondOp)
+    {
+        return nullptr;
+    }
+
+    switch(op->tag)
+    {
+    case OpCodeTag::EqNatOp:
+        return tryFuseCompareJumpCond<OpCodeTag::EqNatOp, OpCodeTag::EqNatJumpCondOp>(op, nop);
+    case OpCodeTag::EqIntOp:
+        return tryFuseCompareJumpCond<OpCodeTag::EqIntOp, OpCodeTag::EqIntJumpCondOp>(op, nop);
+    case OpCodeTag::NeqNatOp:
+        return tryFuseCompareJumpCond<OpCodeTag::NeqNatOp, OpCodeTag::NeqNatJumpCondOp>(op, nop);
+    case OpCodeTag::NeqIntOp:
+        return tryFuseCompareJumpCond<OpCodeTag::NeqIntOp, OpCodeTag::NeqIntJumpCondOp>(op, nop);
+    case OpCodeTag::LtNatOp:
+        return tryFuseCompareJumpCond<OpCodeTag::LtNatOp, OpCodeTag::LtNatJumpCondOp>(op, nop);
+    case OpCodeTag::LtIntOp:
+        return tryFuseCompareJumpCond<OpCodeTag::LtIntOp, OpCodeTag::LtIntJumpCondOp>(op, nop);
+    case OpCodeTag::LeNatOp:
+        return tryFuseCompareJumpCond<OpCodeTag::LeNatOp, OpCodeTag::LeNatJumpCondOp>(op, nop);
+    case OpCodeTag::LeIntOp:
+        return tryFuseCompareJumpCond<OpCodeTag::LeIntOp, OpCodeTag::LeIntJumpCondOp>(op, nop);
+    default:
+        return nullptr;
+    }
+}
+
+InterpOp* tryFuseLoadAssign(InterpOp* op, InterpOp* nop)
+{
+    if(nop->tag != OpCodeTag::DirectAssignOp)
+    {
+        return nullptr;
+    }
+
+    return new LoadEntityFieldDirectAssignOp(op->sinfo, static_cast<LoadEntityFieldDirectOp*>(op), static_cast<DirectAssignOp*>(nop));
+}
+
+bool isVarLifetimeOp(const InterpOp* op)
+{
+    return (op->tag == OpCodeTag::VarLifetimeStartOp) | (op->tag == OpCodeTag::VarLifetimeEndOp);
+}
+
+void fuseSuperInstructions(BSQInvokeBodyDecl* idecl)
+{
+    std::vector<InterpOp*>& body = idecl->body;
+
+    size_t i = 0;
+    while(i + 1 < body.size())
+    {
+        InterpOp* op = body[i];
+        InterpOp* nop = body[i + 1];
+
+        InterpOp* fop = nullptr;
+        size_t width = 2;
+        if(op->tag == OpCodeTag::LoadEntityFieldDirectOp)
+        {
+            fop = tryFuseLoadAssign(op, nop);
+        }
+        else if(isVarLifetimeOp(op) && isVarLifetimeOp(nop))
+        {
+            while(i + width < body.size() && isVarLifetimeOp(body[i + width]))
+            {
+                width++;
+            }
+
+            fop = new VarLifetimeBlockOp(op->sinfo, (uint32_t)width, op);
+        }
+        else
+        {
+            fop = tryFuseCompare(op, nop);
+        }
+
+        if(fop == nullptr)
+        {
+            i++;
+        }
+        else
+        {
+            retireBodyOp(idecl, i, fop);
+            idecl->rwstats.fusedops++;
+
+            i += width;
+        }
+    }
+}
+
+//true if control goes straight from pos to the end of the body (skipping var lifetime ops and jumps to the exit)
+bool isReturnPosition(const std::vector<InterpOp*>& body, size_t pos)
+{
+    while(pos < body.size())
+    {
+        const InterpOp* op = body[pos];
+        if(isVarLifetimeOp(op))
+        {
+            pos++;
+        }
+        else if(op->tag == OpCodeTag::JumpOp && pos + static_cast<const JumpOp*>(op)->offset == body.size())
+        {
+            pos = body.size();
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+InterpOp* tryRewriteSelfTailCall(BSQInvokeBodyDecl* idecl, size_t i)
+{
+    auto iop = static_cast<InvokeFixedFunctionOp*>(idecl->body[i]);
+
+    //guarded calls and calls with optional args do not map onto a plain re-entry of the frame
+    if(iop->invokeId != idecl->ikey || iop->sguard.enabled || iop->optmaskoffset != -1 || iop->args.size() != idecl->params.size())
+    {
+        return nullptr;
+    }
+
+    size_t rpos = i + 1;
+    while(rpos < idecl->body.size() && isVarLifetimeOp(idecl->body[rpos]))
+    {
+        rpos++;
+    }
+
+    if(rpos == idecl->body.size() || idecl->body[rpos]->tag != OpCodeTag::ReturnAssignOp)
+    {
+        return nullptr;
+    }
+
+    auto rop = static_cast<const ReturnAssignOp*>(idecl->body[rpos]);
+    if((rop->arg.kind != iop->trgt.kind) || (rop->arg.location != iop->trgt.offset) || (rop->oftype != iop->trgttype) || !isReturnPosition(idecl->body, rpos + 1))
+    {
+        return nullptr;
+    }
+
+    uint32_t argstagebytes = 0;
+    for(size_t j = 0; j < idecl->paramcopy.size(); ++j)
+    {
+        argstagebytes += idecl->paramcopy[j].bytes;
+    }
+
+    return new InvokeSelfTailCallOp(iop->sinfo, iop, argstagebytes);
+}
+
+void rewriteSelfTailCalls(BSQInvokeBodyDecl* idecl)
+{
+    for(size_t i = 0; i < idecl->body.size(); ++i)
+    {
+        if(idecl->body[i]->tag == OpCodeTag::InvokeFixedFunctionOp)
+        {
+            InterpOp* top = tryRewriteSelfTailCall(idecl, i);
+            if(top != nullptr)
+            {
+                retireBodyOp(idecl, i, top);
+                idecl->rwstats.tailcalls++;
+            }
+        }
+    }
+}
+
+//Literal slots of the constant buffer (these are initialized before the rewrites run so their values can be folded)
+static std::map<uint32_t, const BSQType*> s_literalslots;
+
+//Values for the constant slots created by folding -- appended to the constant buffer (starting at s_foldbase) after all the bodies are rewritten
+static size_t s_foldbase = 0;
+static std::vector<uint64_t> s_foldedslots;
+static std::map<uint64_t, uint32_t> s_foldedslotmap;
+
+template <typename REPRTYPE>
+bool tryLoadLiteralValue(Argument arg, const BSQType* oftype, REPRTYPE& val)
+{
+    if(arg.kind != ArgumentTag::Const)
+    {
+        return false;
+    }
+
+    auto ll = s_literalslots.find(arg.location);
+    if(ll == s_literalslots.cend() || ll->second->tid != oftype->tid)
+    {
+        return false;
+    }
+
+    val = SLPTR_LOAD_CONTENTS_AS(REPRTYPE, Evaluator::g_constantbuffer + arg.location);
+    return true;
+}
+
+template <typename REPRTYPE>
+Argument allocateFoldedConst(REPRTYPE val)
+{
+    uint64_t slot = 0;
+    SLPTR_STORE_CONTENTS_AS(REPRTYPE, (StorageLocationPtr)&slot, val);
+
+    auto fs = s_foldedslotmap.find(slot);
+    if(fs != s_foldedslotmap.cend())
+    {
+        return Argument{ArgumentTag::Const, fs->second};
+    }
+
+    uint32_t location = (uint32_t)(s_foldbase + s_foldedslots.size() * sizeof(uint64_t));
+    s_foldedslots.push_back(slot);
+    s_foldedslotmap[slot] = location;
+
+    return Argument{ArgumentTag::Const, location};
+}
+
+template <typename REPRTYPE, typename RESTYPE>
+InterpOp* tryFoldBinary(InterpOp* op, const BSQType* argtype, const BSQType* restype, std::function<bool(REPRTYPE, REPRTYPE, RESTYPE&)> fn)
+{
+    //operator and compare ops have the same layout
+    auto bop = static_cast<PrimitiveBinaryOperatorOp<OpCodeTag::AddNatOp>*>(op);
+
+    REPRTYPE lval;
+    REPRTYPE rval;
+    if(!tryLoadLiteralValue<REPRTYPE>(bop->larg, argtype, lval) || !tryLoadLiteralValue<REPRTYPE>(bop->rarg, argtype, rval))
+    {
+        return nullptr;
+    }
+
+    //errors (overflow, div by zero) are left for the op to report at runtime
+    RESTYPE res;
+    if(!fn(lval, rval, res))
+    {
+        return nullptr;
+    }
+
+    return new LoadConstOp(op->sinfo, bop->trgt, allocateFoldedConst<RESTYPE>(res), restype);
+}
+
+InterpOp* tryFoldConstantOp(InterpOp* op)
+{
+    const BSQType* tnat = BSQWellKnownType::g_typeNat;
+    const BSQType* tint = BSQWellKnownType::g_typeInt;
+    const BSQType* tbool = BSQWellKnownType::g_typeBool;
+
+    switch(op->tag)
+    {
+    case OpCodeTag::PrefixNotOp:
+    {
+        auto nop = static_cast<PrefixNotOp*>(op);
+        BSQBool bval;
+        if(!tryLoadLiteralValue<BSQBool>(nop->arg, tbool, bval))
+        {
+            return nullptr;
+        }
+        return new LoadConstOp(op->sinfo, nop->trgt, allocateFoldedConst<BSQBool>(!bval), tbool);
+    }
+    case OpCodeTag::AddNatOp:
+        return tryFoldBinary<BSQNat, BSQNat>(op, tnat, tnat, [](BSQNat l, BSQNat r, BSQNat& res) { return !__builtin_add_overflow(l, r, &res); });
+    case OpCodeTag::AddIntOp:
+        return tryFoldBinary<BSQInt, BSQInt>(op, tint, tint, [](BSQInt l, BSQInt r, BSQInt& res) { return !__builtin_add_overflow(l, r, &res); });
+    case OpCodeTag::SubNatOp:
+        return tryFoldBinary<BSQNat, BSQNat>(op, tnat, tnat, [](BSQNat l, BSQNat r, BSQNat& res) { return !__builtin_sub_overflow(l, r, &res); });
+    case OpCodeTag::SubIntOp:
+        return tryFoldBinary<BSQInt, BSQInt>(op, tint, tint, [](BSQInt l, BSQInt r, BSQInt& res) { return !__builtin_sub_overflow(l, r, &res); });
+    case OpCodeTag::MultNatOp:
+        return tryFoldBinary<BSQNat, BSQNat>(op, tnat, tnat, [](BSQNat l, BSQNat r, BSQNat& res) { return !__builtin_mul_overflow(l, r, &res); });
+    case OpCodeTag::MultIntOp:
+        return tryFoldBinary<BSQInt, BSQInt>(op, tint, tint, [](BSQInt l, BSQInt r, BSQInt& res) { return !__builtin_mul_overflow(l, r, &res); });
+    case OpCodeTag::DivNatOp:
+        return tryFoldBinary<BSQNat, BSQNat>(op, tnat, tnat, [](BSQNat l, BSQNat r, BSQNat& res) { res = (r != 0) ? l / r : 0; return r != 0; });
+    case OpCodeTag::DivIntOp:
+        return tryFoldBinary<BSQInt, BSQInt>(op, tint, tint, [](BSQInt l, BSQInt r, BSQInt& res) { bool ok = (r != 0) && !(l == std::numeric_limits<BSQInt>::min() && r == -1); res = ok ? l / r : 0; return ok; });
+    case OpCodeTag::EqNatOp:
+        return tryFoldBinary<BSQNat, BSQBool>(op, tnat, tbool, [](BSQNat l, BSQNat r, BSQBool& res) { res = (l == r); return true; });
+    case OpCodeTag::EqIntOp:
+        return tryFoldBinary<BSQInt, BSQBool>(op, tint, tbool, [](BSQInt l, BSQInt r, BSQBool& res) { res = (l == r); return true; });
+    case OpCodeTag::NeqNatOp:
+        return tryFoldBinary<BSQNat, BSQBool>(op, tnat, tbool, [](BSQNat l, BSQNat r, BSQBool& res) { res = (l != r); return true; });
+    case OpCodeTag::NeqIntOp:
+        return tryFoldBinary<BSQInt, BSQBool>(op, tint, tbool, [](BSQInt l, BSQInt r, BSQBool& res) { res = (l != r); return true; });
+    case OpCodeTag::LtNatOp:
+        return tryFoldBinary<BSQNat, BSQBool>(op, tnat, tbool, [](BSQNat l, BSQNat r, BSQBool& res) { res = (l < r); return true; });
+    case OpCodeTag::LtIntOp:
+        return tryFoldBinary<BSQInt, BSQBool>(op, tint, tbool, [](BSQInt l, BSQInt r, BSQBool& res) { res = (l < r); return true; });
+    case OpCodeTag::LeNatOp:
+        return tryFoldBinary<BSQNat, BSQBool>(op, tnat, tbool, [](BSQNat l, BSQNat r, BSQBool& res) { res = (l <= r); return true; });
+    case OpCodeTag::LeIntOp:
+        return tryFoldBinary<BSQInt, BSQBool>(op, tint, tbool, [](BSQInt l, BSQInt r, BSQBool& res) { res = (l <= r); return true; });
+    default:
+        return nullptr;
+    }
+}
+
+//positions in the body that are the target of some jump
+std::vector<bool> computeJumpTargets(const std::vector<InterpOp*>& body)
+{
+    std::vector<bool> targets(body.size() + 1, false);
+    for(size_t i = 0; i < body.size(); ++i)
+    {
+        const InterpOp* op = body[i];
+        if(op->tag == OpCodeTag::JumpOp)
+        {
+            targets[i + static_cast<const JumpOp*>(op)->offset] = true;
+        }
+        else if(op->tag == OpCodeTag::JumpCondOp)
+        {
+            targets[i + static_cast<const JumpCondOp*>(op)->toffset] = true;
+            targets[i + static_cast<const JumpCondOp*>(op)->foffset] = true;
+        }
+        else if(op->tag == OpCodeTag::JumpNoneOp)
+        {
+            targets[i + static_cast<const JumpNoneOp*>(op)->noffset] = true;
+            targets[i + static_cast<const JumpNoneOp*>(op)->soffset] = true;
+        }
+        else
+        {
+            ;
+        }
+    }
+
+    return targets;
+}
+
+//the guard value of a JumpCondOp if it is a literal or was folded by the op just before it (and no other path jumps in between)
+bool tryGetConstantGuard(const std::vector<InterpOp*>& body, const std::vector<bool>& targets, size_t i, BSQBool& gval)
+{
+    auto jop = static_cast<const JumpCondOp*>(body[i]);
+    if(tryLoadLiteralValue<BSQBool>(jop->arg, BSQWellKnownType::g_typeBool, gval))
+    {
+        return true;
+    }
+
+    if(i == 0 || targets[i] || body[i - 1]->tag != OpCodeTag::LoadConstOp)
+    {
+        return false;
+    }
+
+    auto lop = static_cast<const LoadConstOp*>(body[i - 1]);
+    if((lop->trgt.kind != jop->arg.kind) || (lop->trgt.offset != jop->arg.location) || (lop->oftype->tid != BSQ_TYPE_ID_BOOL) || (lop->arg.location < s_foldbase))
+    {
+        return false;
+    }
+
+    gval = SLPTR_LOAD_CONTENTS_AS(BSQBool, (StorageLocationPtr)&s_foldedslots[(lop->arg.location - s_foldbase) / sizeof(uint64_t)]);
+    return true;
+}
+
+void foldConstants(BSQInvokeBodyDecl* idecl)
+{
+    std::vector<InterpOp*>& body = idecl->body;
+
+    for(size_t i = 0; i < body.size(); ++i)
+    {
+        InterpOp* fop = tryFoldConstantOp(body[i]);
+        if(fop != nullptr)
+        {
+            replaceBodyOp(idecl, i, fop);
+            idecl->rwstats.foldedops++;
+        }
+    }
+
+    //the untaken branch is left in place (unreachable) so the other offsets in the body stay valid
+    std::vector<bool> targets = computeJumpTargets(body);
+    for(size_t i = 0; i < body.size(); ++i)
+    {
+        BSQBool gval;
+        if(body[i]->tag == OpCodeTag::JumpCondOp && tryGetConstantGuard(body, targets, i, gval))
+        {
+            auto jop = static_cast<const JumpCondOp*>(body[i]);
+            replaceBodyOp(idecl, i, gval ? new JumpOp(jop->sinfo, jop->toffset, jop->tlabel) : new JumpOp(jop->sinfo, jop->foffset, jop->flabel));
+            idecl->rwstats.deadbranches++;
+        }
+    }
+}
+
+//key compares on Int/Nat (no unions, no guard) are just the primitive compare ops -- which the fusion pass can then combine with a following JumpCondOp
+InterpOp* trySpecializeKeyCompare(InterpOp* op)
+{
+    if(op->tag == OpCodeTag::BinKeyEqStaticOp)
+    {
+        auto kop = static_cast<BinKeyEqStaticOp*>(op);
+        if(kop->sguard.enabled || kop->argllayout->tid != kop->oftype->tid || kop->argrlayout->tid != kop->oftype->tid)
+        {
+            return nullptr;
+        }
+
+        if(kop->oftype->tid == BSQ_TYPE_ID_NAT)
+        {
+            return new PrimitiveBinaryCompareOp<OpCodeTag::EqNatOp>(kop->sinfo, kop->trgt, kop->oftype, kop->argl, kop->argr);
+        }
+        else if(kop->oftype->tid == BSQ_TYPE_ID_INT)
+        {
+            return new PrimitiveBinaryCompareOp<OpCodeTag::EqIntOp>(kop->sinfo, kop->trgt, kop->oftype, kop->argl, kop->argr);
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+    else if(op->tag == OpCodeTag::BinKeyLessStaticOp)
+    {
+        auto kop = static_cast<BinKeyLessStaticOp*>(op);
+        if(kop->argllayout->tid != kop->oftype->tid || kop->argrlayout->tid != kop->oftype->tid)
+        {
+            return nullptr;
+        }
+
+        if(kop->oftype->tid == BSQ_TYPE_ID_NAT)
+        {
+            return new PrimitiveBinaryCompareOp<OpCodeTag::LtNatOp>(kop->sinfo, kop->trgt, kop->oftype, kop->argl, kop->argr);
+        }
+        else if(kop->oftype->tid == BSQ_TYPE_ID_INT)
+        {
+            return new PrimitiveBinaryCompareOp<OpCodeTag::LtIntOp>(kop->sinfo, kop->trgt, kop->oftype, kop->argl, kop->argr);
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+    else
+    {
+        return nullptr;
+    }
+}
+
+void specializeKeyCompares(BSQInvokeBodyDecl* idecl)
+{
+    for(size_t i = 0; i < idecl->body.size(); ++i)
+    {
+        InterpOp* sop = trySpecializeKeyCompare(idecl->body[i]);
+        if(sop != nullptr)
+        {
+            replaceBodyOp(idecl, i, sop);
+            idecl->rwstats.specializedops++;
+        }
+    }
+}
+
+//copy the constant buffer into one that also holds the folded slots (nothing has a pointer into the buffer until code runs)
+void appendFoldedConstants(size_t cbuffsize, const RefMask cmask)
+{
+    size_t nsize = s_foldbase + s_foldedslots.size() * sizeof(uint64_t);
+    uint8_t* nbuff = (uint8_t*)zxalloc(nsize);
+    GC_MEM_ZERO(nbuff, nsize);
+    GC_MEM_COPY(nbuff, Evaluator::g_constantbuffer, cbuffsize);
+    GC_MEM_COPY(nbuff + s_foldbase, s_foldedslots.data(), s_foldedslots.size() * sizeof(uint64_t));
+
+    size_t cmasklen = strlen(cmask);
+    size_t nmasklen = nsize / sizeof(void*);
+    char* nmask = (char*)malloc(nmasklen + 1);
+    GC_MEM_COPY(nmask, cmask, cmasklen);
+    std::fill(nmask + cmasklen, nmask + nmasklen, PTR_FIELD_MASK_NOP);
+    nmask[nmasklen] = '\0';
+
+    xfree(Evaluator::g_constantbuffer);
+    Evaluator::g_constantbuffer = nbuff;
+    Allocator::GlobalAllocator.setGlobalsMemory(Evaluator::g_constantbuffer, nmask);
+}
+
+void optimizeAssembly(size_t cbuffsize, const RefMask cmask, const std::map<uint32_t, const BSQType*>& literalslots)
+{
+    s_literalslots = literalslots;
+    s_foldbase = std::max(cbuffsize, strlen(cmask) * sizeof(void*));
+    s_foldbase = (s_foldbase + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+
+    for(size_t i = 0; i < BSQInvokeDecl::g_invokes.size(); ++i)
+    {
+        auto invk = BSQInvokeDecl::g_invokes[i];
+        if(invk == nullptr || invk->isPrimitive())
+        {
+            continue;
+        }
+
+        //we own the decls at load time so it is ok to rewrite them here
+        auto idecl = const_cast<BSQInvokeBodyDecl*>(static_cast<const BSQInvokeBodyDecl*>(invk));
+
+        InterpOpArena::g_currentarena = idecl->oparena;
+        foldConstants(idecl);
+        specializeKeyCompares(idecl);
+        rewriteSelfTailCalls(idecl);
+        fuseSuperInstructions(idecl);
+        InterpOpArena::g_currentarena = nullptr;
+    }
+
+    if(!s_foldedslots.empty())
+    {
+        appendFoldedConstants(cbuffsize, cmask);
+    }
+}
+
+void displayRewriteStats(FILE* fp)
+{
+    for(size_t i = 0; i < BSQInvokeDecl::g_invokes.size(); ++i)
+    {
+        auto invk = BSQInvokeDecl::g_invokes[i];
+        if(invk == nullptr || invk->isPrimitive())
+        {
+            continue;
+        }
+
+        auto idecl = static_cast<const BSQInvokeBodyDecl*>(invk);
+        const BSQInvokeRewriteStats& rws = idecl->rwstats;
+        if((rws.foldedops | rws.deadbranches | rws.specializedops | rws.fusedops | rws.tailcalls) != 0)
+        {
+            fprintf(fp, "%s -- ops: %i folded: %i deadbranches: %i specialized: %i fused: %i tailcalls: %i\n", idecl->name.c_str(), (int)idecl->body.size(), (int)rws.foldedops, (int)rws.deadbranches, (int)rws.specializedops, (int)rws.fusedops, (int)rws.tailcalls);
+        }
+    }
+    fflush(fp);
+}
@@ -0,0 +1,14 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "op_eval.h"
+
+//Load time rewriting of the invoke bodies -- run after the invokes and literals are loaded but before the ops are linked for dispatch and any code runs
+//literalslots are the (offset, type) of the literals in the constant buffer -- ops on these are folded into new slots appended to the buffer
+void optimizeAssembly(size_t cbuffsize, const RefMask cmask, const std::map<uint32_t, const BSQType*>& literalslots);
+
+void displayRewriteStats(FILE* fp);
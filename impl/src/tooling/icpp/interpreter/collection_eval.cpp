@@ -5,41 +5,39 @@
 
 #include "collection_eval.h"
 
+//Lambda args are the leading temp locations followed by the captured args -- all in stack space so the per-element calls never touch the heap
+#define BI_LAMBDA_CALL_SETUP_ARGS(PARAMS, PC, LPARAMS, ...) StorageLocationPtr LPARAMS##_lead[] = {__VA_ARGS__}; \
+        size_t LPARAMS##_leadcount = sizeof(LPARAMS##_lead) / sizeof(StorageLocationPtr); \
+        StorageLocationPtr* LPARAMS##_data = (StorageLocationPtr*)BSQ_STACK_SPACE_ALLOC((LPARAMS##_leadcount + PC->cargpos.size()) * sizeof(StorageLocationPtr)); \
+        std::copy(LPARAMS##_lead, LPARAMS##_lead + LPARAMS##_leadcount, LPARAMS##_data); \
+        std::transform(PC->cargpos.cbegin(), PC->cargpos.cend(), LPARAMS##_data + LPARAMS##_leadcount, [&PARAMS](uint32_t pos) { \
+            return PARAMS[pos]; \
+        }); \
+        StorageLocationSpan LPARAMS(LPARAMS##_data, LPARAMS##_leadcount + PC->cargpos.size());
+
 #define BI_LAMBDA_CALL_SETUP_TEMP(TTYPE, TEMPSL, PARAMS, PC, LPARAMS) uint8_t* TEMPSL = (uint8_t*)BSQ_STACK_SPACE_ALLOC(TTYPE->allocinfo.inlinedatasize); \
         GC_MEM_ZERO(TEMPSL, TTYPE->allocinfo.inlinedatasize); \
         GCStack::pushFrame((void**)TEMPSL, TTYPE->allocinfo.inlinedmask); \
-        std::vector<StorageLocationPtr> LPARAMS = {TEMPSL}; \
-        std::transform(PC->cargpos.cbegin(), PC->cargpos.cend(), std::back_inserter(LPARAMS), [&PARAMS](uint32_t pos) { \
-            return PARAMS[pos]; \
-        });
+        BI_LAMBDA_CALL_SETUP_ARGS(PARAMS, PC, LPARAMS, TEMPSL)
 
 #define BI_LAMBDA_CALL_SETUP_TEMP_IDX(TTYPE, TEMPSL, PARAMS, PC, LPARAMS, IDXSL) uint8_t* TEMPSL = (uint8_t*)BSQ_STACK_SPACE_ALLOC(TTYPE->allocinfo.inlinedatasize); \
         GC_MEM_ZERO(TEMPSL, TTYPE->allocinfo.inlinedatasize); \
         GCStack::pushFrame((void**)TEMPSL, TTYPE->allocinfo.inlinedmask); \
-        std::vector<StorageLocationPtr> LPARAMS = {TEMPSL, IDXSL}; \
-        std::transform(PC->cargpos.cbegin(), PC->cargpos.cend(), std::back_inserter(LPARAMS), [&PARAMS](uint32_t pos) { \
-            return PARAMS[pos]; \
-        });
+        BI_LAMBDA_CALL_SETUP_ARGS(PARAMS, PC, LPARAMS, TEMPSL, IDXSL)
 
 #define BI_LAMBDA_CALL_SETUP_TEMP_AND_RES_VECTOR(TTYPE, TEMPSL, RTYPE, RESSL, PARAMS, PC, LPARAMS) uint8_t* TEMPSL = (uint8_t*)BSQ_STACK_SPACE_ALLOC(TTYPE->allocinfo.inlinedatasize + RTYPE->allocinfo.heapsize); \
         uint8_t* RESSL = TEMPSL + TTYPE->allocinfo.inlinedatasize; \
         GC_MEM_ZERO(TEMPSL, TTYPE->allocinfo.inlinedatasize + RTYPE->allocinfo.heapsize); \
         std::string msk = std::string(TTYPE->allocinfo.inlinedmask) + std::string(RTYPE->allocinfo.heapmask != nullptr ? RTYPE->allocinfo.heapmask : ""); \
         GCStack::pushFrame((void**)TEMPSL, msk.c_str()); \
-        std::vector<StorageLocationPtr> LPARAMS = {TEMPSL}; \
-        std::transform(PC->cargpos.cbegin(), PC->cargpos.cend(), std::back_inserter(LPARAMS), [&PARAMS](uint32_t pos) { \
-            return PARAMS[pos]; \
-        });
+        BI_LAMBDA_CALL_SETUP_ARGS(PARAMS, PC, LPARAMS, TEMPSL)
 
 #define BI_LAMBDA_CALL_SETUP_TEMP_AND_RES_VECTOR_IDX(TTYPE, TEMPSL, RTYPE, RESSL, PARAMS, PC, LPARAMS, IDXSL) uint8_t* TEMPSL = (uint8_t*)BSQ_STACK_SPACE_ALLOC(TTYPE->allocinfo.inlinedatasize + RTYPE->allocinfo.heapsize); \
         uint8_t* RESSL = TEMPSL + TTYPE->allocinfo.inlinedatasize; \
         GC_MEM_ZERO(TEMPSL, TTYPE->allocinfo.inlinedatasize + RTYPE->allocinfo.heapsize); \
         std::string msk = std::string(TTYPE->allocinfo.inlinedmask) + std::string(RTYPE->allocinfo.heapmask != nullptr ? RTYPE->allocinfo.heapmask : ""); \
         GCStack::pushFrame((void**)TEMPSL, msk.c_str()); \
-        std::vector<StorageLocationPtr> LPARAMS = {TEMPSL, IDXSL}; \
-        std::transform(PC->cargpos.cbegin(), PC->cargpos.cend(), std::back_inserter(LPARAMS), [&PARAMS](uint32_t pos) { \
-            return PARAMS[pos]; \
-        });
+        BI_LAMBDA_CALL_SETUP_ARGS(PARAMS, PC, LPARAMS, TEMPSL, IDXSL)
 
 #define BI_LAMBDA_CALL_SETUP_TEMP_X2_AND_RES(TTYPE1, TEMPSL1, TTYPE2, TEMPSL2, RTYPE, RESSL, PARAMS, PC, LPARAMS) uint8_t* TEMPSL1 = (uint8_t*)BSQ_STACK_SPACE_ALLOC(TTYPE1->allocinfo.inlinedatasize + TTYPE2->allocinfo.inlinedatasize + RTYPE->allocinfo.inlinedatasize); \
         uint8_t* TEMPSL2 = TEMPSL1 + TTYPE1->allocinfo.inlinedatasize; \
@@ -47,26 +45,17 @@
         GC_MEM_ZERO(TEMPSL1, TTYPE1->allocinfo.inlinedatasize + TTYPE2->allocinfo.inlinedatasize + RTYPE->allocinfo.inlinedatasize); \
         std::string msk = std::string(TTYPE1->allocinfo.inlinedmask) + std::string(TTYPE2->allocinfo.inlinedmask) + std::string(RTYPE->allocinfo.inlinedmask); \
         GCStack::pushFrame((void**)TEMPSL1, msk.c_str()); \
-        std::vector<StorageLocationPtr> LPARAMS = {TEMPSL1, TEMPSL2}; \
-        std::transform(PC->cargpos.cbegin(), PC->cargpos.cend(), std::back_inserter(LPARAMS), [&PARAMS](uint32_t pos) { \
-            return PARAMS[pos]; \
-        });
+        BI_LAMBDA_CALL_SETUP_ARGS(PARAMS, PC, LPARAMS, TEMPSL1, TEMPSL2)
 
 #define BI_LAMBDA_CALL_SETUP_REDUCE(TTYPE, TEMPSL, PARAMS, PC, LPARAMS, RSL) uint8_t* TEMPSL = (uint8_t*)BSQ_STACK_SPACE_ALLOC(TTYPE->allocinfo.inlinedatasize); \
         GC_MEM_ZERO(TEMPSL, TTYPE->allocinfo.inlinedatasize); \
         GCStack::pushFrame((void**)TEMPSL, TTYPE->allocinfo.inlinedmask); \
-        std::vector<StorageLocationPtr> LPARAMS = {RSL, TEMPSL}; \
-        std::transform(PC->cargpos.cbegin(), PC->cargpos.cend(), std::back_inserter(LPARAMS), [&PARAMS](uint32_t pos) { \
-            return PARAMS[pos]; \
-        }); 
+        BI_LAMBDA_CALL_SETUP_ARGS(PARAMS, PC, LPARAMS, RSL, TEMPSL)
 
 #define BI_LAMBDA_CALL_SETUP_REDUCE_IDX(TTYPE, TEMPSL, PARAMS, PC, LPARAMS, RSL, POS) uint8_t* TEMPSL = (uint8_t*)BSQ_STACK_SPACE_ALLOC(TTYPE->allocinfo.inlinedatasize); \
         GC_MEM_ZERO(TEMPSL, TTYPE->allocinfo.inlinedatasize); \
         GCStack::pushFrame((void**)TEMPSL, TTYPE->allocinfo.inlinedmask); \
-        std::vector<StorageLocationPtr> LPARAMS = {RSL, TEMPSL, POS}; \
-        std::transform(PC->cargpos.cbegin(), PC->cargpos.cend(), std::back_inserter(LPARAMS), [&PARAMS](uint32_t pos) { \
-            return PARAMS[pos]; \
-        });
+        BI_LAMBDA_CALL_SETUP_ARGS(PARAMS, PC, LPARAMS, RSL, TEMPSL, POS)
 
 #define BI_LAMBDA_CALL_SETUP_TRANSDUCE(TTYPE, TEMPSL, RLTYPE, RSL, ENVTYPE, ENVSL, TYPEOUT, OUTSL, PARAMS, PC, LPARAMS) uint8_t* TEMPSL = (uint8_t*)BSQ_STACK_SPACE_ALLOC(TTYPE->allocinfo.inlinedatasize + ENVTYPE->allocinfo.inlinedatasize + TYPEOUT->allocinfo.inlinedatasize + RLTYPE->allocinfo.heapsize); \
         uint8_t* ENVSL = TEMPSL + TTYPE->allocinfo.inlinedatasize; \
@@ -75,10 +64,7 @@
         GC_MEM_ZERO(TEMPSL, TTYPE->allocinfo.inlinedatasize + ENVTYPE->allocinfo.inlinedatasize + RLTYPE->allocinfo.heapsize); \
         std::string msk = std::string(TTYPE->allocinfo.inlinedmask) + std::string(ENVTYPE->allocinfo.inlinedmask) + std::string(TYPEOUT->allocinfo.inlinedmask) + std::string(RLTYPE->allocinfo.inlinedmask); \
         GCStack::pushFrame((void**)TEMPSL, msk.c_str()); \
-        std::vector<StorageLocationPtr> LPARAMS = {ENVSL, TEMPSL}; \
-        std::transform(PC->cargpos.cbegin(), PC->cargpos.cend(), std::back_inserter(LPARAMS), [&PARAMS](uint32_t pos) { \
-            return PARAMS[pos]; \
-        }); 
+        BI_LAMBDA_CALL_SETUP_ARGS(PARAMS, PC, LPARAMS, ENVSL, TEMPSL)
 
 #define BI_LAMBDA_CALL_SETUP_TRANSDUCE_IDX(TTYPE, TEMPSL, RLTYPE, RSL, ENVTYPE, ENVSL, TYPEOUT, OUTSL, PARAMS, PC, LPARAMS, POS) uint8_t* TEMPSL = (uint8_t*)BSQ_STACK_SPACE_ALLOC(TTYPE->allocinfo.inlinedatasize + ENVTYPE->allocinfo.inlinedatasize + TYPEOUT->allocinfo.inlinedatasize + RLTYPE->allocinfo.heapsize); \
         uint8_t* ENVSL = TEMPSL + TTYPE->allocinfo.inlinedatasize; \
@@ -87,20 +73,14 @@
         GC_MEM_ZERO(TEMPSL, TTYPE->allocinfo.inlinedatasize + ENVTYPE->allocinfo.inlinedatasize + RLTYPE->allocinfo.heapsize); \
         std::string msk = std::string(TTYPE->allocinfo.inlinedmask) + std::string(ENVTYPE->allocinfo.inlinedmask) + std::string(TYPEOUT->allocinfo.inlinedmask) + std::string(RLTYPE->allocinfo.heapmask != nullptr ? RLTYPE->allocinfo.heapmask : ""); \
         GCStack::pushFrame((void**)TEMPSL, msk.c_str()); \
-        std::vector<StorageLocationPtr> LPARAMS = {ENVSL, TEMPSL, POS}; \
-        std::transform(PC->cargpos.cbegin(), PC->cargpos.cend(), std::back_inserter(LPARAMS), [&PARAMS](uint32_t pos) { \
-            return PARAMS[pos]; \
-        }); 
+        BI_LAMBDA_CALL_SETUP_ARGS(PARAMS, PC, LPARAMS, ENVSL, TEMPSL, POS)
 
 #define BI_LAMBDA_CALL_SETUP_TEMP_X2_CMP(TTYPE1, TEMPSL1, TTYPE2, TEMPSL2, PARAMS, PC, LPARAMS) uint8_t* TEMPSL1 = (uint8_t*)BSQ_STACK_SPACE_ALLOC(TTYPE1->allocinfo.inlinedatasize + TTYPE2->allocinfo.inlinedatasize); \
         uint8_t* TEMPSL2 = TEMPSL1 + TTYPE1->allocinfo.inlinedatasize; \
         GC_MEM_ZERO(TEMPSL1, TTYPE1->allocinfo.inlinedatasize + TTYPE2->allocinfo.inlinedatasize); \
         std::string msk = std::string(TTYPE1->allocinfo.inlinedmask) + std::string(TTYPE2->allocinfo.inlinedmask); \
         GCStack::pushFrame((void**)TEMPSL1, msk.c_str()); \
-        std::vector<StorageLocationPtr> LPARAMS = {TEMPSL1, TEMPSL2}; \
-        std::transform(PC->cargpos.cbegin(), PC->cargpos.cend(), std::back_inserter(LPARAMS), [&PARAMS](uint32_t pos) { \
-            return PARAMS[pos]; \
-        });
+        BI_LAMBDA_CALL_SETUP_ARGS(PARAMS, PC, LPARAMS, TEMPSL1, TEMPSL2)
 
 
 #define BI_LAMBDA_CALL_SETUP_KV_TEMP(KTYPE, KTEMPSL, VTYPE, VTEMPSL, PARAMS, PC, LPARAMS) uint8_t* KTEMPSL = (uint8_t*)BSQ_STACK_SPACE_ALLOC(KTYPE->allocinfo.inlinedatasize + VTYPE->allocinfo.inlinedatasize); \
@@ -108,10 +88,7 @@
         GC_MEM_ZERO(KTEMPSL, KTYPE->allocinfo.inlinedatasize + VTYPE->allocinfo.inlinedatasize); \
         std::string msk = std::string(KTYPE->allocinfo.inlinedmask) + std::string(VTYPE->allocinfo.inlinedmask); \
         GCStack::pushFrame((void**)KTEMPSL, msk.c_str()); \
-        std::vector<StorageLocationPtr> LPARAMS = {KTEMPSL, VTEMPSL}; \
-        std::transform(PC->cargpos.cbegin(), PC->cargpos.cend(), std::back_inserter(LPARAMS), [&PARAMS](uint32_t pos) { \
-            return PARAMS[pos]; \
-        });
+        BI_LAMBDA_CALL_SETUP_ARGS(PARAMS, PC, LPARAMS, KTEMPSL, VTEMPSL)
 
 #define BI_LAMBDA_CALL_SETUP_KV_TEMP_AND_RES(KTYPE, KTEMPSL, VTYPE, VTEMPSL, RTYPE, RESSL, PARAMS, PC, LPARAMS) uint8_t* KTEMPSL = (uint8_t*)BSQ_STACK_SPACE_ALLOC(KTYPE->allocinfo.inlinedatasize + VTYPE->allocinfo.inlinedatasize + RTYPE->allocinfo.inlinedatasize); \
         uint8_t* VTEMPSL = KTEMPSL + KTYPE->allocinfo.inlinedatasize; \
@@ -119,10 +96,7 @@
         GC_MEM_ZERO(KTEMPSL, KTYPE->allocinfo.inlinedatasize + VTYPE->allocinfo.inlinedatasize + RTYPE->allocinfo.inlinedatasize); \
         std::string msk = std::string(KTYPE->allocinfo.inlinedmask) + std::string(VTYPE->allocinfo.inlinedmask) + std::string(RTYPE->allocinfo.inlinedmask); \
         GCStack::pushFrame((void**)KTEMPSL, msk.c_str()); \
-        std::vector<StorageLocationPtr> LPARAMS = {KTEMPSL, VTEMPSL}; \
-        std::transform(PC->cargpos.cbegin(), PC->cargpos.cend(), std::back_inserter(LPARAMS), [&PARAMS](uint32_t pos) { \
-            return PARAMS[pos]; \
-        });
+        BI_LAMBDA_CALL_SETUP_ARGS(PARAMS, PC, LPARAMS, KTEMPSL, VTEMPSL)
 
 #define BI_LAMBDA_CALL_SETUP_CLEAR_TEMP_PV(PVTYPE, PVL) GC_MEM_ZERO(PVL, PVTYPE->allocinfo.heapsize)
 
@@ -139,14 +113,14 @@ void BSQListOps::s_range_ne(const BSQType* oftype, StorageLocationPtr start, Sto
     if(oftype->tid == BSQ_TYPE_ID_INT)
     {
         auto ll = BSQListOps::s_range_ne_rec<BSQInt>(BSQListOps::g_flavormap.find(BSQ_TYPE_ID_INT)->second, SLPTR_LOAD_CONTENTS_AS(BSQInt, start), SLPTR_LOAD_CONTENTS_AS(BSQInt, count));
-        LIST_STORE_RESULT_REPR(res, ll.first);
+        LIST_STORE_RESULT_REPR(ll.first, res);
     }
     else
     {
         assert(oftype->tid == BSQ_TYPE_ID_NAT);
 
         auto ll = BSQListOps::s_range_ne_rec<BSQNat>(BSQListOps::g_flavormap.find(BSQ_TYPE_ID_NAT)->second, SLPTR_LOAD_CONTENTS_AS(BSQNat, start), SLPTR_LOAD_CONTENTS_AS(BSQNat, count));
-        LIST_STORE_RESULT_REPR(res, ll.first);
+        LIST_STORE_RESULT_REPR(ll.first, res);
     }
     Allocator::GlobalAllocator.resetCollectionNodeEnd(gcpoint);
 }
@@ -156,11 +130,135 @@ void BSQListOps::s_fill_ne(const BSQType* oftype, StorageLocationPtr val, Storag
     auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
 
     auto ll = BSQListOps::s_fill_ne_rec(BSQListOps::g_flavormap.find(oftype->tid)->second, val, SLPTR_LOAD_CONTENTS_AS(BSQNat, count));
-    LIST_STORE_RESULT_REPR(res, ll);
+    LIST_STORE_RESULT_REPR(ll, res);
     
     Allocator::GlobalAllocator.resetCollectionNodeEnd(gcpoint);
 }
 
+//Every join reserves this much per level it descends (the copied node plus up to 2 more from a double rotation) and a leaf for merging at the bottom
+#define LIST_TREE_LEVEL_ALLOC(LFLAVOR) (3 * ((LFLAVOR).treetype->allocinfo.heapsize + sizeof(GC_META_DATA_WORD)))
+#define LIST_TREE_LEAF_ALLOC(LFLAVOR) (std::max((LFLAVOR).pv8type->allocinfo.heapsize, (LFLAVOR).treetype->allocinfo.heapsize) + sizeof(GC_META_DATA_WORD))
+
+void* s_list_node_ne(const BSQListTypeFlavor& lflavor, void* l, void* r)
+{
+    BSQListTreeRepr* res = (BSQListTreeRepr*)Allocator::GlobalAllocator.allocateSafe(lflavor.treetype);
+    res->l = l;
+    res->r = r;
+    res->size = BSQListTreeType::getSize(l) + BSQListTreeType::getSize(r);
+
+    return res;
+}
+
+//Build the node over l and r with a single or double rotation if one side got too heavy -- the lighter inner subtree may be a leaf and then only the single rotation is possible
+void* s_list_balance_ne(const BSQListTypeFlavor& lflavor, void* l, void* r)
+{
+    if(!BSQListTreeType::isBalanced(l, r) && BSQListTreeType::isTree(r))
+    {
+        void* rl = static_cast<BSQListTreeRepr*>(r)->l;
+        void* rr = static_cast<BSQListTreeRepr*>(r)->r;
+        if(BSQListTreeType::isSingleRotation(rl, rr) || !BSQListTreeType::isTree(rl))
+        {
+            return s_list_node_ne(lflavor, s_list_node_ne(lflavor, l, rl), rr);
+        }
+        else
+        {
+            return s_list_node_ne(lflavor, s_list_node_ne(lflavor, l, static_cast<BSQListTreeRepr*>(rl)->l), s_list_node_ne(lflavor, static_cast<BSQListTreeRepr*>(rl)->r, rr));
+        }
+    }
+    else if(!BSQListTreeType::isBalanced(r, l) && BSQListTreeType::isTree(l))
+    {
+        void* ll = static_cast<BSQListTreeRepr*>(l)->l;
+        void* lr = static_cast<BSQListTreeRepr*>(l)->r;
+        if(BSQListTreeType::isSingleRotation(lr, ll) || !BSQListTreeType::isTree(lr))
+        {
+            return s_list_node_ne(lflavor, ll, s_list_node_ne(lflavor, lr, r));
+        }
+        else
+        {
+            return s_list_node_ne(lflavor, s_list_node_ne(lflavor, ll, static_cast<BSQListTreeRepr*>(lr)->l), s_list_node_ne(lflavor, static_cast<BSQListTreeRepr*>(lr)->r, r));
+        }
+    }
+    else
+    {
+        return s_list_node_ne(lflavor, l, r);
+    }
+}
+
+//Number of levels s_list_join_ne goes down the spine of the heavier side before l and r are balanced
+size_t s_list_join_depth(void* l, void* r)
+{
+    size_t depth = 0;
+    while(true)
+    {
+        if(BSQListTreeType::isTree(l) && !BSQListTreeType::isBalanced(r, l))
+        {
+            l = static_cast<BSQListTreeRepr*>(l)->r;
+        }
+        else if(BSQListTreeType::isTree(r) && !BSQListTreeType::isBalanced(l, r))
+        {
+            r = static_cast<BSQListTreeRepr*>(r)->l;
+        }
+        else
+        {
+            return depth;
+        }
+        depth++;
+    }
+}
+
+//Join down the inner spine of the heavier side and rebalance on the way up -- adjacent leaves that fit in a pv8 are merged so appending single elements keeps the leaves full
+void* s_list_join_ne(const BSQListTypeFlavor& lflavor, void* l, void* r)
+{
+    if(BSQListTreeType::isTree(l) && !BSQListTreeType::isBalanced(r, l))
+    {
+        auto trepr = static_cast<BSQListTreeRepr*>(l);
+        return s_list_balance_ne(lflavor, trepr->l, s_list_join_ne(lflavor, trepr->r, r));
+    }
+    else if(BSQListTreeType::isTree(r) && !BSQListTreeType::isBalanced(l, r))
+    {
+        auto trepr = static_cast<BSQListTreeRepr*>(r);
+        return s_list_balance_ne(lflavor, s_list_join_ne(lflavor, l, trepr->l), trepr->r);
+    }
+    else if(!BSQListTreeType::isTree(l) && !BSQListTreeType::isTree(r) && (BSQPartialVectorType::getPVCount(l) + BSQPartialVectorType::getPVCount(r) <= 8))
+    {
+        auto count = BSQPartialVectorType::getPVCount(l) + BSQPartialVectorType::getPVCount(r);
+
+        void* res = Allocator::GlobalAllocator.allocateSafe((count <= 4) ? lflavor.pv4type : lflavor.pv8type);
+        BSQPartialVectorType::appendPVData(res, l, lflavor.entrytype->allocinfo.inlinedatasize);
+        BSQPartialVectorType::appendPVData(res, r, lflavor.entrytype->allocinfo.inlinedatasize);
+
+        return res;
+    }
+    else
+    {
+        return s_list_node_ne(lflavor, l, r);
+    }
+}
+
+void* BSQListOps::list_append(const BSQListTypeFlavor& lflavor, void* l, void* r)
+{
+    if(l == nullptr)
+    {
+        return r;
+    }
+    else if(r == nullptr)
+    {
+        return l;
+    }
+    else
+    {
+        auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
+        auto lnode = Allocator::GlobalAllocator.registerCollectionNode(l);
+        auto rnode = Allocator::GlobalAllocator.registerCollectionNode(r);
+
+        Allocator::GlobalAllocator.ensureSpace((s_list_join_depth(l, r) * LIST_TREE_LEVEL_ALLOC(lflavor)) + LIST_TREE_LEAF_ALLOC(lflavor));
+        void* res = s_list_join_ne(lflavor, lnode->repr, rnode->repr);
+
+        Allocator::GlobalAllocator.resetCollectionNodeEnd(gcpoint);
+        return res;
+    }
+}
+
 void* BSQListOps::s_reverse_ne(const BSQListTypeFlavor& lflavor, BSQCollectionGCReprNode* reprnode)
 {
     auto reprtype = static_cast<const BSQListReprType*>(GET_TYPE_META_DATA(reprnode->repr));
@@ -203,7 +301,79 @@ void* BSQListOps::s_reverse_ne(const BSQListTypeFlavor& lflavor, BSQCollectionGC
     return res;
 }
 
-BSQNat BSQListOps::s_find_pred_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, const std::vector<StorageLocationPtr>& params)
+void* BSQListOps::s_slice_start_ne(const BSQListTypeFlavor& lflavor, BSQCollectionGCReprNode* reprnode, BSQNat start)
+{
+    if(start == 0)
+    {
+        return reprnode->repr;
+    }
+
+    void* res = nullptr;
+    if(!BSQListTreeType::isTree(reprnode->repr))
+    {
+        auto count = BSQPartialVectorType::getPVCount(reprnode->repr);
+
+        res = Allocator::GlobalAllocator.allocateDynamic(((count - (int16_t)start) <= 4) ? lflavor.pv4type : lflavor.pv8type);
+        BSQPartialVectorType::slicePVData(res, reprnode->repr, (int16_t)start, count, lflavor.entrytype->allocinfo.inlinedatasize);
+    }
+    else
+    {
+        auto llcount = BSQListTreeType::getSize(static_cast<BSQListTreeRepr*>(reprnode->repr)->l);
+
+        auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
+        if(start < llcount)
+        {
+            auto lnode = Allocator::GlobalAllocator.registerCollectionNode(static_cast<BSQListTreeRepr*>(reprnode->repr)->l);
+            auto ll = BSQListOps::s_slice_start_ne(lflavor, lnode, start);
+
+            res = BSQListOps::list_append(lflavor, ll, static_cast<BSQListTreeRepr*>(reprnode->repr)->r);
+        }
+        else
+        {
+            auto rnode = Allocator::GlobalAllocator.registerCollectionNode(static_cast<BSQListTreeRepr*>(reprnode->repr)->r);
+            res = BSQListOps::s_slice_start_ne(lflavor, rnode, start - llcount);
+        }
+        Allocator::GlobalAllocator.resetCollectionNodeEnd(gcpoint);
+    }
+    return res;
+}
+
+void* BSQListOps::s_slice_end_ne(const BSQListTypeFlavor& lflavor, BSQCollectionGCReprNode* reprnode, BSQNat end)
+{
+    if(end == BSQListTreeType::getSize(reprnode->repr))
+    {
+        return reprnode->repr;
+    }
+
+    void* res = nullptr;
+    if(!BSQListTreeType::isTree(reprnode->repr))
+    {
+        res = Allocator::GlobalAllocator.allocateDynamic((end <= 4) ? lflavor.pv4type : lflavor.pv8type);
+        BSQPartialVectorType::slicePVData(res, reprnode->repr, 0, (int16_t)end, lflavor.entrytype->allocinfo.inlinedatasize);
+    }
+    else
+    {
+        auto llcount = BSQListTreeType::getSize(static_cast<BSQListTreeRepr*>(reprnode->repr)->l);
+
+        auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
+        if(end > llcount)
+        {
+            auto rnode = Allocator::GlobalAllocator.registerCollectionNode(static_cast<BSQListTreeRepr*>(reprnode->repr)->r);
+            auto rr = BSQListOps::s_slice_end_ne(lflavor, rnode, end - llcount);
+
+            res = BSQListOps::list_append(lflavor, static_cast<BSQListTreeRepr*>(reprnode->repr)->l, rr);
+        }
+        else
+        {
+            auto lnode = Allocator::GlobalAllocator.registerCollectionNode(static_cast<BSQListTreeRepr*>(reprnode->repr)->l);
+            res = BSQListOps::s_slice_end_ne(lflavor, lnode, end);
+        }
+        Allocator::GlobalAllocator.resetCollectionNodeEnd(gcpoint);
+    }
+    return res;
+}
+
+BSQNat BSQListOps::s_find_pred_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, StorageLocationSpan params)
 {
     int64_t pos = 0;
 
@@ -238,7 +408,7 @@ BSQNat BSQListOps::s_find_pred_ne(LambdaEvalThunk ee, void* t, const BSQListRepr
     return (BSQNat)pos;
 }
 
-BSQNat BSQListOps::s_find_pred_idx_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, const std::vector<StorageLocationPtr>& params)
+BSQNat BSQListOps::s_find_pred_idx_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, StorageLocationSpan params)
 {
     int64_t pos = 0;
 
@@ -273,7 +443,7 @@ BSQNat BSQListOps::s_find_pred_idx_ne(LambdaEvalThunk ee, void* t, const BSQList
     return (BSQNat)pos;
 }
 
-BSQNat BSQListOps::s_find_pred_last_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, const std::vector<StorageLocationPtr>& params)
+BSQNat BSQListOps::s_find_pred_last_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, StorageLocationSpan params)
 {
     int64_t icount = ttype->getCount(t);
     int64_t pos = icount - 1;
@@ -309,7 +479,7 @@ BSQNat BSQListOps::s_find_pred_last_ne(LambdaEvalThunk ee, void* t, const BSQLis
     return (BSQNat)(pos != -1 ? pos : icount);
 }
 
-BSQNat BSQListOps::s_find_pred_last_idx_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, const std::vector<StorageLocationPtr>& params)
+BSQNat BSQListOps::s_find_pred_last_idx_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, StorageLocationSpan params)
 {
     int64_t icount = ttype->getCount(t);
     int64_t pos = icount - 1;
@@ -345,7 +515,7 @@ BSQNat BSQListOps::s_find_pred_last_idx_ne(LambdaEvalThunk ee, void* t, const BS
     return (BSQNat)(pos != -1 ? pos : icount);
 }
 
-void* BSQListOps::s_filter_pred_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, const std::vector<StorageLocationPtr>& params)
+void* BSQListOps::s_filter_pred_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, StorageLocationSpan params)
 {
     auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
     auto rnode = Allocator::GlobalAllocator.registerCollectionNode(static_cast<BSQListTreeRepr*>(t));
@@ -389,7 +559,7 @@ void* BSQListOps::s_filter_pred_ne(const BSQListTypeFlavor& lflavor, LambdaEvalT
     return rres;
 }
 
-void* BSQListOps::s_filter_pred_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, const std::vector<StorageLocationPtr>& params)
+void* BSQListOps::s_filter_pred_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, StorageLocationSpan params)
 {
     auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
     auto rnode = Allocator::GlobalAllocator.registerCollectionNode(static_cast<BSQListTreeRepr*>(t));
@@ -437,7 +607,7 @@ void* BSQListOps::s_filter_pred_idx_ne(const BSQListTypeFlavor& lflavor, LambdaE
     return rres;
 }
     
-void* BSQListOps::s_map_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* fn, const std::vector<StorageLocationPtr>& params, const BSQListTypeFlavor& resflavor)
+void* BSQListOps::s_map_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* fn, StorageLocationSpan params, const BSQListTypeFlavor& resflavor)
 {
     auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
     auto rnode = Allocator::GlobalAllocator.registerCollectionNode(static_cast<BSQListTreeRepr*>(t));
@@ -472,7 +642,7 @@ void* BSQListOps::s_map_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee,
     return rres;
 }
 
-void* BSQListOps::s_map_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* fn, const std::vector<StorageLocationPtr>& params, const BSQListTypeFlavor& resflavor)
+void* BSQListOps::s_map_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* fn, StorageLocationSpan params, const BSQListTypeFlavor& resflavor)
 {
     auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
     auto rnode = Allocator::GlobalAllocator.registerCollectionNode(static_cast<BSQListTreeRepr*>(t));
@@ -509,7 +679,7 @@ void* BSQListOps::s_map_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk
     return rres;
 }
 
-void* BSQListOps::s_map_sync_ne(const BSQListTypeFlavor& lflavor1, const BSQListTypeFlavor& lflavor2, LambdaEvalThunk ee, uint64_t count, void* t1, const BSQListReprType* ttype1, void* t2, const BSQListReprType* ttype2, const BSQPCode* fn, const std::vector<StorageLocationPtr>& params, const BSQListTypeFlavor& resflavor)
+void* BSQListOps::s_map_sync_ne(const BSQListTypeFlavor& lflavor1, const BSQListTypeFlavor& lflavor2, LambdaEvalThunk ee, uint64_t count, void* t1, const BSQListReprType* ttype1, void* t2, const BSQListReprType* ttype2, const BSQPCode* fn, StorageLocationSpan params, const BSQListTypeFlavor& resflavor)
 {
     BSQListForwardIterator iter1(ttype1, t1);
     Allocator::GlobalAllocator.registerCollectionIterator(&iter1);
@@ -545,7 +715,7 @@ void* BSQListOps::s_map_sync_ne(const BSQListTypeFlavor& lflavor1, const BSQList
     
     auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
 
-    auto lstart = Allocator::GlobalAllocator.getTempRootCurrScope().begin();
+    auto lstart = Allocator::GlobalAllocator.getTempRootCurrScopeBegin();
     void* rres = BSQListOps::s_temp_root_to_list_rec(resflavor, lstart, count);
 
     Allocator::GlobalAllocator.popTempRootScope();
@@ -610,121 +780,40 @@ void* s_set_ne_rec(const BSQListTypeFlavor& lflavor, BSQListSpineIterator& iter,
 void* BSQListOps::s_set_ne(const BSQListTypeFlavor& lflavor, void* t, const BSQListReprType* ttype, BSQNat i, StorageLocationPtr v)
 {
     BSQListSpineIterator iter(ttype, t);
-    return s_set_ne_rec(lflavor, iter, 0, i, v);
-}
-
-void* s_push_back_ne_rec(const BSQListTypeFlavor& lflavor, BSQListSpineIterator& iter, size_t alloc, StorageLocationPtr v)
-{
-    auto ttype = GET_TYPE_META_DATA_AS(BSQListReprType, iter.lcurr);
-
-    void* res = nullptr;
-    if(ttype->lkind != ListReprKind::TreeElement)
-    {
-        auto vsize = BSQPartialVectorType::getPVCount(iter.lcurr);
-        if(vsize < 8)
-        {
-            auto nalloc = alloc + lflavor.pv8type->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
-            Allocator::GlobalAllocator.ensureSpace(nalloc);
-        
-            auto pvsize = BSQPartialVectorType::getPVCount(iter.lcurr);
-            auto pvalloc = pvsize <= 4 ? lflavor.pv4type : lflavor.pv8type;
-        
-            Allocator::GlobalAllocator.ensureSpace(nalloc);
-            res = Allocator::GlobalAllocator.allocateSafe(pvalloc);
-            BSQPartialVectorType::pushBackPVData(res, iter.lcurr, v, pvalloc->entrysize);
-        }
-        else
-        {
-            auto nalloc = alloc + lflavor.pv4type->allocinfo.heapsize + sizeof(GC_META_DATA_WORD) + lflavor.treetype->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
-            Allocator::GlobalAllocator.ensureSpace(nalloc);
-            
-            void* pv = Allocator::GlobalAllocator.allocateSafe(lflavor.pv4type);
-            BSQPartialVectorType::initializePVDataSingle(pv, v, lflavor.entrytype);
-
-            res = Allocator::GlobalAllocator.allocateSafe(lflavor.treetype);
-            ((BSQListTreeRepr*)res)->l = static_cast<BSQListTreeRepr*>(iter.lcurr);
-            ((BSQListTreeRepr*)res)->r = pv;
-            ((BSQListTreeRepr*)res)->size = static_cast<BSQListTreeRepr*>(iter.lcurr)->size + 1;
-        }
-    }
-    else
-    {
-        auto nalloc = alloc + lflavor.treetype->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
-        
-        iter.moveRight();
-        void* nr = s_push_back_ne_rec(lflavor, iter, nalloc, v);
-        iter.pop();
+    Allocator::GlobalAllocator.registerCollectionIterator(&iter);
 
-        res = Allocator::GlobalAllocator.allocateSafe(lflavor.treetype);
-        ((BSQListTreeRepr*)res)->l = static_cast<BSQListTreeRepr*>(iter.lcurr)->l;
-        ((BSQListTreeRepr*)res)->r = nr;
-        ((BSQListTreeRepr*)res)->size = static_cast<BSQListTreeRepr*>(iter.lcurr)->size;
-    }
+    void* res = s_set_ne_rec(lflavor, iter, 0, i, v);
 
+    Allocator::GlobalAllocator.releaseCollectionIterator(&iter);
     return res;
 }
 
 void* BSQListOps::s_push_back_ne(const BSQListTypeFlavor& lflavor, void* t, const BSQListReprType* ttype, StorageLocationPtr v)
 {
-    BSQListSpineIterator iter(ttype, t);
-    return s_push_back_ne_rec(lflavor, iter, 0, v);
-}
-
-void* s_push_front_ne_rec(const BSQListTypeFlavor& lflavor, BSQListSpineIterator& iter, size_t alloc, StorageLocationPtr v)
-{
-    auto ttype = GET_TYPE_META_DATA_AS(BSQListReprType, iter.lcurr);
-
-    void* res = nullptr;
-    if(ttype->lkind != ListReprKind::TreeElement)
-    {
-        auto vsize = BSQPartialVectorType::getPVCount(iter.lcurr);
-        if(vsize < 8)
-        {
-            auto nalloc = alloc + lflavor.pv8type->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
-            Allocator::GlobalAllocator.ensureSpace(nalloc);
-        
-            auto pvsize = BSQPartialVectorType::getPVCount(iter.lcurr);
-            auto pvalloc = pvsize <= 4 ? lflavor.pv4type : lflavor.pv8type;
-        
-            Allocator::GlobalAllocator.ensureSpace(nalloc);
-            res = Allocator::GlobalAllocator.allocateSafe(pvalloc);
-            BSQPartialVectorType::pushFrontPVData(res, iter.lcurr, v, pvalloc->entrysize);
-        }
-        else
-        {
-            auto nalloc = alloc + lflavor.pv4type->allocinfo.heapsize + sizeof(GC_META_DATA_WORD) + lflavor.treetype->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
-            Allocator::GlobalAllocator.ensureSpace(nalloc);
-            
-            void* pv = Allocator::GlobalAllocator.allocateSafe(lflavor.pv4type);
-            BSQPartialVectorType::initializePVDataSingle(pv, v, lflavor.entrytype);
-
-            res = Allocator::GlobalAllocator.allocateSafe(lflavor.treetype);
-            ((BSQListTreeRepr*)res)->l = pv;
-            ((BSQListTreeRepr*)res)->r = static_cast<BSQListTreeRepr*>(iter.lcurr)->r;
-            ((BSQListTreeRepr*)res)->size = static_cast<BSQListTreeRepr*>(iter.lcurr)->size + 1;
-        }
-    }
-    else
-    {
-        auto nalloc = alloc + lflavor.treetype->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
+    auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
+    auto tnode = Allocator::GlobalAllocator.registerCollectionNode(t);
 
-        iter.moveLeft();
-        void* nl = s_push_front_ne_rec(lflavor, iter, nalloc, v);
-        iter.pop();
+    void* pv = Allocator::GlobalAllocator.allocateDynamic(lflavor.pv4type);
+    BSQPartialVectorType::initializePVDataSingle(pv, v, lflavor.entrytype);
 
-        res = Allocator::GlobalAllocator.allocateSafe(lflavor.treetype);
-        ((BSQListTreeRepr*)res)->l = nl;
-        ((BSQListTreeRepr*)res)->r = static_cast<BSQListTreeRepr*>(iter.lcurr)->r;
-        ((BSQListTreeRepr*)res)->size = static_cast<BSQListTreeRepr*>(iter.lcurr)->size;
-    }
+    void* res = BSQListOps::list_append(lflavor, tnode->repr, pv);
 
+    Allocator::GlobalAllocator.resetCollectionNodeEnd(gcpoint);
     return res;
 }
 
 void* BSQListOps::s_push_front_ne(const BSQListTypeFlavor& lflavor, void* t, const BSQListReprType* ttype, StorageLocationPtr v)
 {
-    BSQListSpineIterator iter(ttype, t);
-    return s_push_front_ne_rec(lflavor, iter, 0, v);
+    auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
+    auto tnode = Allocator::GlobalAllocator.registerCollectionNode(t);
+
+    void* pv = Allocator::GlobalAllocator.allocateDynamic(lflavor.pv4type);
+    BSQPartialVectorType::initializePVDataSingle(pv, v, lflavor.entrytype);
+
+    void* res = BSQListOps::list_append(lflavor, pv, tnode->repr);
+
+    Allocator::GlobalAllocator.resetCollectionNodeEnd(gcpoint);
+    return res;
 }
 
 void* s_remove_ne_rec(const BSQListTypeFlavor& lflavor, BSQListSpineIterator& iter, size_t alloc, BSQNat i)
@@ -745,34 +834,40 @@ void* s_remove_ne_rec(const BSQListTypeFlavor& lflavor, BSQListSpineIterator& it
     }
     else
     {
-        auto nalloc = alloc + lflavor.treetype->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
+        auto nalloc = alloc + LIST_TREE_LEVEL_ALLOC(lflavor);
 
         auto trepr = static_cast<BSQListTreeRepr*>(iter.lcurr);
-        auto ll = trepr->l;
-        auto lltype = GET_TYPE_META_DATA_AS(BSQListReprType, ll);
-        auto llcount = lltype->getCount(ll);
+        auto llcount = BSQListTreeType::getSize(trepr->l);
+        auto rrcount = BSQListTreeType::getSize(trepr->r);
 
+        //removing the only element of a leaf drops the leaf and the sibling takes the place of this node
         if(i < llcount)
         {
+            if(llcount == 1)
+            {
+                Allocator::GlobalAllocator.ensureSpace(alloc);
+                return static_cast<BSQListTreeRepr*>(iter.lcurr)->r;
+            }
+
             iter.moveLeft();
             void* nl = s_remove_ne_rec(lflavor, iter, nalloc, i);
             iter.pop();
 
-            res = Allocator::GlobalAllocator.allocateSafe(lflavor.treetype);
-            ((BSQListTreeRepr*)res)->l = nl;
-            ((BSQListTreeRepr*)res)->r = static_cast<BSQListTreeRepr*>(iter.lcurr)->r;
-            ((BSQListTreeRepr*)res)->size = static_cast<BSQListTreeRepr*>(iter.lcurr)->size - 1;
+            res = s_list_balance_ne(lflavor, nl, static_cast<BSQListTreeRepr*>(iter.lcurr)->r);
         }
         else
         {
+            if(rrcount == 1)
+            {
+                Allocator::GlobalAllocator.ensureSpace(alloc);
+                return static_cast<BSQListTreeRepr*>(iter.lcurr)->l;
+            }
+
             iter.moveRight();
             void* nr = s_remove_ne_rec(lflavor, iter, nalloc, i - llcount);
             iter.pop();
 
-            res = Allocator::GlobalAllocator.allocateSafe(lflavor.treetype);
-            ((BSQListTreeRepr*)res)->l = static_cast<BSQListTreeRepr*>(iter.lcurr)->l;
-            ((BSQListTreeRepr*)res)->r = nr;
-            ((BSQListTreeRepr*)res)->size = static_cast<BSQListTreeRepr*>(iter.lcurr)->size - 1;
+            res = s_list_balance_ne(lflavor, static_cast<BSQListTreeRepr*>(iter.lcurr)->l, nr);
         }
     }
 
@@ -782,10 +877,15 @@ void* s_remove_ne_rec(const BSQListTypeFlavor& lflavor, BSQListSpineIterator& it
 void* BSQListOps::s_remove_ne(const BSQListTypeFlavor& lflavor, void* t, const BSQListReprType* ttype, BSQNat i)
 {
     BSQListSpineIterator iter(ttype, t);
-    return s_remove_ne_rec(lflavor, iter, 0, i);
+    Allocator::GlobalAllocator.registerCollectionIterator(&iter);
+
+    void* res = s_remove_ne_rec(lflavor, iter, 0, i);
+
+    Allocator::GlobalAllocator.releaseCollectionIterator(&iter);
+    return res;
 }
 
-void BSQListOps::s_reduce_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* f, const std::vector<StorageLocationPtr>& params, StorageLocationPtr res)
+void BSQListOps::s_reduce_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* f, StorageLocationSpan params, StorageLocationPtr res)
 {
     BSQListForwardIterator iter(ttype, t);
     Allocator::GlobalAllocator.registerCollectionIterator(&iter);
@@ -810,7 +910,7 @@ void BSQListOps::s_reduce_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk e
     Allocator::GlobalAllocator.releaseCollectionIterator(&iter);
 }
 
-void BSQListOps::s_reduce_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* f, const std::vector<StorageLocationPtr>& params, StorageLocationPtr res)
+void BSQListOps::s_reduce_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* f, StorageLocationSpan params, StorageLocationPtr res)
 {
     BSQListForwardIterator iter(ttype, t);
     Allocator::GlobalAllocator.registerCollectionIterator(&iter);
@@ -837,7 +937,7 @@ void BSQListOps::s_reduce_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThu
     Allocator::GlobalAllocator.releaseCollectionIterator(&iter);
 }
 
-void BSQListOps::s_transduce_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQListTypeFlavor& uflavor, const BSQType* envtype, const BSQPCode* f, const std::vector<StorageLocationPtr>& params, const BSQEphemeralListType* rrtype, StorageLocationPtr eres)
+void BSQListOps::s_transduce_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQListTypeFlavor& uflavor, const BSQType* envtype, const BSQPCode* f, StorageLocationSpan params, const BSQEphemeralListType* rrtype, StorageLocationPtr eres)
 {
     auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
     auto rnode = Allocator::GlobalAllocator.registerCollectionNode(static_cast<BSQListTreeRepr*>(t));
@@ -883,7 +983,7 @@ void BSQListOps::s_transduce_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThun
     Allocator::GlobalAllocator.resetCollectionNodeEnd(gcpoint);
 }
 
-void BSQListOps::s_transduce_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQListTypeFlavor& uflavor, const BSQType* envtype, const BSQPCode* f, const std::vector<StorageLocationPtr>& params, const BSQEphemeralListType* rrtype, StorageLocationPtr eres)
+void BSQListOps::s_transduce_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQListTypeFlavor& uflavor, const BSQType* envtype, const BSQPCode* f, StorageLocationSpan params, const BSQEphemeralListType* rrtype, StorageLocationPtr eres)
 {
     auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
     auto rnode = Allocator::GlobalAllocator.registerCollectionNode(static_cast<BSQListTreeRepr*>(t));
@@ -931,62 +1031,275 @@ void BSQListOps::s_transduce_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEval
     Allocator::GlobalAllocator.resetCollectionNodeEnd(gcpoint);
 }
 
-void* BSQListOps::s_sort_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* lt, const std::vector<StorageLocationPtr>& params)
-{
-    //TODO: implement
-    assert(false);
-    return nullptr;
-}
-
-void* BSQListOps::s_unique_from_sorted_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* eq, const std::vector<StorageLocationPtr>& params)
+//Copy the elements into temp roots (in list order) -- the copies do not move in a collection so the sort can work on their locations
+std::vector<StorageLocationPtr> s_list_to_temp_roots(const BSQListTypeFlavor& lflavor, void* t, const BSQListReprType* ttype)
 {
-    //TODO: implement
-    assert(false);
-    return nullptr;
-}
-
+    std::vector<StorageLocationPtr> entries;
+    entries.reserve(ttype->getCount(t));
 
-BSQString BSQListOps::s_strconcat_ne(void* t, const BSQListReprType* ttype)
-{
     BSQListForwardIterator iter(ttype, t);
-    Allocator::GlobalAllocator.registerCollectionIterator(&iter);
-
-    BSQString res = SLPTR_LOAD_CONTENTS_AS(BSQString, iter.getlocation());
-    iter.advance();
-
-    GCStack::pushFrame((void**)&res, "3");
-
     while(iter.valid())
     {
-        StorageLocationPtr ss = iter.getlocation();
-        res = BSQStringImplType::concat2(&res, ss);
+        auto rr = Allocator::GlobalAllocator.registerTempRoot(lflavor.entrytype);
+        lflavor.entrytype->storeValue(rr->root, iter.getlocation());
+        entries.push_back(rr->root);
 
         iter.advance();
     }
 
-    Allocator::GlobalAllocator.releaseCollectionIterator(&iter);
-    GCStack::popFrame();
-
-    return res;
+    return entries;
 }
 
-BSQString BSQListOps::s_strjoin_ne(void* t, const BSQListReprType* ttype, StorageLocationPtr sep)
+//Balanced tree over the elements where every leaf but the last is a full pv8
+void* s_locations_to_list_rec(const BSQListTypeFlavor& lflavor, const StorageLocationPtr* elems, uint64_t count)
 {
-    BSQListForwardIterator iter(ttype, t);
-    Allocator::GlobalAllocator.registerCollectionIterator(&iter);
-
-    BSQString res = SLPTR_LOAD_CONTENTS_AS(BSQString, iter.getlocation());
-    iter.advance();
-
-    GCStack::pushFrame((void**)&res, "3");
-
-    while(iter.valid())
+    void* res = nullptr;
+    if(count <= 8)
     {
-        StorageLocationPtr ss = iter.getlocation();
-        res = BSQStringImplType::concat2(&res, sep);
-        res = BSQStringImplType::concat2(&res, ss);
+        const BSQPartialVectorType* pvtype = (count <= 4) ? lflavor.pv4type : lflavor.pv8type;
 
-        iter.advance();
+        res = Allocator::GlobalAllocator.allocateDynamic(pvtype);
+        BSQPartialVectorType::setPVCount(res, (int16_t)count);
+        for(int16_t i = 0; i < (int16_t)count; ++i)
+        {
+            lflavor.entrytype->storeValue(pvtype->get(res, i), elems[i]);
+        }
+    }
+    else
+    {
+        auto llcount = (((count + 7) / 8) / 2) * 8;
+
+        auto gclpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
+        auto llnode = s_locations_to_list_rec(lflavor, elems, llcount);
+        auto llres = Allocator::GlobalAllocator.resetCollectionNodeEnd(gclpoint, llnode);
+
+        auto gcrpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
+        auto rrnode = s_locations_to_list_rec(lflavor, elems + llcount, count - llcount);
+        auto rrres = Allocator::GlobalAllocator.resetCollectionNodeEnd(gcrpoint, rrnode);
+
+        res = BSQListOps::list_append(lflavor, llres->repr, rrres->repr);
+    }
+    return res;
+}
+
+//If the lambda body is just the key compare (of the given ops) of its two args on the entry type then return the entry type so the caller can use fpkeycmp
+const BSQType* s_try_get_key_compare_lambda(const BSQListTypeFlavor& lflavor, const BSQPCode* pc, OpCodeTag fasttag, OpCodeTag statictag, OpCodeTag inttag, OpCodeTag nattag)
+{
+    const BSQInvokeBodyDecl* icall = dynamic_cast<const BSQInvokeBodyDecl*>(BSQInvokeDecl::g_invokes[pc->code]);
+    if(icall == nullptr || icall->paraminfo.size() != 2 || lflavor.entrytype->fpkeycmp == EMPTY_KEY_CMP)
+    {
+        return nullptr;
+    }
+
+    std::vector<const InterpOp*> ops;
+    std::copy_if(icall->body.cbegin(), icall->body.cend(), std::back_inserter(ops), [](const InterpOp* op) {
+        return (op->tag != OpCodeTag::VarLifetimeStartOp) & (op->tag != OpCodeTag::VarLifetimeEndOp);
+    });
+
+    if(ops.size() != 2 || ops[1]->tag != OpCodeTag::ReturnAssignOp)
+    {
+        return nullptr;
+    }
+
+    const BSQType* oftype = nullptr;
+    TargetVar trgt = {ArgumentTag::InvalidOp, 0};
+    Argument argl = {ArgumentTag::InvalidOp, 0};
+    Argument argr = {ArgumentTag::InvalidOp, 0};
+    if(ops[0]->tag == fasttag)
+    {
+        //the eq and less fast ops have the same layout for the fields we need
+        if(fasttag == OpCodeTag::BinKeyEqFastOp)
+        {
+            auto kop = static_cast<const BinKeyEqFastOp*>(ops[0]);
+            if(kop->sguard.enabled)
+            {
+                return nullptr;
+            }
+            oftype = kop->oftype; trgt = kop->trgt; argl = kop->argl; argr = kop->argr;
+        }
+        else
+        {
+            auto kop = static_cast<const BinKeyLessFastOp*>(ops[0]);
+            oftype = kop->oftype; trgt = kop->trgt; argl = kop->argl; argr = kop->argr;
+        }
+    }
+    else if(ops[0]->tag == statictag)
+    {
+        if(statictag == OpCodeTag::BinKeyEqStaticOp)
+        {
+            auto kop = static_cast<const BinKeyEqStaticOp*>(ops[0]);
+            if(kop->sguard.enabled || kop->argllayout->tid != kop->oftype->tid || kop->argrlayout->tid != kop->oftype->tid)
+            {
+                return nullptr;
+            }
+            oftype = kop->oftype; trgt = kop->trgt; argl = kop->argl; argr = kop->argr;
+        }
+        else
+        {
+            auto kop = static_cast<const BinKeyLessStaticOp*>(ops[0]);
+            if(kop->argllayout->tid != kop->oftype->tid || kop->argrlayout->tid != kop->oftype->tid)
+            {
+                return nullptr;
+            }
+            oftype = kop->oftype; trgt = kop->trgt; argl = kop->argl; argr = kop->argr;
+        }
+    }
+    else if((ops[0]->tag == inttag) | (ops[0]->tag == nattag))
+    {
+        //key compares specialized at load time
+        auto kop = static_cast<const PrimitiveBinaryCompareOp<OpCodeTag::LtIntOp>*>(ops[0]);
+        oftype = BSQType::g_typetable[(ops[0]->tag == inttag) ? BSQ_TYPE_ID_INT : BSQ_TYPE_ID_NAT]; trgt = kop->trgt; argl = kop->larg; argr = kop->rarg;
+    }
+    else
+    {
+        return nullptr;
+    }
+
+    auto rop = static_cast<const ReturnAssignOp*>(ops[1]);
+    bool argsok = (argl.kind == icall->paraminfo[0].kind) & (argl.location == icall->paraminfo[0].poffset) & (argr.kind == icall->paraminfo[1].kind) & (argr.location == icall->paraminfo[1].poffset);
+    bool resok = (rop->arg.kind == trgt.kind) & (rop->arg.location == trgt.offset);
+    if(!argsok || !resok || oftype->tid != lflavor.entrytype->tid)
+    {
+        return nullptr;
+    }
+
+    return oftype;
+}
+
+void* BSQListOps::s_sort_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* lt, StorageLocationSpan params)
+{
+    Allocator::GlobalAllocator.pushTempRootScope();
+    auto entries = s_list_to_temp_roots(lflavor, t, ttype);
+
+    const BSQType* keytype = s_try_get_key_compare_lambda(lflavor, lt, OpCodeTag::BinKeyLessFastOp, OpCodeTag::BinKeyLessStaticOp, OpCodeTag::LtIntOp, OpCodeTag::LtNatOp);
+    if(keytype != nullptr)
+    {
+        //only the register key compares (Int, Nat, Bool, enums, ...) are plain reads of the entries so only they run on the worker threads -- String and the other keys sort on this thread
+        size_t nthreads = 1;
+        if(keytype->tkind == BSQTypeLayoutKind::Register)
+        {
+            nthreads = std::min((size_t)std::max(std::thread::hardware_concurrency(), 1u), (size_t)BSQ_LIST_SORT_MAX_THREADS);
+        }
+
+        BSQListOps::par_stable_sort(entries, [keytype](StorageLocationPtr l, StorageLocationPtr r) {
+            return keytype->fpkeycmp(keytype, l, r) < 0;
+        }, nthreads);
+    }
+    else
+    {
+        //the lambda may allocate (and collect) but that only updates the temp root values in place
+        const BSQInvokeBodyDecl* icall = dynamic_cast<const BSQInvokeBodyDecl*>(BSQInvokeDecl::g_invokes[lt->code]);
+
+        BI_LAMBDA_CALL_SETUP_TEMP_X2_CMP(lflavor.entrytype, esl1, lflavor.entrytype, esl2, params, lt, lparams)
+
+        std::stable_sort(entries.begin(), entries.end(), [&](StorageLocationPtr l, StorageLocationPtr r) {
+            lflavor.entrytype->storeValue(esl1, l);
+            lflavor.entrytype->storeValue(esl2, r);
+
+            BSQBool bb = BSQFALSE;
+            ee.invoke(icall, lparams, &bb);
+
+            lflavor.entrytype->clearValue(esl1);
+            lflavor.entrytype->clearValue(esl2);
+            return (bool)bb;
+        });
+
+        BI_LAMBDA_CALL_SETUP_POP()
+    }
+
+    void* res = s_locations_to_list_rec(lflavor, entries.data(), entries.size());
+
+    Allocator::GlobalAllocator.popTempRootScope();
+    return res;
+}
+
+void* BSQListOps::s_unique_from_sorted_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* eq, StorageLocationSpan params)
+{
+    Allocator::GlobalAllocator.pushTempRootScope();
+    auto entries = s_list_to_temp_roots(lflavor, t, ttype);
+
+    //keep the first element of each run of equal elements
+    std::vector<StorageLocationPtr> keep = {entries[0]};
+
+    const BSQType* keytype = s_try_get_key_compare_lambda(lflavor, eq, OpCodeTag::BinKeyEqFastOp, OpCodeTag::BinKeyEqStaticOp, OpCodeTag::EqIntOp, OpCodeTag::EqNatOp);
+    if(keytype != nullptr)
+    {
+        std::copy_if(entries.cbegin() + 1, entries.cend(), std::back_inserter(keep), [&](StorageLocationPtr e) {
+            return keytype->fpkeycmp(keytype, keep.back(), e) != 0;
+        });
+    }
+    else
+    {
+        const BSQInvokeBodyDecl* icall = dynamic_cast<const BSQInvokeBodyDecl*>(BSQInvokeDecl::g_invokes[eq->code]);
+
+        BI_LAMBDA_CALL_SETUP_TEMP_X2_CMP(lflavor.entrytype, esl1, lflavor.entrytype, esl2, params, eq, lparams)
+
+        for(size_t i = 1; i < entries.size(); ++i)
+        {
+            lflavor.entrytype->storeValue(esl1, keep.back());
+            lflavor.entrytype->storeValue(esl2, entries[i]);
+
+            BSQBool bb = BSQFALSE;
+            ee.invoke(icall, lparams, &bb);
+            if(!bb)
+            {
+                keep.push_back(entries[i]);
+            }
+
+            lflavor.entrytype->clearValue(esl1);
+            lflavor.entrytype->clearValue(esl2);
+        }
+
+        BI_LAMBDA_CALL_SETUP_POP()
+    }
+
+    void* res = s_locations_to_list_rec(lflavor, keep.data(), keep.size());
+
+    Allocator::GlobalAllocator.popTempRootScope();
+    return res;
+}
+
+BSQString BSQListOps::s_strconcat_ne(void* t, const BSQListReprType* ttype)
+{
+    BSQListForwardIterator iter(ttype, t);
+    Allocator::GlobalAllocator.registerCollectionIterator(&iter);
+
+    BSQString res = SLPTR_LOAD_CONTENTS_AS(BSQString, iter.getlocation());
+    iter.advance();
+
+    GCStack::pushFrame((void**)&res, "3");
+
+    while(iter.valid())
+    {
+        StorageLocationPtr ss = iter.getlocation();
+        res = BSQStringImplType::concat2(&res, ss);
+
+        iter.advance();
+    }
+
+    Allocator::GlobalAllocator.releaseCollectionIterator(&iter);
+    GCStack::popFrame();
+
+    return res;
+}
+
+BSQString BSQListOps::s_strjoin_ne(void* t, const BSQListReprType* ttype, StorageLocationPtr sep)
+{
+    BSQListForwardIterator iter(ttype, t);
+    Allocator::GlobalAllocator.registerCollectionIterator(&iter);
+
+    BSQString res = SLPTR_LOAD_CONTENTS_AS(BSQString, iter.getlocation());
+    iter.advance();
+
+    GCStack::pushFrame((void**)&res, "3");
+
+    while(iter.valid())
+    {
+        StorageLocationPtr ss = iter.getlocation();
+        res = BSQStringImplType::concat2(&res, sep);
+        res = BSQStringImplType::concat2(&res, ss);
+
+        iter.advance();
     }
 
     Allocator::GlobalAllocator.releaseCollectionIterator(&iter);
@@ -997,300 +1310,962 @@ BSQString BSQListOps::s_strjoin_ne(void* t, const BSQListReprType* ttype, Storag
 
 std::map<std::pair<BSQTypeID, BSQTypeID>, BSQMapTypeFlavor> BSQMapOps::g_flavormap;
 
-void s_union_rec_ne(const BSQMapTypeFlavor& mflavor, StorageLocationPtr tnode, BSQMapSpineIterator& ii)
+#define MAP_TREE_NODE_ALLOC(MFLAVOR) ((MFLAVOR).treetype->allocinfo.heapsize + sizeof(GC_META_DATA_WORD))
+
+//Subtrees with at most this many nodes are built out of a single reservation
+#define MAP_TREE_BUILD_CHUNK 256
+
+void* s_hash_add_entries_ne(const BSQMapTypeFlavor& mflavor, void* t, const std::vector<StorageLocationPtr>& entries);
+
+void* BSQMapOps::map_cons(const BSQMapTypeFlavor& mflavor, StorageLocationSpan params)
+{
+    const BSQTupleInfo* tupinfo = dynamic_cast<const BSQTupleInfo*>(mflavor.tupletype);
+    if(mflavor.hashleaftype != nullptr)
+    {
+        //the params are frame slots so the entries can be added in place
+        return s_hash_add_entries_ne(mflavor, nullptr, std::vector<StorageLocationPtr>(params.begin(), params.end()));
+    }
+    else if(params.size() == 1)
+    {
+        void* repr = Allocator::GlobalAllocator.allocateDynamic(mflavor.treetype);
+        mflavor.treetype->initializeLeaf(repr, mflavor.tupletype->indexStorageLocationOffset(params[0], tupinfo->idxoffsets[0]), mflavor.keytype, mflavor.tupletype->indexStorageLocationOffset(params[0], tupinfo->idxoffsets[1]), mflavor.valuetype);
+        return repr;
+    }
+    else
+    {
+        Allocator::GlobalAllocator.pushTempRootScope();
+
+        for(size_t i = 0; i < params.size(); ++i)
+        {
+            BSQMapOps::s_entry_to_temp_root(mflavor, mflavor.tupletype->indexStorageLocationOffset(params[i], tupinfo->idxoffsets[0]), mflavor.tupletype->indexStorageLocationOffset(params[i], tupinfo->idxoffsets[1]));
+        }
+
+        auto lstart = Allocator::GlobalAllocator.getTempRootCurrScopeBegin();
+        auto lsize = Allocator::GlobalAllocator.getTempRootCurrScopeSize();
+
+        bool unique = BSQMapOps::s_sort_temp_root_entries(mflavor, lstart, lsize);
+        BSQ_INTERNAL_ASSERT(unique);
+
+        void* res = BSQMapOps::s_temp_root_to_map_ne(mflavor, lstart, lsize);
+
+        Allocator::GlobalAllocator.popTempRootScope();
+        return res;
+    }
+}
+
+bool BSQMapOps::s_sort_temp_root_entries(const BSQMapTypeFlavor& mflavor, BSQTempRootNode* lelems, uint64_t count)
+{
+    const BSQTupleInfo* tupinfo = dynamic_cast<const BSQTupleInfo*>(mflavor.tupletype);
+    auto keyof = [&](const BSQTempRootNode& rn) {
+        return mflavor.tupletype->indexStorageLocationOffset(rn.root, tupinfo->idxoffsets[0]);
+    };
+
+    std::stable_sort(lelems, lelems + count, [&](const BSQTempRootNode& ln, const BSQTempRootNode& rn) {
+        return mflavor.keytype->fpkeycmp(mflavor.keytype, keyof(ln), keyof(rn)) < 0;
+    });
+
+    auto dup = std::adjacent_find(lelems, lelems + count, [&](const BSQTempRootNode& ln, const BSQTempRootNode& rn) {
+        return mflavor.keytype->fpkeycmp(mflavor.keytype, keyof(ln), keyof(rn)) == 0;
+    });
+
+    return dup == lelems + count;
+}
+
+//Build the subtree when the space for all of its nodes has been reserved
+void* s_temp_root_to_map_safe(const BSQMapTypeFlavor& mflavor, const BSQTupleInfo* tupinfo, BSQTempRootNode* lelems, uint64_t count)
+{
+    if(count == 0)
+    {
+        return nullptr;
+    }
+
+    auto mid = count / 2;
+    void* ll = s_temp_root_to_map_safe(mflavor, tupinfo, lelems, mid);
+    void* rr = s_temp_root_to_map_safe(mflavor, tupinfo, lelems + mid + 1, count - mid - 1);
+
+    void* res = Allocator::GlobalAllocator.allocateSafe(mflavor.treetype);
+    mflavor.treetype->initializeLR(res, mflavor.tupletype->indexStorageLocationOffset(lelems[mid].root, tupinfo->idxoffsets[0]), mflavor.keytype, mflavor.tupletype->indexStorageLocationOffset(lelems[mid].root, tupinfo->idxoffsets[1]), mflavor.valuetype, ll, rr);
+
+    return res;
+}
+
+void* s_temp_root_to_map_rec(const BSQMapTypeFlavor& mflavor, const BSQTupleInfo* tupinfo, BSQTempRootNode* lelems, uint64_t count)
+{
+    if(count <= MAP_TREE_BUILD_CHUNK)
+    {
+        Allocator::GlobalAllocator.ensureSpace(count * MAP_TREE_NODE_ALLOC(mflavor));
+        return s_temp_root_to_map_safe(mflavor, tupinfo, lelems, count);
+    }
+
+    auto mid = count / 2;
+    auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
+    auto lnode = Allocator::GlobalAllocator.registerCollectionNode(s_temp_root_to_map_rec(mflavor, tupinfo, lelems, mid));
+    auto rnode = Allocator::GlobalAllocator.registerCollectionNode(s_temp_root_to_map_rec(mflavor, tupinfo, lelems + mid + 1, count - mid - 1));
+
+    Allocator::GlobalAllocator.ensureSpace(MAP_TREE_NODE_ALLOC(mflavor));
+    void* res = Allocator::GlobalAllocator.allocateSafe(mflavor.treetype);
+    mflavor.treetype->initializeLR(res, mflavor.tupletype->indexStorageLocationOffset(lelems[mid].root, tupinfo->idxoffsets[0]), mflavor.keytype, mflavor.tupletype->indexStorageLocationOffset(lelems[mid].root, tupinfo->idxoffsets[1]), mflavor.valuetype, lnode->repr, rnode->repr);
+
+    Allocator::GlobalAllocator.resetCollectionNodeEnd(gcpoint);
+    return res;
+}
+
+void* BSQMapOps::s_temp_root_to_map_ne(const BSQMapTypeFlavor& mflavor, BSQTempRootNode* lelems, uint64_t count)
+{
+    const BSQTupleInfo* tupinfo = dynamic_cast<const BSQTupleInfo*>(mflavor.tupletype);
+    return s_temp_root_to_map_rec(mflavor, tupinfo, lelems, count);
+}
+
+void s_map_push_left_spine(void* t, std::vector<void*>& spine)
+{
+    while(t != nullptr)
+    {
+        spine.push_back(t);
+        t = BSQMapTreeType::getLeft(t);
+    }
+}
+
+//Copy the entries of both trees into temp roots in key order -- nothing is allocated in the collector heap so the raw node pointers stay valid
+void s_union_merge_entries(const BSQMapTypeFlavor& mflavor, void* t1, void* t2)
+{
+    std::vector<void*> spine1;
+    std::vector<void*> spine2;
+    s_map_push_left_spine(t1, spine1);
+    s_map_push_left_spine(t2, spine2);
+
+    while(!spine1.empty() || !spine2.empty())
+    {
+        std::vector<void*>* spine = nullptr;
+        if(spine2.empty())
+        {
+            spine = &spine1;
+        }
+        else if(spine1.empty())
+        {
+            spine = &spine2;
+        }
+        else
+        {
+            auto cmp = mflavor.keytype->fpkeycmp(mflavor.keytype, mflavor.treetype->getKeyLocation(spine1.back()), mflavor.treetype->getKeyLocation(spine2.back()));
+            BSQ_INTERNAL_ASSERT(cmp != 0);
+
+            spine = (cmp < 0) ? &spine1 : &spine2;
+        }
+
+        void* nn = spine->back();
+        spine->pop_back();
+        s_map_push_left_spine(BSQMapTreeType::getRight(nn), *spine);
+
+        BSQMapOps::s_entry_to_temp_root(mflavor, mflavor.treetype->getKeyLocation(nn), mflavor.treetype->getValueLocation(nn));
+    }
+}
+
+void* s_hash_union_ne(const BSQMapTypeFlavor& mflavor, void* t1, void* t2);
+std::pair<void*, BSQNat> s_hash_submap_ne(const BSQMapTypeFlavor& mflavor, LambdaEvalThunk ee, void* t, const BSQPCode* pred, StorageLocationSpan params);
+void* s_hash_remap_ne(const BSQMapTypeFlavor& mflavor, LambdaEvalThunk ee, void* t, const BSQPCode* fn, StorageLocationSpan params, const BSQMapTypeFlavor& resflavor);
+
+void* BSQMapOps::s_union_ne(const BSQMapTypeFlavor& mflavor, void* t1, const BSQMapTreeType* ttype1, void* t2, const BSQMapTreeType* ttype2, uint64_t ccount)
+{
+    if(mflavor.hashleaftype != nullptr)
+    {
+        return s_hash_union_ne(mflavor, t1, t2);
+    }
+
+    Allocator::GlobalAllocator.pushTempRootScope();
+
+    s_union_merge_entries(mflavor, t1, t2);
+
+    auto lstart = Allocator::GlobalAllocator.getTempRootCurrScopeBegin();
+    auto lsize = Allocator::GlobalAllocator.getTempRootCurrScopeSize();
+    BSQ_INTERNAL_ASSERT(lsize == ccount);
+
+    void* res = BSQMapOps::s_temp_root_to_map_ne(mflavor, lstart, lsize);
+
+    Allocator::GlobalAllocator.popTempRootScope();
+    return res;
+}
+
+std::pair<void*, BSQNat> BSQMapOps::s_submap_ne(const BSQMapTypeFlavor& mflavor, LambdaEvalThunk ee, void* t, const BSQMapTreeType* ttype, const BSQPCode* pred, StorageLocationSpan params)
+{
+    if(mflavor.hashleaftype != nullptr)
+    {
+        return s_hash_submap_ne(mflavor, ee, t, pred, params);
+    }
+
+    Allocator::GlobalAllocator.pushTempRootScope();
+
+    BSQMapSpineIterator iter(ttype, t);
+    Allocator::GlobalAllocator.registerCollectionIterator(&iter);
+
+    const BSQInvokeBodyDecl* icall = dynamic_cast<const BSQInvokeBodyDecl*>(BSQInvokeDecl::g_invokes[pred->code]);
+
+    {
+        BI_LAMBDA_CALL_SETUP_KV_TEMP(mflavor.keytype, ksl, mflavor.valuetype, vsl, params, pred, lparams)
+
+        BSQMapOps::map_tree_flatten(mflavor, iter, [&](StorageLocationPtr lk, StorageLocationPtr lv) { 
+            mflavor.keytype->storeValue(ksl, lk);
+            mflavor.valuetype->storeValue(vsl, lv);
+
+            BSQBool bb = BSQFALSE;
+            ee.invoke(icall, lparams, &bb);
+
+            mflavor.keytype->clearValue(ksl);
+            mflavor.valuetype->clearValue(vsl);
+            return (bool)bb;
+        });
+    
+        BI_LAMBDA_CALL_SETUP_POP()
+    }
+    
+    Allocator::GlobalAllocator.releaseCollectionIterator(&iter);
+
+    auto lstart = Allocator::GlobalAllocator.getTempRootCurrScopeBegin();
+    auto lsize = Allocator::GlobalAllocator.getTempRootCurrScopeSize();
+    auto llnode = BSQMapOps::s_temp_root_to_map_ne(mflavor, lstart, lsize);
+
+    Allocator::GlobalAllocator.popTempRootScope();
+
+    return std::make_pair(llnode, (BSQNat)lsize);
+}
+
+void* BSQMapOps::s_remap_ne(const BSQMapTypeFlavor& mflavor, LambdaEvalThunk ee, void* t, const BSQMapTreeType* ttype, const BSQPCode* fn, StorageLocationSpan params, const BSQMapTypeFlavor& resflavor)
+{
+    if(mflavor.hashleaftype != nullptr)
+    {
+        return s_hash_remap_ne(mflavor, ee, t, fn, params, resflavor);
+    }
+
+    auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
+    auto rnode = Allocator::GlobalAllocator.registerCollectionNode(static_cast<BSQMapTreeRepr*>(t));
+
+    const BSQInvokeBodyDecl* icall = dynamic_cast<const BSQInvokeBodyDecl*>(BSQInvokeDecl::g_invokes[fn->code]);
+
+    void* rres = nullptr;
+    {
+        BI_LAMBDA_CALL_SETUP_KV_TEMP_AND_RES(mflavor.keytype, ksl, mflavor.valuetype, vsl, resflavor.valuetype, resl, params, fn, lparams)
+
+        rres = BSQMapOps::map_tree_transform(mflavor, rnode, [&](BSQCollectionGCReprNode* reprnode, BSQCollectionGCReprNode* ll, BSQCollectionGCReprNode* rr) {
+            mflavor.keytype->storeValue(ksl, mflavor.treetype->getKeyLocation(reprnode->repr));
+            mflavor.valuetype->storeValue(vsl, mflavor.treetype->getValueLocation(reprnode->repr));
+            ee.invoke(icall, lparams, resl);
+
+            void* tinto = (void*)Allocator::GlobalAllocator.allocateDynamic(resflavor.treetype);
+            resflavor.treetype->initializeLR(tinto, mflavor.treetype->getKeyLocation(reprnode->repr), mflavor.keytype, resl, resflavor.valuetype, ll->repr, rr->repr);
+
+            mflavor.keytype->clearValue(ksl);
+            mflavor.valuetype->clearValue(vsl);
+            resflavor.valuetype->clearValue(resl);
+            return tinto;
+        });
+    
+        BI_LAMBDA_CALL_SETUP_POP()
+    }
+
+    Allocator::GlobalAllocator.resetCollectionNodeEnd(gcpoint);
+    return rres;
+}
+
+//Every op reserves this much per level of the path (the copied node plus up to 2 more from a double rotation) so all the allocation can be done after the single ensureSpace at the bottom
+#define MAP_TREE_LEVEL_ALLOC(MFLAVOR) (3 * ((MFLAVOR).treetype->allocinfo.heapsize + sizeof(GC_META_DATA_WORD)))
+
+void* s_map_node_ne(const BSQMapTypeFlavor& mflavor, StorageLocationPtr kl, StorageLocationPtr vl, void* l, void* r)
+{
+    void* res = Allocator::GlobalAllocator.allocateSafe(mflavor.treetype);
+    mflavor.treetype->initializeLR(res, kl, mflavor.keytype, vl, mflavor.valuetype, l, r);
+
+    return res;
+}
+
+void* s_map_node_copy_ne(const BSQMapTypeFlavor& mflavor, void* kvnode, void* l, void* r)
+{
+    return s_map_node_ne(mflavor, mflavor.treetype->getKeyLocation(kvnode), mflavor.treetype->getValueLocation(kvnode), l, r);
+}
+
+//Build the node for kl/vl over l and r where at most one of l/r changed by one element since they were balanced (so a single or double rotation is enough)
+void* s_map_balance_ne(const BSQMapTypeFlavor& mflavor, StorageLocationPtr kl, StorageLocationPtr vl, void* l, void* r)
+{
+    if(!BSQMapTreeType::isBalanced(l, r))
+    {
+        void* rl = BSQMapTreeType::getLeft(r);
+        void* rr = BSQMapTreeType::getRight(r);
+        if(BSQMapTreeType::isSingleRotation(rl, rr))
+        {
+            return s_map_node_copy_ne(mflavor, r, s_map_node_ne(mflavor, kl, vl, l, rl), rr);
+        }
+        else
+        {
+            return s_map_node_copy_ne(mflavor, rl, s_map_node_ne(mflavor, kl, vl, l, BSQMapTreeType::getLeft(rl)), s_map_node_copy_ne(mflavor, r, BSQMapTreeType::getRight(rl), rr));
+        }
+    }
+    else if(!BSQMapTreeType::isBalanced(r, l))
+    {
+        void* ll = BSQMapTreeType::getLeft(l);
+        void* lr = BSQMapTreeType::getRight(l);
+        if(BSQMapTreeType::isSingleRotation(lr, ll))
+        {
+            return s_map_node_copy_ne(mflavor, l, ll, s_map_node_ne(mflavor, kl, vl, lr, r));
+        }
+        else
+        {
+            return s_map_node_copy_ne(mflavor, lr, s_map_node_copy_ne(mflavor, l, ll, BSQMapTreeType::getLeft(lr)), s_map_node_ne(mflavor, kl, vl, BSQMapTreeType::getRight(lr), r));
+        }
+    }
+    else
+    {
+        return s_map_node_ne(mflavor, kl, vl, l, r);
+    }
+}
+
+void* s_add_ne_rec(const BSQMapTypeFlavor& mflavor, BSQMapSpineIterator& iter, StorageLocationPtr kl, StorageLocationPtr vl, uint32_t alloc)
+{
+    void* res = nullptr;
+
+    if(iter.lcurr == nullptr)
+    {
+        Allocator::GlobalAllocator.ensureSpace(alloc + mflavor.treetype->allocinfo.heapsize + sizeof(GC_META_DATA_WORD));
+        res = Allocator::GlobalAllocator.allocateSafe(mflavor.treetype);
+        mflavor.treetype->initializeLeaf(res, kl, mflavor.keytype, vl, mflavor.valuetype);
+    }
+    else
+    {
+        auto nalloc = alloc + MAP_TREE_LEVEL_ALLOC(mflavor);
+
+        auto ck = mflavor.treetype->getKeyLocation(iter.lcurr);
+        if(mflavor.keytype->fpkeycmp(mflavor.keytype, kl, ck) < 0)
+        {
+            iter.moveLeft();
+            void* ll = s_add_ne_rec(mflavor, iter, kl, vl, nalloc);
+            iter.pop();
+
+            res = s_map_balance_ne(mflavor, mflavor.treetype->getKeyLocation(iter.lcurr), mflavor.treetype->getValueLocation(iter.lcurr), ll, BSQMapTreeType::getRight(iter.lcurr));
+        }
+        else
+        {
+            BSQ_INTERNAL_ASSERT(mflavor.keytype->fpkeycmp(mflavor.keytype, ck, kl) < 0);
+
+            iter.moveRight();
+            void* rr = s_add_ne_rec(mflavor, iter, kl, vl, nalloc);
+            iter.pop();
+
+            res = s_map_balance_ne(mflavor, mflavor.treetype->getKeyLocation(iter.lcurr), mflavor.treetype->getValueLocation(iter.lcurr), BSQMapTreeType::getLeft(iter.lcurr), rr);
+        }
+    }
+
+    return res;
+}
+
+void* BSQMapOps::s_add_ne(const BSQMapTypeFlavor& mflavor, void* t, const BSQMapTreeType* ttype, StorageLocationPtr kl, StorageLocationPtr vl)
+{
+    if(mflavor.hashleaftype != nullptr)
+    {
+        return BSQMapOps::s_hash_add_ne(mflavor, t, kl, vl, false);
+    }
+
+    BSQMapSpineIterator iter(ttype, t);
+    Allocator::GlobalAllocator.registerCollectionIterator(&iter);
+
+    void* res = s_add_ne_rec(mflavor, iter, kl, vl, 0);
+
+    Allocator::GlobalAllocator.releaseCollectionIterator(&iter);
+    return res;
+}
+
+void* s_set_ne_rec(const BSQMapTypeFlavor& mflavor, BSQMapSpineIterator& iter, StorageLocationPtr kl, StorageLocationPtr vl, uint32_t alloc)
+{
+    BSQ_INTERNAL_ASSERT(iter.lcurr != nullptr);
+
+    void* res;
+    auto nalloc = alloc + mflavor.treetype->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
+
+    auto ck = mflavor.treetype->getKeyLocation(iter.lcurr);
+    if(mflavor.keytype->fpkeycmp(mflavor.keytype, kl, ck) < 0)
+    {
+        iter.moveLeft();
+        void* ll = s_set_ne_rec(mflavor, iter, kl, vl, nalloc);
+        iter.pop();
+
+        res = s_map_node_copy_ne(mflavor, iter.lcurr, ll, BSQMapTreeType::getRight(iter.lcurr));
+    }
+    else if(mflavor.keytype->fpkeycmp(mflavor.keytype, ck, kl) < 0)
+    {
+        iter.moveRight();
+        void* rr = s_set_ne_rec(mflavor, iter, kl, vl, nalloc);
+        iter.pop();
+
+        res = s_map_node_copy_ne(mflavor, iter.lcurr, BSQMapTreeType::getLeft(iter.lcurr), rr);
+    }
+    else
+    {
+        Allocator::GlobalAllocator.ensureSpace(nalloc);
+        res = s_map_node_ne(mflavor, kl, vl, BSQMapTreeType::getLeft(iter.lcurr), BSQMapTreeType::getRight(iter.lcurr));
+    }
+
+    return res;
+}
+
+void* BSQMapOps::s_set_ne(const BSQMapTypeFlavor& mflavor, void* t, const BSQMapTreeType* ttype, StorageLocationPtr kl, StorageLocationPtr vl)
+{
+    if(mflavor.hashleaftype != nullptr)
+    {
+        return BSQMapOps::s_hash_add_ne(mflavor, t, kl, vl, true);
+    }
+
+    BSQMapSpineIterator iter(ttype, t);
+    Allocator::GlobalAllocator.registerCollectionIterator(&iter);
+
+    void* res = s_set_ne_rec(mflavor, iter, kl, vl, 0);
+
+    Allocator::GlobalAllocator.releaseCollectionIterator(&iter);
+    return res;
+}
+
+//Remove the min (or max) element of the subtree -- returns the new subtree and the (old) node that held the element
+std::pair<void*, void*> s_remove_extreme_ne_rec(const BSQMapTypeFlavor& mflavor, BSQMapSpineIterator& iter, bool minelem, uint32_t alloc)
+{
+    BSQ_INTERNAL_ASSERT(iter.lcurr != nullptr);
+
+    std::pair<void*, void*> res;
+    void* next = minelem ? BSQMapTreeType::getLeft(iter.lcurr) : BSQMapTreeType::getRight(iter.lcurr);
+    if(next != nullptr)
+    {
+        auto nalloc = alloc + MAP_TREE_LEVEL_ALLOC(mflavor);
+
+        if(minelem)
+        {
+            iter.moveLeft();
+        }
+        else
+        {
+            iter.moveRight();
+        }
+        auto tnp = s_remove_extreme_ne_rec(mflavor, iter, minelem, nalloc);
+        iter.pop();
+
+        auto ckl = mflavor.treetype->getKeyLocation(iter.lcurr);
+        auto cvl = mflavor.treetype->getValueLocation(iter.lcurr);
+        if(minelem)
+        {
+            res = std::make_pair(s_map_balance_ne(mflavor, ckl, cvl, tnp.first, BSQMapTreeType::getRight(iter.lcurr)), tnp.second);
+        }
+        else
+        {
+            res = std::make_pair(s_map_balance_ne(mflavor, ckl, cvl, BSQMapTreeType::getLeft(iter.lcurr), tnp.first), tnp.second);
+        }
+    }
+    else
+    {
+        Allocator::GlobalAllocator.ensureSpace(alloc);
+        res = std::make_pair(minelem ? BSQMapTreeType::getRight(iter.lcurr) : BSQMapTreeType::getLeft(iter.lcurr), iter.lcurr);
+    }
+
+    return res;
+}
+
+void* s_remove_find_ne_rec(const BSQMapTypeFlavor& mflavor, BSQMapSpineIterator& iter, StorageLocationPtr kl, uint32_t alloc)
+{
+    BSQ_INTERNAL_ASSERT(iter.lcurr != nullptr);
+
+    void* res;
+    auto nalloc = alloc + MAP_TREE_LEVEL_ALLOC(mflavor);
+
+    auto ck = mflavor.treetype->getKeyLocation(iter.lcurr);
+    if(mflavor.keytype->fpkeycmp(mflavor.keytype, kl, ck) < 0)
+    {
+        iter.moveLeft();
+        void* ll = s_remove_find_ne_rec(mflavor, iter, kl, nalloc);
+        iter.pop();
+
+        res = s_map_balance_ne(mflavor, mflavor.treetype->getKeyLocation(iter.lcurr), mflavor.treetype->getValueLocation(iter.lcurr), ll, BSQMapTreeType::getRight(iter.lcurr));
+    }
+    else if(mflavor.keytype->fpkeycmp(mflavor.keytype, ck, kl) < 0)
+    {
+        iter.moveRight();
+        void* rr = s_remove_find_ne_rec(mflavor, iter, kl, nalloc);
+        iter.pop();
+
+        res = s_map_balance_ne(mflavor, mflavor.treetype->getKeyLocation(iter.lcurr), mflavor.treetype->getValueLocation(iter.lcurr), BSQMapTreeType::getLeft(iter.lcurr), rr);
+    }
+    else
+    {
+        auto lltmp = BSQMapTreeType::getLeft(iter.lcurr);
+        auto rrtmp = BSQMapTreeType::getRight(iter.lcurr);
+        if(lltmp == nullptr || rrtmp == nullptr)
+        {
+            Allocator::GlobalAllocator.ensureSpace(alloc);
+            res = (lltmp != nullptr) ? BSQMapTreeType::getLeft(iter.lcurr) : BSQMapTreeType::getRight(iter.lcurr);
+        }
+        else if(BSQMapTreeType::getSize(lltmp) > BSQMapTreeType::getSize(rrtmp))
+        {
+            //replace with the max of the heavier left side
+            iter.moveLeft();
+            auto tnp = s_remove_extreme_ne_rec(mflavor, iter, false, nalloc);
+            iter.pop();
+
+            res = s_map_balance_ne(mflavor, mflavor.treetype->getKeyLocation(tnp.second), mflavor.treetype->getValueLocation(tnp.second), tnp.first, BSQMapTreeType::getRight(iter.lcurr));
+        }
+        else
+        {
+            iter.moveRight();
+            auto tnp = s_remove_extreme_ne_rec(mflavor, iter, true, nalloc);
+            iter.pop();
+
+            res = s_map_balance_ne(mflavor, mflavor.treetype->getKeyLocation(tnp.second), mflavor.treetype->getValueLocation(tnp.second), BSQMapTreeType::getLeft(iter.lcurr), tnp.first);
+        }
+    }
+
+    return res;
+}
+
+void* BSQMapOps::s_remove_ne(const BSQMapTypeFlavor& mflavor, void* t, const BSQMapTreeType* ttype, StorageLocationPtr kl)
+{
+    if(mflavor.hashleaftype != nullptr)
+    {
+        return BSQMapOps::s_hash_remove_ne(mflavor, t, kl);
+    }
+
+    BSQMapSpineIterator iter(ttype, t);
+    Allocator::GlobalAllocator.registerCollectionIterator(&iter);
+
+    void* res = s_remove_find_ne_rec(mflavor, iter, kl, 0);
+
+    Allocator::GlobalAllocator.releaseCollectionIterator(&iter);
+    return res;
+}
+
+//Every update copies at most one node per level (and a merge of two chains adds at most one node per level below that) -- the hashes are 64 bits so there are at most this many levels
+#define MAP_HASH_MAX_DEPTH ((64 + BSQ_MAP_HASH_BITS - 1) / BSQ_MAP_HASH_BITS)
+#define MAP_HASH_NODE_ALLOC(WIDTH) (sizeof(uint64_t) + (WIDTH) * sizeof(void*) + sizeof(GC_META_DATA_WORD))
+#define MAP_HASH_LEAF_ALLOC(MFLAVOR) ((MFLAVOR).hashleaftype->allocinfo.heapsize + sizeof(GC_META_DATA_WORD))
+
+const BSQMapHashNodeType* BSQMapOps::g_hashnodetypes[BSQ_MAP_HASH_WIDTH + 1] = {nullptr};
+
+void* s_hash_leaf_ne(const BSQMapTypeFlavor& mflavor, uint64_t hh, StorageLocationPtr kl, StorageLocationPtr vl, void* next)
+{
+    void* res = Allocator::GlobalAllocator.allocateSafe(mflavor.hashleaftype);
+    mflavor.hashleaftype->initialize(res, hh, kl, mflavor.keytype, vl, mflavor.valuetype, next);
+
+    return res;
+}
+
+void* s_hash_node_ne(uint64_t bitmap, uint32_t width)
+{
+    void* res = Allocator::GlobalAllocator.allocateSafe(BSQMapOps::g_hashnodetypes[width]);
+    ((BSQMapHashNodeRepr*)res)->bitmap = bitmap;
+
+    return res;
+}
+
+void* s_hash_node_replace_ne(void* node, uint64_t bitmap, uint32_t idx, void* child)
+{
+    auto width = BSQMapHashNodeType::getWidth(node);
+    void* res = s_hash_node_ne(bitmap, width);
+
+    void** children = BSQMapHashNodeType::getChildren(res);
+    GC_MEM_COPY(children, BSQMapHashNodeType::getChildren(node), width * sizeof(void*));
+    children[idx] = child;
+
+    return res;
+}
+
+void* s_hash_node_insert_ne(void* node, uint64_t bitmap, uint32_t idx, void* child)
+{
+    auto width = BSQMapHashNodeType::getWidth(node);
+    void* res = s_hash_node_ne(bitmap, width + 1);
+
+    void** children = BSQMapHashNodeType::getChildren(res);
+    void** ochildren = BSQMapHashNodeType::getChildren(node);
+    GC_MEM_COPY(children, ochildren, idx * sizeof(void*));
+    children[idx] = child;
+    GC_MEM_COPY((children + idx + 1), (ochildren + idx), (width - idx) * sizeof(void*));
+
+    return res;
+}
+
+void* s_hash_node_remove_ne(void* node, uint64_t bitmap, uint32_t idx)
+{
+    auto width = BSQMapHashNodeType::getWidth(node);
+    void* res = s_hash_node_ne(bitmap, width - 1);
+
+    void** children = BSQMapHashNodeType::getChildren(res);
+    void** ochildren = BSQMapHashNodeType::getChildren(node);
+    GC_MEM_COPY(children, ochildren, idx * sizeof(void*));
+    GC_MEM_COPY((children + idx), (ochildren + idx + 1), (width - idx - 1) * sizeof(void*));
+
+    return res;
+}
+
+//Push two chains with different hashes down until their positions differ
+void* s_hash_merge_ne(void* chain1, uint64_t hh1, void* chain2, uint64_t hh2, uint32_t shift)
+{
+    auto pos1 = BSQ_MAP_HASH_POS(hh1, shift);
+    auto pos2 = BSQ_MAP_HASH_POS(hh2, shift);
+
+    if(pos1 == pos2)
+    {
+        void* sub = s_hash_merge_ne(chain1, hh1, chain2, hh2, shift + BSQ_MAP_HASH_BITS);
+
+        void* res = s_hash_node_ne((uint64_t)(1u << pos1) << 32, 1);
+        BSQMapHashNodeType::getChildren(res)[0] = sub;
+        return res;
+    }
+    else
+    {
+        void* res = s_hash_node_ne((1u << pos1) | (1u << pos2), 2);
+        BSQMapHashNodeType::getChildren(res)[0] = (pos1 < pos2) ? chain1 : chain2;
+        BSQMapHashNodeType::getChildren(res)[1] = (pos1 < pos2) ? chain2 : chain1;
+        return res;
+    }
+}
+
+//Number of leaves in the chain with the full hash hh (0 if there is none) -- used to size the allocation before an update
+size_t s_hash_chain_length(void* t, uint64_t hh)
+{
+    void* curr = t;
+    uint32_t shift = 0;
+    while(true)
+    {
+        uint64_t bitmap = BSQMapHashNodeType::getBitmap(curr);
+        uint32_t pos = BSQ_MAP_HASH_POS(hh, shift);
+        uint32_t bit = 1u << pos;
+
+        if(BSQ_MAP_HASH_DATAMAP(bitmap) & bit)
+        {
+            void* leaf = BSQMapHashNodeType::getChildren(curr)[BSQMapHashNodeType::childIndex(bitmap, pos)];
+            if(BSQMapHashLeafType::getHash(leaf) != hh)
+            {
+                return 0;
+            }
+
+            size_t count = 0;
+            while(leaf != nullptr)
+            {
+                count++;
+                leaf = BSQMapHashLeafType::getNext(leaf);
+            }
+            return count;
+        }
+        else if(BSQ_MAP_HASH_NODEMAP(bitmap) & bit)
+        {
+            curr = BSQMapHashNodeType::getChildren(curr)[BSQMapHashNodeType::childIndex(bitmap, pos)];
+            shift += BSQ_MAP_HASH_BITS;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+}
+
+//Copy of the chain with the entry for kl replaced (or removed if vl is null)
+void* s_hash_chain_update_ne(const BSQMapTypeFlavor& mflavor, void* chain, StorageLocationPtr kl, StorageLocationPtr vl)
 {
-    if(BSQMapTreeType::getLeft(ii.lcurr) != nullptr)
+    BSQ_INTERNAL_ASSERT(chain != nullptr);
+
+    if(mflavor.keytype->fpkeycmp(mflavor.keytype, kl, mflavor.hashleaftype->getKeyLocation(chain)) == 0)
     {
-        ii.moveLeft();
-        s_union_rec_ne(mflavor, tnode, ii);
-        ii.pop();
+        if(vl == nullptr)
+        {
+            return BSQMapHashLeafType::getNext(chain);
+        }
+        else
+        {
+            return s_hash_leaf_ne(mflavor, BSQMapHashLeafType::getHash(chain), kl, vl, BSQMapHashLeafType::getNext(chain));
+        }
     }
-
-    auto tmpi = SLPTR_LOAD_CONTENTS_AS_GENERIC_HEAPOBJ(tnode);
-    auto tmpr = BSQMapOps::s_add_ne(mflavor, tmpi, mflavor.treetype, mflavor.treetype->getKeyLocation(ii.lcurr), mflavor.treetype->getKeyLocation(ii.lcurr));
-    SLPTR_STORE_CONTENTS_AS_GENERIC_HEAPOBJ(tnode, tmpr);
-
-    if(BSQMapTreeType::getRight(ii.lcurr) != nullptr)
+    else
     {
-        ii.moveRight();
-        s_union_rec_ne(mflavor, tnode, ii);
-        ii.pop();
+        void* rest = s_hash_chain_update_ne(mflavor, BSQMapHashLeafType::getNext(chain), kl, vl);
+        return s_hash_leaf_ne(mflavor, BSQMapHashLeafType::getHash(chain), mflavor.hashleaftype->getKeyLocation(chain), mflavor.hashleaftype->getValueLocation(chain), rest);
     }
 }
 
-void* BSQMapOps::s_union_ne(const BSQMapTypeFlavor& mflavor, void* t1, const BSQMapTreeType* ttype1, void* t2, const BSQMapTreeType* ttype2, uint64_t ccount)
+void* s_hash_add_ne_rec(const BSQMapTypeFlavor& mflavor, void* node, uint32_t shift, uint64_t hh, StorageLocationPtr kl, StorageLocationPtr vl, bool replace)
 {
-    void* ll = t1;
-    GCStack::pushFrame(&ll, "2");
+    uint64_t bitmap = BSQMapHashNodeType::getBitmap(node);
+    uint32_t pos = BSQ_MAP_HASH_POS(hh, shift);
+    uint32_t bit = 1u << pos;
+    uint32_t idx = BSQMapHashNodeType::childIndex(bitmap, pos);
 
-    BSQMapSpineIterator iter2(ttype2, t2);
-    Allocator::GlobalAllocator.registerCollectionIterator(&iter2);
-    s_union_rec_ne(mflavor, &ll, iter2);
-    Allocator::GlobalAllocator.releaseCollectionIterator(&iter2);
+    if(BSQ_MAP_HASH_DATAMAP(bitmap) & bit)
+    {
+        void* chain = BSQMapHashNodeType::getChildren(node)[idx];
+        if(BSQMapHashLeafType::getHash(chain) == hh)
+        {
+            void* nchain = replace ? s_hash_chain_update_ne(mflavor, chain, kl, vl) : s_hash_leaf_ne(mflavor, hh, kl, vl, chain);
+            return s_hash_node_replace_ne(node, bitmap, idx, nchain);
+        }
+        else
+        {
+            BSQ_INTERNAL_ASSERT(!replace);
 
-    GCStack::popFrame();
-    return ll;
+            void* leaf = s_hash_leaf_ne(mflavor, hh, kl, vl, nullptr);
+            void* sub = s_hash_merge_ne(chain, BSQMapHashLeafType::getHash(chain), leaf, hh, shift + BSQ_MAP_HASH_BITS);
+            return s_hash_node_replace_ne(node, bitmap ^ bit ^ ((uint64_t)bit << 32), idx, sub);
+        }
+    }
+    else if(BSQ_MAP_HASH_NODEMAP(bitmap) & bit)
+    {
+        void* sub = s_hash_add_ne_rec(mflavor, BSQMapHashNodeType::getChildren(node)[idx], shift + BSQ_MAP_HASH_BITS, hh, kl, vl, replace);
+        return s_hash_node_replace_ne(node, bitmap, idx, sub);
+    }
+    else
+    {
+        BSQ_INTERNAL_ASSERT(!replace);
+
+        void* leaf = s_hash_leaf_ne(mflavor, hh, kl, vl, nullptr);
+        return s_hash_node_insert_ne(node, bitmap | bit, idx, leaf);
+    }
 }
 
-std::pair<void*, BSQNat> BSQMapOps::s_submap_ne(const BSQMapTypeFlavor& mflavor, LambdaEvalThunk ee, void* t, const BSQMapTreeType* ttype, const BSQPCode* pred, const std::vector<StorageLocationPtr>& params)
+void* BSQMapOps::s_hash_add_ne(const BSQMapTypeFlavor& mflavor, void* t, StorageLocationPtr kl, StorageLocationPtr vl, bool replace)
 {
-    Allocator::GlobalAllocator.pushTempRootScope();
-
-    BSQMapSpineIterator iter(ttype, t);
-    Allocator::GlobalAllocator.registerCollectionIterator(&iter);
-
-    const BSQInvokeBodyDecl* icall = dynamic_cast<const BSQInvokeBodyDecl*>(BSQInvokeDecl::g_invokes[pred->code]);
+    uint64_t hh = mflavor.keytype->fpkeyhash(mflavor.keytype, kl);
+    size_t chainlen = (t != nullptr) ? s_hash_chain_length(t, hh) : 0;
+    size_t alloc = MAP_HASH_MAX_DEPTH * (MAP_HASH_NODE_ALLOC(BSQ_MAP_HASH_WIDTH) + MAP_HASH_NODE_ALLOC(2)) + (chainlen + 1) * MAP_HASH_LEAF_ALLOC(mflavor);
 
+    void* res = nullptr;
+    if(t == nullptr)
     {
-        BI_LAMBDA_CALL_SETUP_KV_TEMP(mflavor.keytype, ksl, mflavor.valuetype, vsl, params, pred, lparams)
-
-        BSQMapOps::map_tree_flatten(mflavor, iter, [&](StorageLocationPtr lk, StorageLocationPtr lv) { 
-            mflavor.keytype->storeValue(ksl, lk);
-            mflavor.valuetype->storeValue(vsl, lv);
-
-            BSQBool bb = BSQFALSE;
-            ee.invoke(icall, lparams, &bb);
+        Allocator::GlobalAllocator.ensureSpace(alloc);
 
-            mflavor.keytype->clearValue(ksl);
-            mflavor.valuetype->clearValue(vsl);
-            return (bool)bb;
-        });
-    
-        BI_LAMBDA_CALL_SETUP_POP()
+        void* leaf = s_hash_leaf_ne(mflavor, hh, kl, vl, nullptr);
+        res = s_hash_node_ne(1u << BSQ_MAP_HASH_POS(hh, 0), 1);
+        BSQMapHashNodeType::getChildren(res)[0] = leaf;
     }
-    
-    Allocator::GlobalAllocator.releaseCollectionIterator(&iter);
-
-    auto lstart = Allocator::GlobalAllocator.getTempRootCurrScope().begin();
-    auto lsize = Allocator::GlobalAllocator.getTempRootCurrScope().size();
-    auto llnode = BSQMapOps::s_temp_root_to_map_rec(mflavor, lstart, lsize);
+    else
+    {
+        auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
+        auto tnode = Allocator::GlobalAllocator.registerCollectionNode(t);
+        Allocator::GlobalAllocator.ensureSpace(alloc);
 
-    Allocator::GlobalAllocator.pushTempRootScope();
+        res = s_hash_add_ne_rec(mflavor, tnode->repr, 0, hh, kl, vl, replace);
+        Allocator::GlobalAllocator.resetCollectionNodeEnd(gcpoint);
+    }
 
-    return std::make_pair(llnode, (BSQNat)lsize);
+    return res;
 }
 
-void* BSQMapOps::s_remap_ne(const BSQMapTypeFlavor& mflavor, LambdaEvalThunk ee, void* t, const BSQMapTreeType* ttype, const BSQPCode* fn, const std::vector<StorageLocationPtr>& params, const BSQMapTypeFlavor& resflavor)
+void* s_hash_remove_ne_rec(const BSQMapTypeFlavor& mflavor, void* node, uint32_t shift, uint64_t hh, StorageLocationPtr kl)
 {
-    auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
-    auto rnode = Allocator::GlobalAllocator.registerCollectionNode(static_cast<BSQMapTreeRepr*>(t));
-
-    const BSQInvokeBodyDecl* icall = dynamic_cast<const BSQInvokeBodyDecl*>(BSQInvokeDecl::g_invokes[fn->code]);
+    uint64_t bitmap = BSQMapHashNodeType::getBitmap(node);
+    uint32_t pos = BSQ_MAP_HASH_POS(hh, shift);
+    uint32_t bit = 1u << pos;
+    uint32_t idx = BSQMapHashNodeType::childIndex(bitmap, pos);
 
-    void* rres = nullptr;
+    void* nchild = nullptr;
+    if(BSQ_MAP_HASH_DATAMAP(bitmap) & bit)
     {
-        BI_LAMBDA_CALL_SETUP_KV_TEMP_AND_RES(mflavor.keytype, ksl, mflavor.valuetype, vsl, resflavor.valuetype, resl, params, fn, lparams)
-
-        rres = BSQMapOps::map_tree_transform(mflavor, rnode, [&](BSQCollectionGCReprNode* reprnode, BSQCollectionGCReprNode* ll, BSQCollectionGCReprNode* rr) {
-            mflavor.keytype->storeValue(ksl, mflavor.treetype->getKeyLocation(reprnode->repr));
-            mflavor.valuetype->storeValue(vsl, mflavor.treetype->getValueLocation(reprnode->repr));
-            ee.invoke(icall, lparams, resl);
+        nchild = s_hash_chain_update_ne(mflavor, BSQMapHashNodeType::getChildren(node)[idx], kl, nullptr);
+    }
+    else
+    {
+        BSQ_INTERNAL_ASSERT(BSQ_MAP_HASH_NODEMAP(bitmap) & bit);
 
-            void* tinto = (void*)Allocator::GlobalAllocator.allocateDynamic(resflavor.treetype);
-            resflavor.treetype->initializeLR(tinto, mflavor.treetype->getKeyLocation(reprnode->repr), mflavor.keytype, resl, resflavor.valuetype, ll->repr, rr->repr);
+        nchild = s_hash_remove_ne_rec(mflavor, BSQMapHashNodeType::getChildren(node)[idx], shift + BSQ_MAP_HASH_BITS, hh, kl);
+        if(nchild != nullptr && BSQ_MAP_HASH_NODEMAP(BSQMapHashNodeType::getBitmap(nchild)) == 0 && BSQMapHashNodeType::getWidth(nchild) == 1)
+        {
+            //a sub node that is down to a single chain is pulled up into this node
+            return s_hash_node_replace_ne(node, bitmap ^ ((uint64_t)bit << 32) ^ bit, idx, BSQMapHashNodeType::getChildren(nchild)[0]);
+        }
+    }
 
-            mflavor.keytype->clearValue(ksl);
-            mflavor.valuetype->clearValue(vsl);
-            resflavor.valuetype->clearValue(resl);
-            return tinto;
-        });
-    
-        BI_LAMBDA_CALL_SETUP_POP()
+    if(nchild != nullptr)
+    {
+        return s_hash_node_replace_ne(node, bitmap, idx, nchild);
+    }
+    else if(BSQMapHashNodeType::getWidth(node) == 1)
+    {
+        return nullptr;
     }
+    else
+    {
+        return s_hash_node_remove_ne(node, bitmap & ~((uint64_t)bit | ((uint64_t)bit << 32)), idx);
+    }
+}
+
+void* BSQMapOps::s_hash_remove_ne(const BSQMapTypeFlavor& mflavor, void* t, StorageLocationPtr kl)
+{
+    uint64_t hh = mflavor.keytype->fpkeyhash(mflavor.keytype, kl);
+    size_t chainlen = s_hash_chain_length(t, hh);
+    size_t alloc = MAP_HASH_MAX_DEPTH * MAP_HASH_NODE_ALLOC(BSQ_MAP_HASH_WIDTH) + chainlen * MAP_HASH_LEAF_ALLOC(mflavor);
+
+    auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
+    auto tnode = Allocator::GlobalAllocator.registerCollectionNode(t);
+    Allocator::GlobalAllocator.ensureSpace(alloc);
 
+    void* res = s_hash_remove_ne_rec(mflavor, tnode->repr, 0, hh, kl);
     Allocator::GlobalAllocator.resetCollectionNodeEnd(gcpoint);
-    return rres;
+
+    return res;
 }
 
-void* s_add_ne_rec(const BSQMapTypeFlavor& mflavor, BSQMapSpineIterator& iter, StorageLocationPtr kl, StorageLocationPtr vl, uint32_t alloc)
+void s_hash_leaves_rec(void* node, std::vector<void*>& leaves)
 {
-    void* res = nullptr;
+    uint64_t bitmap = BSQMapHashNodeType::getBitmap(node);
+    void** children = BSQMapHashNodeType::getChildren(node);
 
-    if(iter.lcurr == nullptr)
-    {
-        Allocator::GlobalAllocator.ensureSpace(alloc);
-        res = Allocator::GlobalAllocator.allocateSafe(mflavor.treetype);
-        mflavor.treetype->initializeLeaf(res, kl, mflavor.keytype, vl, mflavor.valuetype);
-    }
-    else
+    for(uint32_t pos = 0; pos < BSQ_MAP_HASH_WIDTH; ++pos)
     {
-        auto nalloc = alloc + mflavor.treetype->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
-
-        auto ck = mflavor.treetype->getKeyLocation(iter.lcurr);
-        if(mflavor.keytype->fpkeycmp(mflavor.keytype, kl, ck) < 0)
+        uint32_t bit = 1u << pos;
+        if(BSQ_MAP_HASH_DATAMAP(bitmap) & bit)
         {
-            iter.moveLeft();
-            void* ll = s_add_ne_rec(mflavor, iter, kl, vl, nalloc);
-            iter.pop();
-
-            res = Allocator::GlobalAllocator.allocateSafe(mflavor.treetype);
-            mflavor.treetype->initializeLR(res, mflavor.treetype->getKeyLocation(iter.lcurr), mflavor.keytype, mflavor.treetype->getValueLocation(iter.lcurr), mflavor.valuetype, ll, BSQMapTreeType::getRight(iter.lcurr));
+            for(void* leaf = *children; leaf != nullptr; leaf = BSQMapHashLeafType::getNext(leaf))
+            {
+                leaves.push_back(leaf);
+            }
+            children++;
+        }
+        else if(BSQ_MAP_HASH_NODEMAP(bitmap) & bit)
+        {
+            s_hash_leaves_rec(*children, leaves);
+            children++;
         }
         else
         {
-            BSQ_INTERNAL_ASSERT(mflavor.keytype->fpkeycmp(mflavor.keytype, ck, kl) < 0);
-
-            iter.moveRight();
-            void* rr = s_add_ne_rec(mflavor, iter, kl, vl, nalloc);
-            iter.pop();
-
-            res = Allocator::GlobalAllocator.allocateSafe(mflavor.treetype);
-            mflavor.treetype->initializeLR(res, mflavor.treetype->getKeyLocation(iter.lcurr), mflavor.keytype, mflavor.treetype->getValueLocation(iter.lcurr), mflavor.valuetype, BSQMapTreeType::getLeft(iter.lcurr), rr);
+            ;
         }
     }
-
-    return res;
 }
 
-void* BSQMapOps::s_add_ne(const BSQMapTypeFlavor& mflavor, void* t, const BSQMapTreeType* ttype, StorageLocationPtr kl, StorageLocationPtr vl)
+void BSQMapOps::s_hash_leaves_sorted(const BSQMapTypeFlavor& mflavor, void* t, std::vector<void*>& leaves)
 {
-    BSQMapSpineIterator iter(ttype, t);
-    Allocator::GlobalAllocator.registerCollectionIterator(&iter);
-
-    void* res = s_add_ne_rec(mflavor, iter, kl, vl, 0);
+    s_hash_leaves_rec(t, leaves);
 
-    Allocator::GlobalAllocator.releaseCollectionIterator(&iter);
-    return res;
+    std::sort(leaves.begin(), leaves.end(), [&](void* l1, void* l2) {
+        return mflavor.keytype->fpkeycmp(mflavor.keytype, mflavor.hashleaftype->getKeyLocation(l1), mflavor.hashleaftype->getKeyLocation(l2)) < 0;
+    });
 }
 
-void* s_set_ne_rec(const BSQMapTypeFlavor& mflavor, BSQMapSpineIterator& iter, StorageLocationPtr kl, StorageLocationPtr vl, uint32_t alloc)
+void BSQMapOps::s_hash_extract_entries(const BSQMapTypeFlavor& mflavor, void* t)
 {
-    BSQ_INTERNAL_ASSERT(iter.lcurr != nullptr);
+    std::vector<void*> leaves;
+    BSQMapOps::s_hash_leaves_sorted(mflavor, t, leaves);
 
-    void* res;
-    auto nalloc = alloc + mflavor.treetype->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
-
-    auto ck = mflavor.treetype->getKeyLocation(iter.lcurr);
-    if(mflavor.keytype->fpkeycmp(mflavor.keytype, kl, ck) < 0)
+    for(size_t i = 0; i < leaves.size(); ++i)
     {
-        iter.moveLeft();
-        void* ll = s_add_ne_rec(mflavor, iter, kl, vl, nalloc);
-        iter.pop();
-
-        res = Allocator::GlobalAllocator.allocateSafe(mflavor.treetype);
-        mflavor.treetype->initializeLR(res, mflavor.treetype->getKeyLocation(iter.lcurr), mflavor.keytype, mflavor.treetype->getValueLocation(iter.lcurr), mflavor.valuetype, ll, BSQMapTreeType::getRight(iter.lcurr));
+        BSQMapOps::s_entry_to_temp_root(mflavor, mflavor.hashleaftype->getKeyLocation(leaves[i]), mflavor.hashleaftype->getValueLocation(leaves[i]));
     }
-    else if(mflavor.keytype->fpkeycmp(mflavor.keytype, ck, kl) < 0)
-    {
-        iter.moveRight();
-        void* rr = s_add_ne_rec(mflavor, iter, kl, vl, nalloc);
-        iter.pop();
+}
 
-        res = Allocator::GlobalAllocator.allocateSafe(mflavor.treetype);
-        mflavor.treetype->initializeLR(res, mflavor.treetype->getKeyLocation(iter.lcurr), mflavor.keytype, mflavor.treetype->getValueLocation(iter.lcurr), mflavor.valuetype, BSQMapTreeType::getLeft(iter.lcurr), rr);
-    }
-    else
+//Add each of the [K, V] entries (locations that are not moved by a collection)
+void* s_hash_add_entries_ne(const BSQMapTypeFlavor& mflavor, void* t, const std::vector<StorageLocationPtr>& entries)
+{
+    const BSQTupleInfo* tupinfo = dynamic_cast<const BSQTupleInfo*>(mflavor.tupletype);
+
+    void* res = t;
+    for(size_t i = 0; i < entries.size(); ++i)
     {
-        Allocator::GlobalAllocator.ensureSpace(nalloc);
-        res = Allocator::GlobalAllocator.allocateSafe(mflavor.treetype);
-        mflavor.treetype->initializeLR(res, kl, mflavor.keytype, vl, mflavor.valuetype, BSQMapTreeType::getLeft(iter.lcurr), BSQMapTreeType::getRight(iter.lcurr));
+        res = BSQMapOps::s_hash_add_ne(mflavor, res, mflavor.tupletype->indexStorageLocationOffset(entries[i], tupinfo->idxoffsets[0]), mflavor.tupletype->indexStorageLocationOffset(entries[i], tupinfo->idxoffsets[1]), false);
     }
 
     return res;
 }
 
-void* BSQMapOps::s_set_ne(const BSQMapTypeFlavor& mflavor, void* t, const BSQMapTreeType* ttype, StorageLocationPtr kl, StorageLocationPtr vl)
+//The [K, V] temp roots in the current scope (the data locations do not move as more roots are registered)
+std::vector<StorageLocationPtr> s_hash_scope_entries()
 {
-    BSQMapSpineIterator iter(ttype, t);
-    Allocator::GlobalAllocator.registerCollectionIterator(&iter);
+    std::vector<StorageLocationPtr> entries;
 
-    void* res = s_set_ne_rec(mflavor, iter, kl, vl, 0);
+    auto lstart = Allocator::GlobalAllocator.getTempRootCurrScopeBegin();
+    auto lsize = Allocator::GlobalAllocator.getTempRootCurrScopeSize();
+    std::transform(lstart, lstart + lsize, std::back_inserter(entries), [](const BSQTempRootNode& rn) {
+        return (StorageLocationPtr)rn.root;
+    });
 
-    Allocator::GlobalAllocator.releaseCollectionIterator(&iter);
-    return res;
+    return entries;
 }
 
-std::pair<void*, void*> s_remove_rotate_ne_rec(const BSQMapTypeFlavor& mflavor, BSQMapSpineIterator& iter, StorageLocationPtr kl, uint32_t alloc)
+void* s_hash_union_ne(const BSQMapTypeFlavor& mflavor, void* t1, void* t2)
 {
-    BSQ_INTERNAL_ASSERT(iter.lcurr != nullptr);
-
-    std::pair<void*, void*> res;
-    if(BSQMapTreeType::getLeft(iter.lcurr) != nullptr)
-    {
-        auto nalloc = alloc + mflavor.treetype->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
+    Allocator::GlobalAllocator.pushTempRootScope();
 
-        iter.moveLeft();
-        auto tnp = s_remove_rotate_ne_rec(mflavor, iter, kl, nalloc);
-        iter.pop();
+    BSQMapOps::s_hash_extract_entries(mflavor, t2);
+    auto entries = s_hash_scope_entries();
 
-        res = std::make_pair((void*)Allocator::GlobalAllocator.allocateSafe(mflavor.treetype), tnp.second);
-        mflavor.treetype->initializeLR(res.first, mflavor.treetype->getKeyLocation(iter.lcurr), mflavor.keytype, mflavor.treetype->getValueLocation(iter.lcurr), mflavor.valuetype, tnp.first, BSQMapTreeType::getRight(iter.lcurr));
-    }
-    else
-    {
-        Allocator::GlobalAllocator.ensureSpace(alloc);
-        res = std::make_pair(nullptr, iter.lcurr);
-    }
+    void* res = s_hash_add_entries_ne(mflavor, t1, entries);
 
+    Allocator::GlobalAllocator.popTempRootScope();
     return res;
 }
 
-void* s_remove_find_ne_rec(const BSQMapTypeFlavor& mflavor, BSQMapSpineIterator& iter, StorageLocationPtr kl, uint32_t alloc)
+std::pair<void*, BSQNat> s_hash_submap_ne(const BSQMapTypeFlavor& mflavor, LambdaEvalThunk ee, void* t, const BSQPCode* pred, StorageLocationSpan params)
 {
-    BSQ_INTERNAL_ASSERT(iter.lcurr != nullptr);
-
-    void* res;
-    auto nalloc = alloc + mflavor.treetype->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
+    Allocator::GlobalAllocator.pushTempRootScope();
 
-    auto ck = mflavor.treetype->getKeyLocation(iter.lcurr);
-    if(mflavor.keytype->fpkeycmp(mflavor.keytype, kl, ck) < 0)
-    {
-        iter.moveLeft();
-        void* ll = s_remove_find_ne_rec(mflavor, iter, kl, nalloc);
-        iter.pop();
+    BSQMapOps::s_hash_extract_entries(mflavor, t);
+    auto entries = s_hash_scope_entries();
 
-        res = Allocator::GlobalAllocator.allocateSafe(mflavor.treetype);
-        mflavor.treetype->initializeLR(res, mflavor.treetype->getKeyLocation(iter.lcurr), mflavor.keytype, mflavor.treetype->getValueLocation(iter.lcurr), mflavor.valuetype, ll, BSQMapTreeType::getRight(iter.lcurr));
-    }
-    else if(mflavor.keytype->fpkeycmp(mflavor.keytype, ck, kl) < 0)
-    {
-        iter.moveRight();
-        void* rr = s_remove_find_ne_rec(mflavor, iter, kl, nalloc);
-        iter.pop();
+    const BSQInvokeBodyDecl* icall = dynamic_cast<const BSQInvokeBodyDecl*>(BSQInvokeDecl::g_invokes[pred->code]);
+    const BSQTupleInfo* tupinfo = dynamic_cast<const BSQTupleInfo*>(mflavor.tupletype);
 
-        res = Allocator::GlobalAllocator.allocateSafe(mflavor.treetype);
-        mflavor.treetype->initializeLR(res, mflavor.treetype->getKeyLocation(iter.lcurr), mflavor.keytype, mflavor.treetype->getValueLocation(iter.lcurr), mflavor.valuetype, BSQMapTreeType::getLeft(iter.lcurr), rr);
-    }
-    else
+    std::vector<StorageLocationPtr> keep;
     {
-        Allocator::GlobalAllocator.ensureSpace(alloc);
+        BI_LAMBDA_CALL_SETUP_KV_TEMP(mflavor.keytype, ksl, mflavor.valuetype, vsl, params, pred, lparams)
 
-        auto lltmp = BSQMapTreeType::getLeft(iter.lcurr);
-        auto rrtmp = BSQMapTreeType::getRight(iter.lcurr);
-        if(lltmp == nullptr && rrtmp == nullptr)
-        {    
-            res = nullptr;
-        }
-        else if(lltmp == nullptr)
-        {
-            res = rrtmp;
-        }
-        else if(rrtmp == nullptr)
-        {
-            res = lltmp;
-        }
-        else
+        for(size_t i = 0; i < entries.size(); ++i)
         {
-            iter.moveRight();
-            auto tnp = s_remove_rotate_ne_rec(mflavor, iter, kl, nalloc);
-            iter.pop();
+            mflavor.keytype->storeValue(ksl, mflavor.tupletype->indexStorageLocationOffset(entries[i], tupinfo->idxoffsets[0]));
+            mflavor.valuetype->storeValue(vsl, mflavor.tupletype->indexStorageLocationOffset(entries[i], tupinfo->idxoffsets[1]));
+
+            BSQBool bb = BSQFALSE;
+            ee.invoke(icall, lparams, &bb);
+            if(bb)
+            {
+                keep.push_back(entries[i]);
+            }
 
-            res = Allocator::GlobalAllocator.allocateSafe(mflavor.treetype);
-            mflavor.treetype->initializeLR(res, mflavor.treetype->getKeyLocation(tnp.second), mflavor.keytype, mflavor.treetype->getValueLocation(tnp.second), mflavor.valuetype, BSQMapTreeType::getLeft(iter.lcurr), tnp.first);
+            mflavor.keytype->clearValue(ksl);
+            mflavor.valuetype->clearValue(vsl);
         }
+
+        BI_LAMBDA_CALL_SETUP_POP()
     }
 
-    return res;
+    void* res = s_hash_add_entries_ne(mflavor, nullptr, keep);
+
+    Allocator::GlobalAllocator.popTempRootScope();
+    return std::make_pair(res, (BSQNat)keep.size());
 }
 
-void* BSQMapOps::s_remove_ne(const BSQMapTypeFlavor& mflavor, void* t, const BSQMapTreeType* ttype, StorageLocationPtr kl)
+void* s_hash_remap_ne(const BSQMapTypeFlavor& mflavor, LambdaEvalThunk ee, void* t, const BSQPCode* fn, StorageLocationSpan params, const BSQMapTypeFlavor& resflavor)
 {
-    BSQMapSpineIterator iter(ttype, t);
-    Allocator::GlobalAllocator.registerCollectionIterator(&iter);
+    BSQ_INTERNAL_ASSERT(resflavor.hashleaftype != nullptr);
 
-    void* res = s_remove_find_ne_rec(mflavor, iter, kl, 0);
+    Allocator::GlobalAllocator.pushTempRootScope();
 
-    Allocator::GlobalAllocator.releaseCollectionIterator(&iter);
+    BSQMapOps::s_hash_extract_entries(mflavor, t);
+    auto entries = s_hash_scope_entries();
+
+    const BSQInvokeBodyDecl* icall = dynamic_cast<const BSQInvokeBodyDecl*>(BSQInvokeDecl::g_invokes[fn->code]);
+    const BSQTupleInfo* tupinfo = dynamic_cast<const BSQTupleInfo*>(mflavor.tupletype);
+    const BSQTupleInfo* rtupinfo = dynamic_cast<const BSQTupleInfo*>(resflavor.tupletype);
+
+    std::vector<StorageLocationPtr> results;
+    {
+        BI_LAMBDA_CALL_SETUP_KV_TEMP_AND_RES(mflavor.keytype, ksl, mflavor.valuetype, vsl, resflavor.valuetype, resl, params, fn, lparams)
+
+        for(size_t i = 0; i < entries.size(); ++i)
+        {
+            mflavor.keytype->storeValue(ksl, mflavor.tupletype->indexStorageLocationOffset(entries[i], tupinfo->idxoffsets[0]));
+            mflavor.valuetype->storeValue(vsl, mflavor.tupletype->indexStorageLocationOffset(entries[i], tupinfo->idxoffsets[1]));
+            ee.invoke(icall, lparams, resl);
+
+            auto rr = Allocator::GlobalAllocator.registerTempRoot(resflavor.tupletype);
+            resflavor.keytype->storeValue(resflavor.tupletype->indexStorageLocationOffset(rr->root, rtupinfo->idxoffsets[0]), ksl);
+            resflavor.valuetype->storeValue(resflavor.tupletype->indexStorageLocationOffset(rr->root, rtupinfo->idxoffsets[1]), resl);
+            results.push_back((StorageLocationPtr)rr->root);
+
+            mflavor.keytype->clearValue(ksl);
+            mflavor.valuetype->clearValue(vsl);
+            resflavor.valuetype->clearValue(resl);
+        }
+
+        BI_LAMBDA_CALL_SETUP_POP()
+    }
+
+    void* res = s_hash_add_entries_ne(resflavor, nullptr, results);
+
+    Allocator::GlobalAllocator.popTempRootScope();
     return res;
 }
 
@@ -1389,10 +2364,26 @@ std::string entityMapDisplay_impl(const BSQType* btype, StorageLocationPtr data,
         auto mflavor = BSQMapOps::g_flavormap.find(std::make_pair(mtype->ktype, mtype->vtype))->second;
 
         std::string res = btype->name + "{";
-        BSQMapSpineIterator iter(MAP_LOAD_TYPE_INFO(data), MAP_LOAD_REPR(data));
-        if(iter.valid())
+        if(mflavor.hashleaftype != nullptr)
+        {
+            std::vector<void*> leaves;
+            BSQMapOps::s_hash_leaves_sorted(mflavor, MAP_LOAD_REPR(data), leaves);
+            for(size_t i = 0; i < leaves.size(); ++i)
+            {
+                if(i != 0)
+                {
+                    res += ", ";
+                }
+                res += mflavor.keytype->fpDisplay(mflavor.keytype, mflavor.hashleaftype->getKeyLocation(leaves[i]), mode) + " => " + mflavor.valuetype->fpDisplay(mflavor.valuetype, mflavor.hashleaftype->getValueLocation(leaves[i]), mode);
+            }
+        }
+        else
         {
-            res += entityMapDisplay_impl_rec(mflavor, iter, mode);
+            BSQMapSpineIterator iter(MAP_LOAD_TYPE_INFO(data), MAP_LOAD_REPR(data));
+            if(iter.valid())
+            {
+                res += entityMapDisplay_impl_rec(mflavor, iter, mode);
+            }
         }
         res += "}";
 
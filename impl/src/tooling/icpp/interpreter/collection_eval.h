@@ -13,6 +13,13 @@
 #include "runtime/bsqlist.h"
 #include "runtime/bsqmap.h"
 
+#include <thread>
+#include <barrier>
+
+//Sorts with at least this many elements (and a register key compare fast path) are split over threads
+#define BSQ_LIST_SORT_PAR_MIN 65536
+#define BSQ_LIST_SORT_MAX_THREADS 8
+
 //Forward Decl
 class Evaluator;
 
@@ -21,7 +28,68 @@ class BSQListOps
 public:
     static std::map<BSQTypeID, BSQListTypeFlavor> g_flavormap; //map from entry type to the flavors of the repr
 
-    inline static void* list_consk(const BSQListTypeFlavor& lflavor, const std::vector<StorageLocationPtr>& params)
+    //Stable merge sort of the locations on nthreads threads (the cmp must not touch the interpreter or the heap)
+    //The threads are started once -- each sorts its own run and then at the level of width w the thread of run i (i % 2w == 0) merges runs i and i + w
+    template <typename CMP>
+    static void par_stable_sort(std::vector<StorageLocationPtr>& entries, CMP cmp, size_t nthreads)
+    {
+        if(entries.size() < BSQ_LIST_SORT_PAR_MIN || nthreads <= 1)
+        {
+            std::stable_sort(entries.begin(), entries.end(), cmp);
+            return;
+        }
+
+        std::vector<size_t> bounds;
+        for(size_t i = 0; i < nthreads; ++i)
+        {
+            bounds.push_back((i * entries.size()) / nthreads);
+        }
+        bounds.push_back(entries.size());
+
+        size_t levels = 0;
+        for(size_t w = 1; w < nthreads; w *= 2)
+        {
+            levels++;
+        }
+
+        std::vector<StorageLocationPtr> scratch(entries.size());
+        std::barrier<> levelsync((std::ptrdiff_t)nthreads);
+
+        auto worker = [&entries, &scratch, &bounds, &levelsync, &cmp, nthreads](size_t i) {
+            std::stable_sort(entries.begin() + bounds[i], entries.begin() + bounds[i + 1], cmp);
+
+            //std::merge takes from the left run on ties so merging adjacent runs keeps the sort stable (a missing right run is just copied)
+            std::vector<StorageLocationPtr>* src = &entries;
+            std::vector<StorageLocationPtr>* dst = &scratch;
+            for(size_t w = 1; w < nthreads; w *= 2)
+            {
+                levelsync.arrive_and_wait();
+                if(i % (2 * w) == 0)
+                {
+                    size_t lo = bounds[i];
+                    size_t mid = bounds[std::min(i + w, nthreads)];
+                    size_t hi = bounds[std::min(i + 2 * w, nthreads)];
+                    std::merge(src->begin() + lo, src->begin() + mid, src->begin() + mid, src->begin() + hi, dst->begin() + lo, cmp);
+                }
+                std::swap(src, dst);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for(size_t i = 1; i < nthreads; ++i)
+        {
+            workers.emplace_back(worker, i);
+        }
+        worker(0);
+        std::for_each(workers.begin(), workers.end(), [](std::thread& th) { th.join(); });
+
+        if(levels % 2 == 1)
+        {
+            entries.swap(scratch);
+        }
+    }
+
+    inline static void* list_consk(const BSQListTypeFlavor& lflavor, StorageLocationSpan params)
     {
         Allocator::GlobalAllocator.ensureSpace(sizeof(GC_META_DATA_WORD) + lflavor.pv8type->allocinfo.heapsize);
 
@@ -31,7 +99,7 @@ public:
         return res;
     }
 
-    static void* list_cons(const BSQListTypeFlavor& lflavor, const std::vector<StorageLocationPtr>& params)
+    static void* list_cons(const BSQListTypeFlavor& lflavor, StorageLocationSpan params)
     {
         if(params.size() <= 8)
         {
@@ -44,63 +112,8 @@ public:
         }
     }
 
-    static void* list_append(const BSQListTypeFlavor& lflavor, void* l, void* r)
-    {
-        if(l == nullptr & r == nullptr)
-        {
-            return nullptr;
-        }
-        else if(l == nullptr)
-        {
-            return r;
-        }
-        else if(r == nullptr)
-        {
-            return l;
-        }
-        else
-        {
-            auto ltype = static_cast<const BSQListReprType*>(GET_TYPE_META_DATA(l));
-            auto rtype = static_cast<const BSQListReprType*>(GET_TYPE_META_DATA(r));
-
-            if((ltype->lkind != ListReprKind::TreeElement) & (rtype->lkind != ListReprKind::TreeElement))
-            {
-                auto count = BSQPartialVectorType::getPVCount(l) + BSQPartialVectorType::getPVCount(r);
-
-                void* res = nullptr;
-                if(count <= 4)
-                {
-                    res = Allocator::GlobalAllocator.allocateSafe(lflavor.pv4type);
-                    BSQPartialVectorType::appendPVData(res, l, lflavor.entrytype->allocinfo.inlinedatasize);
-                    BSQPartialVectorType::appendPVData(res, r, lflavor.entrytype->allocinfo.inlinedatasize);
-                } 
-                else if(count <= 8)
-                {
-                    res = Allocator::GlobalAllocator.allocateSafe(lflavor.pv8type);
-                    BSQPartialVectorType::appendPVData(res, l, lflavor.entrytype->allocinfo.inlinedatasize);
-                    BSQPartialVectorType::appendPVData(res, r, lflavor.entrytype->allocinfo.inlinedatasize);
-                }
-                else
-                {
-                    res = Allocator::GlobalAllocator.allocateSafe(lflavor.treetype);
-                    ((BSQListTreeRepr*)res)->l = l;
-                    ((BSQListTreeRepr*)res)->r = r;
-                    ((BSQListTreeRepr*)res)->size = count;
-                }
-
-                return res;
-            }
-            else
-            {
-                BSQListTreeRepr* res = (BSQListTreeRepr*)Allocator::GlobalAllocator.allocateSafe(lflavor.treetype);
-                res->l = l;
-                res->r = r;
-                res->size = ltype->getCount(l) + rtype->getCount(r);
-
-                return res;
-            }
-        }
-    }
+    //Concatenate l and r as a balanced join -- reserves its own space (so it may collect) but roots l and r while it does
+    static void* list_append(const BSQListTypeFlavor& lflavor, void* l, void* r);
 
     template <typename OP_PV>
     static void* list_tree_transform(const BSQListTypeFlavor& lflavor, BSQCollectionGCReprNode* reprnode, OP_PV fn_partialvector)
@@ -122,7 +135,6 @@ public:
             auto rrnode = list_tree_transform(lflavor, rnode, fn_partialvector);
             auto rrres = Allocator::GlobalAllocator.resetCollectionNodeEnd(gcrpoint, rrnode);
 
-            Allocator::GlobalAllocator.ensureSpace(std::max(lflavor.pv8type->allocinfo.heapsize, lflavor.treetype->allocinfo.heapsize) + sizeof(GC_META_DATA_WORD));
             return BSQListOps::list_append(lflavor, llres->repr, rrres->repr);
         }
     }
@@ -150,12 +162,11 @@ public:
             auto rrnode = list_tree_transform_idx(lflavor, rnode, idx + lsize, fn_partialvector);
             auto rrres = Allocator::GlobalAllocator.resetCollectionNodeEnd(gcrpoint, rrnode);
 
-            Allocator::GlobalAllocator.ensureSpace(std::max(lflavor.pv8type->allocinfo.heapsize, lflavor.treetype->allocinfo.heapsize) + sizeof(GC_META_DATA_WORD));
             return BSQListOps::list_append(lflavor, llres->repr, rrres->repr);
         }
     }
 
-    static void* s_temp_root_to_list_rec(const BSQListTypeFlavor& lflavor, std::list<BSQTempRootNode>::iterator& lelems, uint64_t count)
+    static void* s_temp_root_to_list_rec(const BSQListTypeFlavor& lflavor, BSQTempRootNode*& lelems, uint64_t count)
     {
         void* res = nullptr;
         if(count <= 4)
@@ -189,7 +200,6 @@ public:
             auto rrnode = BSQListOps::s_temp_root_to_list_rec(lflavor, lelems, count - mid);
             auto rrres = Allocator::GlobalAllocator.resetCollectionNodeEnd(gcrpoint, rrnode);
 
-            Allocator::GlobalAllocator.ensureSpace(std::max(lflavor.pv8type->allocinfo.heapsize, lflavor.treetype->allocinfo.heapsize) + sizeof(GC_META_DATA_WORD));
             res = BSQListOps::list_append(lflavor, llres->repr, rrres->repr);
         }
         return res;
@@ -255,7 +265,6 @@ public:
             auto rrnode = BSQListOps::s_range_ne_rec(lflavor, llnode.second + (T)1, rrcount);
             auto rrres = Allocator::GlobalAllocator.resetCollectionNodeEnd(gcrpoint, rrnode.first);
 
-            Allocator::GlobalAllocator.ensureSpace(std::max(lflavor.pv8type->allocinfo.heapsize, lflavor.treetype->allocinfo.heapsize) + sizeof(GC_META_DATA_WORD));
             res = BSQListOps::list_append(lflavor, llres->repr, rrres->repr);
         }
         return std::make_pair(res, max);
@@ -293,119 +302,31 @@ public:
             auto rrnode = BSQListOps::s_fill_ne_rec(lflavor, val, count - mid);
             auto rrres = Allocator::GlobalAllocator.resetCollectionNodeEnd(gcrpoint, rrnode);
 
-            Allocator::GlobalAllocator.ensureSpace(std::max(lflavor.pv8type->allocinfo.heapsize, lflavor.treetype->allocinfo.heapsize) + sizeof(GC_META_DATA_WORD));
             res = BSQListOps::list_append(lflavor, llres->repr, rrres->repr);
         }
         return res;
     }
 
-    static void* s_slice_start(const BSQListTypeFlavor& lflavor, BSQListSpineIterator& iter, const BSQListReprType* ttype, BSQNat start, uint32_t alloc) 
-    {
-        if(start == 0)
-        {
-            return iter.lcurr;
-        }
-
-        void* res = nullptr;
-        if(ttype->lkind != ListReprKind::TreeElement)
-        {
-            Allocator::GlobalAllocator.ensureSpace(alloc + lflavor.pv8type->allocinfo.heapsize + sizeof(GC_META_DATA_WORD));
-
-            auto count = BSQPartialVectorType::getPVCount(iter.lcurr);
-            void* res = Allocator::GlobalAllocator.allocateSafe(((count - start) <= 4) ? lflavor.pv4type : lflavor.pv8type);
-            BSQPartialVectorType::slicePVData(res, iter.lcurr, start, (uint64_t)count - start, lflavor.entrytype->allocinfo.inlinedatasize);
-        }
-        else
-        {
-            auto lltype = GET_TYPE_META_DATA_AS(BSQListReprType, static_cast<BSQListTreeRepr*>(iter.lcurr)->l);
-            auto llcount = lltype->getCount(static_cast<BSQListTreeRepr*>(iter.lcurr)->l);
-
-            if(start < llcount)
-            {
-                auto nalloc = alloc + std::max(lflavor.pv8type->allocinfo.heapsize, lflavor.treetype->allocinfo.heapsize) + sizeof(GC_META_DATA_WORD);
-
-                iter.moveLeft();
-                auto ll = BSQListOps::s_slice_start(lflavor, iter, lltype, start, nalloc);
-                iter.pop();
-
-                res = BSQListOps::list_append(lflavor, ll, static_cast<BSQListTreeRepr*>(iter.lcurr)->r);
-            }
-            else
-            {
-                auto rrtype = GET_TYPE_META_DATA_AS(BSQListReprType, static_cast<BSQListTreeRepr*>(iter.lcurr)->r);
-
-                iter.moveRight();
-                res = BSQListOps::s_slice_start(lflavor, iter, rrtype, start - llcount, alloc);
-                iter.pop();
-            }
-        }
-        return res;
-    }
-
-    static void* s_slice_end(const BSQListTypeFlavor& lflavor, BSQListSpineIterator& iter, const BSQListReprType* ttype, BSQNat end, uint32_t alloc) 
-    {
-        if(end == ttype->getCount(iter.lcurr))
-        {
-            return iter.lcurr;
-        }
-
-        void* res = nullptr;
-        if(ttype->lkind != ListReprKind::TreeElement)
-        {
-            Allocator::GlobalAllocator.ensureSpace(alloc + lflavor.pv8type->allocinfo.heapsize + sizeof(GC_META_DATA_WORD));
-
-            void* res = Allocator::GlobalAllocator.allocateDynamic((end <= 4) ? lflavor.pv4type : lflavor.pv8type);
-            BSQPartialVectorType::slicePVData(res, iter.lcurr, 0, end, lflavor.entrytype->allocinfo.inlinedatasize);
-        }
-        else
-        {
-            auto lltype = GET_TYPE_META_DATA_AS(BSQListReprType, static_cast<BSQListTreeRepr*>(iter.lcurr)->l);
-            auto llcount = lltype->getCount(static_cast<BSQListTreeRepr*>(iter.lcurr)->l);
-
-            auto rrtype = GET_TYPE_META_DATA_AS(BSQListReprType, static_cast<BSQListTreeRepr*>(iter.lcurr)->r);
-
-            if(end > llcount)
-            {
-                auto nalloc = alloc + std::max(lflavor.pv8type->allocinfo.heapsize, lflavor.treetype->allocinfo.heapsize) + sizeof(GC_META_DATA_WORD);
-
-                iter.moveRight();
-                auto rr = BSQListOps::s_slice_end(lflavor, iter, rrtype, end - llcount, nalloc);
-                iter.pop();
-
-                res = BSQListOps::list_append(lflavor, static_cast<BSQListTreeRepr*>(iter.lcurr)->l, rr);
-            }
-            else
-            {
-                iter.moveRight();
-                res = BSQListOps::s_slice_end(lflavor, iter, lltype, end, alloc);
-                iter.pop();
-            }
-        }
-        return res;
-    }
-
     static void s_safe_get(void* t, const BSQListReprType* ttype, BSQNat idx, const BSQType* oftype, StorageLocationPtr res) 
     {
-        if(ttype->lkind != ListReprKind::TreeElement)
-        {
-            oftype->storeValue(res, dynamic_cast<const BSQPartialVectorType*>(ttype)->get(t, idx));
-        }
-        else
+        while(ttype->lkind == ListReprKind::TreeElement)
         {
             auto trepr = static_cast<BSQListTreeRepr*>(t);
-            auto ll = trepr->l;
-            auto lltype = GET_TYPE_META_DATA_AS(BSQListReprType, ll);
-            auto llcount = lltype->getCount(ll);
+            auto llcount = BSQListTreeType::getSize(trepr->l);
 
             if(idx < llcount)
             {
-                return BSQListOps::s_safe_get(ll, lltype, idx, oftype, res);
+                t = trepr->l;
             }
             else
             {
-                return BSQListOps::s_safe_get(trepr->r, GET_TYPE_META_DATA_AS(BSQListReprType, trepr->r), idx - llcount, oftype, res);
+                t = trepr->r;
+                idx -= llcount;
             }
+            ttype = GET_TYPE_META_DATA_AS(BSQListReprType, t);
         }
+
+        oftype->storeValue(res, static_cast<const BSQPartialVectorType*>(ttype)->get(t, (int16_t)idx));
     }
 
     static BSQNat s_size_ne(StorageLocationPtr sl)   
@@ -423,26 +344,29 @@ public:
 
     static void* s_reverse_ne(const BSQListTypeFlavor& lflavor, BSQCollectionGCReprNode* reprnode);
 
-    static BSQNat s_find_pred_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, const std::vector<StorageLocationPtr>& params);
-    static BSQNat s_find_pred_idx_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, const std::vector<StorageLocationPtr>& params);
-    static BSQNat s_find_pred_last_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, const std::vector<StorageLocationPtr>& params);
-    static BSQNat s_find_pred_last_idx_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, const std::vector<StorageLocationPtr>& params);
+    static void* s_slice_start_ne(const BSQListTypeFlavor& lflavor, BSQCollectionGCReprNode* reprnode, BSQNat start);
+    static void* s_slice_end_ne(const BSQListTypeFlavor& lflavor, BSQCollectionGCReprNode* reprnode, BSQNat end);
+
+    static BSQNat s_find_pred_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, StorageLocationSpan params);
+    static BSQNat s_find_pred_idx_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, StorageLocationSpan params);
+    static BSQNat s_find_pred_last_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, StorageLocationSpan params);
+    static BSQNat s_find_pred_last_idx_ne(LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, StorageLocationSpan params);
 
-    static void* s_filter_pred_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, const std::vector<StorageLocationPtr>& params);
-    static void* s_filter_pred_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, const std::vector<StorageLocationPtr>& params);
+    static void* s_filter_pred_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, StorageLocationSpan params);
+    static void* s_filter_pred_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* pred, StorageLocationSpan params);
 
-    static void* s_map_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* fn, const std::vector<StorageLocationPtr>& params, const BSQListTypeFlavor& resflavor);
-    static void* s_map_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* fn, const std::vector<StorageLocationPtr>& params, const BSQListTypeFlavor& resflavor);
-    static void* s_map_sync_ne(const BSQListTypeFlavor& lflavor1, const BSQListTypeFlavor& lflavor2, LambdaEvalThunk ee, uint64_t count, void* t1, const BSQListReprType* ttype1, void* t2, const BSQListReprType* ttype2, const BSQPCode* fn, const std::vector<StorageLocationPtr>& params, const BSQListTypeFlavor& resflavor);
+    static void* s_map_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* fn, StorageLocationSpan params, const BSQListTypeFlavor& resflavor);
+    static void* s_map_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* fn, StorageLocationSpan params, const BSQListTypeFlavor& resflavor);
+    static void* s_map_sync_ne(const BSQListTypeFlavor& lflavor1, const BSQListTypeFlavor& lflavor2, LambdaEvalThunk ee, uint64_t count, void* t1, const BSQListReprType* ttype1, void* t2, const BSQListReprType* ttype2, const BSQPCode* fn, StorageLocationSpan params, const BSQListTypeFlavor& resflavor);
 
-    static void s_reduce_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* f, const std::vector<StorageLocationPtr>& params, StorageLocationPtr res);
-    static void s_reduce_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* f, const std::vector<StorageLocationPtr>& params, StorageLocationPtr res);
+    static void s_reduce_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* f, StorageLocationSpan params, StorageLocationPtr res);
+    static void s_reduce_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* f, StorageLocationSpan params, StorageLocationPtr res);
 
-    static void s_transduce_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQListTypeFlavor& uflavor, const BSQType* envtype, const BSQPCode* f, const std::vector<StorageLocationPtr>& params, const BSQEphemeralListType* rrtype, StorageLocationPtr eres);
-    static void s_transduce_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQListTypeFlavor& uflavor, const BSQType* envtype, const BSQPCode* f, const std::vector<StorageLocationPtr>& params, const BSQEphemeralListType* rrtype, StorageLocationPtr eres);
+    static void s_transduce_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQListTypeFlavor& uflavor, const BSQType* envtype, const BSQPCode* f, StorageLocationSpan params, const BSQEphemeralListType* rrtype, StorageLocationPtr eres);
+    static void s_transduce_idx_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQListTypeFlavor& uflavor, const BSQType* envtype, const BSQPCode* f, StorageLocationSpan params, const BSQEphemeralListType* rrtype, StorageLocationPtr eres);
 
-    static void* s_sort_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* lt, const std::vector<StorageLocationPtr>& params);
-    static void* s_unique_from_sorted_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* eq, const std::vector<StorageLocationPtr>& params);
+    static void* s_sort_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* lt, StorageLocationSpan params);
+    static void* s_unique_from_sorted_ne(const BSQListTypeFlavor& lflavor, LambdaEvalThunk ee, void* t, const BSQListReprType* ttype, const BSQPCode* eq, StorageLocationSpan params);
 
     static BSQString s_strconcat_ne(void* t, const BSQListReprType* ttype);
     static BSQString s_strjoin_ne(void* t, const BSQListReprType* ttype, StorageLocationPtr sep);
@@ -452,24 +376,25 @@ class BSQMapOps
 {
 public:
     static std::map<std::pair<BSQTypeID, BSQTypeID>, BSQMapTypeFlavor> g_flavormap; //map from entry type to the flavors of the repr
+    static const BSQMapHashNodeType* g_hashnodetypes[BSQ_MAP_HASH_WIDTH + 1]; //hashed map node types indexed by the number of children
 
-    static void* map_cons(const BSQMapTypeFlavor& mflavor, const std::vector<StorageLocationPtr>& params)
+    static std::string hashNodeTypeName(uint32_t width)
     {
-        if(params.size() == 1)
-        {
-            void* repr = Allocator::GlobalAllocator.allocateDynamic(mflavor.treetype);
-            const BSQTupleInfo* tupinfo = dynamic_cast<const BSQTupleInfo*>(mflavor.tupletype);
+        return "@MapHashNode" + std::to_string(width);
+    }
 
-            mflavor.treetype->initializeLeaf(repr, mflavor.tupletype->indexStorageLocationOffset(params[0], tupinfo->idxoffsets[0]), mflavor.keytype, mflavor.tupletype->indexStorageLocationOffset(params[0], tupinfo->idxoffsets[1]), mflavor.valuetype);
-            return repr;
-        }
-        else
-        {
-            assert(false);
-            return nullptr;
-        }
+    static std::string hashLeafTypeName(const std::string& treetypename)
+    {
+        return "@MapHashLeaf" + treetypename;
     }
 
+    inline static bool isHashRepr(const BSQType* rtype)
+    {
+        return BSQMapOps::g_hashnodetypes[1] != nullptr && (BSQMapOps::g_hashnodetypes[1]->tid <= rtype->tid && rtype->tid <= BSQMapOps::g_hashnodetypes[BSQ_MAP_HASH_WIDTH]->tid);
+    }
+
+    static void* map_cons(const BSQMapTypeFlavor& mflavor, StorageLocationSpan params);
+
     static void* s_lookup_ne(void* t, const BSQMapTreeType* ttype, StorageLocationPtr kl, const BSQType* ktype)
     {
         BSQMapTreeRepr* curr = static_cast<BSQMapTreeRepr*>(t);
@@ -493,6 +418,49 @@ public:
         return nullptr;
     }
 
+    //Returns the leaf holding the key (or nullptr) -- only compares keys in the chain with the same full hash
+    static void* s_hash_lookup_ne(void* t, StorageLocationPtr kl, const BSQType* ktype)
+    {
+        uint64_t hh = ktype->fpkeyhash(ktype, kl);
+
+        void* curr = t;
+        uint32_t shift = 0;
+        while(true)
+        {
+            uint64_t bitmap = BSQMapHashNodeType::getBitmap(curr);
+            uint32_t pos = BSQ_MAP_HASH_POS(hh, shift);
+            uint32_t bit = 1u << pos;
+
+            if(BSQ_MAP_HASH_DATAMAP(bitmap) & bit)
+            {
+                void* leaf = BSQMapHashNodeType::getChildren(curr)[BSQMapHashNodeType::childIndex(bitmap, pos)];
+                if(BSQMapHashLeafType::getHash(leaf) != hh)
+                {
+                    return nullptr;
+                }
+
+                const BSQMapHashLeafType* ltype = static_cast<const BSQMapHashLeafType*>(GET_TYPE_META_DATA(leaf));
+                while(leaf != nullptr && ktype->fpkeycmp(ktype, kl, ltype->getKeyLocation(leaf)) != 0)
+                {
+                    leaf = BSQMapHashLeafType::getNext(leaf);
+                }
+                return leaf;
+            }
+            else if(BSQ_MAP_HASH_NODEMAP(bitmap) & bit)
+            {
+                curr = BSQMapHashNodeType::getChildren(curr)[BSQMapHashNodeType::childIndex(bitmap, pos)];
+                shift += BSQ_MAP_HASH_BITS;
+            }
+            else
+            {
+                return nullptr;
+            }
+        }
+    }
+
+    //Leaves in key order (ordered iteration over a hashed map sorts when the entries are extracted)
+    static void s_hash_leaves_sorted(const BSQMapTypeFlavor& mflavor, void* t, std::vector<void*>& leaves);
+
     template <typename OP_PV>
     static void* map_tree_transform(const BSQMapTypeFlavor& mflavor, BSQCollectionGCReprNode* reprnode, OP_PV fn_node)
     {
@@ -529,11 +497,7 @@ public:
 
         if(pred(mflavor.treetype->getKeyLocation(iter.lcurr), mflavor.treetype->getValueLocation(iter.lcurr)))
         {
-            auto nn = Allocator::GlobalAllocator.allocateDynamic(mflavor.treetype);
-            mflavor.treetype->initializeLeaf(nn, mflavor.treetype->getKeyLocation(iter.lcurr), mflavor.keytype, mflavor.treetype->getValueLocation(iter.lcurr), mflavor.valuetype);
-
-            auto root = Allocator::GlobalAllocator.registerTempRoot(mflavor.treetype);
-            root->root = nn;
+            BSQMapOps::s_entry_to_temp_root(mflavor, mflavor.treetype->getKeyLocation(iter.lcurr), mflavor.treetype->getValueLocation(iter.lcurr));
         }
 
         if(BSQMapTreeType::getRight(iter.lcurr) != nullptr)
@@ -544,36 +508,35 @@ public:
         }
     }
 
-    static void* s_temp_root_to_map_rec(const BSQMapTypeFlavor& mflavor, std::list<BSQTempRootNode>::iterator& lelems, uint64_t count)
+    //Register a [K, V] temp root with copies of the key and value (the copies do not move in a collection)
+    static void s_entry_to_temp_root(const BSQMapTypeFlavor& mflavor, StorageLocationPtr kl, StorageLocationPtr vl)
     {
-        void* res = nullptr;
-        if(count == 0)
-        {
-            ;
-        }
-        else if(count == 1)
-        {
-            res = lelems->root;
-            lelems++;
-        }
-        else
-        {
-            auto mid = count / 2;
-            auto llnode = BSQMapOps::s_temp_root_to_map_rec(mflavor, lelems, mid);
+        const BSQTupleInfo* tupinfo = dynamic_cast<const BSQTupleInfo*>(mflavor.tupletype);
 
-            auto rootitem = lelems;
-            lelems++;
+        auto rr = Allocator::GlobalAllocator.registerTempRoot(mflavor.tupletype);
+        mflavor.keytype->storeValue(mflavor.tupletype->indexStorageLocationOffset(rr->root, tupinfo->idxoffsets[0]), kl);
+        mflavor.valuetype->storeValue(mflavor.tupletype->indexStorageLocationOffset(rr->root, tupinfo->idxoffsets[1]), vl);
+    }
 
-            auto rrnode = BSQMapOps::s_temp_root_to_map_rec(mflavor, lelems, count - mid);
+    //Sort a run of [K, V] temp roots on the key -- false if there are duplicate keys
+    static bool s_sort_temp_root_entries(const BSQMapTypeFlavor& mflavor, BSQTempRootNode* lelems, uint64_t count);
 
-            static_cast<BSQMapTreeRepr*>(rootitem->root)->l = llnode;
-            static_cast<BSQMapTreeRepr*>(rootitem->root)->r = rrnode;
-        }
-        return res;
-    }
+    //Build a perfectly balanced tree from a run of [K, V] temp roots that is sorted on the key (no roots may be registered while building)
+    static void* s_temp_root_to_map_ne(const BSQMapTypeFlavor& mflavor, BSQTempRootNode* lelems, uint64_t count);
 
     static void s_enumerate_for_extract(const BSQMapTypeFlavor& mflavor, void* tn, std::list<StorageLocationPtr>& ll)
     {
+        if(mflavor.hashleaftype != nullptr)
+        {
+            std::vector<void*> leaves;
+            BSQMapOps::s_hash_leaves_sorted(mflavor, tn, leaves);
+
+            std::transform(leaves.cbegin(), leaves.cend(), std::back_inserter(ll), [&](void* leaf) {
+                return mflavor.hashleaftype->getKeyLocation(leaf);
+            });
+            return;
+        }
+
         if(BSQMapTreeType::getLeft(tn) != nullptr)
         {
             s_enumerate_for_extract(mflavor, BSQMapTreeType::getLeft(tn), ll);
@@ -589,10 +552,17 @@ public:
 
     static void* s_union_ne(const BSQMapTypeFlavor& mflavor, void* t1, const BSQMapTreeType* ttype1, void* t2, const BSQMapTreeType* ttype2, uint64_t ccount);
 
-    static std::pair<void*, BSQNat> s_submap_ne(const BSQMapTypeFlavor& mflavor, LambdaEvalThunk ee, void* t, const BSQMapTreeType* ttype, const BSQPCode* pred, const std::vector<StorageLocationPtr>& params);
-    static void* s_remap_ne(const BSQMapTypeFlavor& mflavor, LambdaEvalThunk ee, void* t, const BSQMapTreeType* ttype, const BSQPCode* fn, const std::vector<StorageLocationPtr>& params, const BSQMapTypeFlavor& resflavor);
+    static std::pair<void*, BSQNat> s_submap_ne(const BSQMapTypeFlavor& mflavor, LambdaEvalThunk ee, void* t, const BSQMapTreeType* ttype, const BSQPCode* pred, StorageLocationSpan params);
+    static void* s_remap_ne(const BSQMapTypeFlavor& mflavor, LambdaEvalThunk ee, void* t, const BSQMapTreeType* ttype, const BSQPCode* fn, StorageLocationSpan params, const BSQMapTypeFlavor& resflavor);
 
     static void* s_add_ne(const BSQMapTypeFlavor& mflavor, void* t, const BSQMapTreeType* ttype, StorageLocationPtr kl, StorageLocationPtr vl);
     static void* s_set_ne(const BSQMapTypeFlavor& mflavor, void* t, const BSQMapTreeType* ttype, StorageLocationPtr kl, StorageLocationPtr vl);
     static void* s_remove_ne(const BSQMapTypeFlavor& mflavor, void* t, const BSQMapTreeType* ttype, StorageLocationPtr kl);
+
+    //kl and vl must be locations that are not moved by a collection (frame slots or temp roots)
+    static void* s_hash_add_ne(const BSQMapTypeFlavor& mflavor, void* t, StorageLocationPtr kl, StorageLocationPtr vl, bool replace);
+    static void* s_hash_remove_ne(const BSQMapTypeFlavor& mflavor, void* t, StorageLocationPtr kl);
+
+    //Register a [K, V] temp root for each entry (in key order) in the current temp root scope
+    static void s_hash_extract_entries(const BSQMapTypeFlavor& mflavor, void* t);
 };
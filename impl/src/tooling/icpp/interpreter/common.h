@@ -10,12 +10,21 @@
 
 #include <cstdlib>
 #include <cstdint>
+#include <cinttypes>
 #include <math.h>
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
 #include <optional>
 #include <string>
 
 #include <vector>
+#include <span>
+#include <bit>
+#include <chrono>
+#include <atomic>
 #include <list>
 #include <map>
 
@@ -23,7 +32,25 @@
 
 ////////////////////////////////
 //Various sizes
-#define BSQ_MAX_STACK 2048
+
+//The call, gc shadow, and collection node stacks start with this many entries and grow on demand
+#define BSQ_INITIAL_STACK 256
+
+//Default limit on the call depth (the gc and collection node stacks get 2x this) -- override with the ICPP_MAX_STACK env var
+#define BSQ_DEFAULT_MAX_STACK 2048
+
+//Temp root values are bump allocated from segments of this many bytes (kept once allocated and reused as scopes are popped)
+#define BSQ_TEMP_ROOT_SEGMENT_SIZE 65536
+
+////////////////////////////////
+//Interpreter dispatch
+
+//Use computed goto (threaded) dispatch in the op loop when the compiler supports labels as values -- define BSQ_SWITCH_DISPATCH to force the portable switch loop
+#if !defined(BSQ_SWITCH_DISPATCH) && (defined(__GNUC__) || defined(__clang__))
+#define BSQ_THREADED_DISPATCH
+#endif
+
+//Define BSQ_PROFILE to build in the profiler hooks (--profile or ICPP_PROFILE) -- without it the call and op paths have no profiler checks at all
 
 ////////////////////////////////
 //Asserts
@@ -48,6 +75,9 @@
 #define BSQ_LANGUAGE_ABORT(MSG, F, L) HANDLE_BSQ_ABORT()
 #endif
 
+//Cold path when one of the growable stacks hits its limit -- defined with the evaluator since it unwinds to the entry point
+[[noreturn]] void handleStackLimitAbort(const char* stackname);
+
 ////////////////////////////////
 //Memory allocator
 
@@ -63,9 +93,13 @@
 //Program should not contain any allocations larger than this in a single block 
 #define BSQ_ALLOC_MAX_BLOCK_SIZE 65536
 
-//Min and max bump allocator size
+//Default min and max bump allocator size and pause target (all can be set at startup -- see GCNurseryPolicy)
 #define BSQ_MIN_NURSERY_SIZE 1048576
 #define BSQ_MAX_NURSERY_SIZE 16777216
+#define BSQ_NURSERY_TARGET_PAUSE_US 10000
+
+//The nursery doubles while the (smoothed) fraction of it that survives a collection is below this and the pause has room -- it shrinks in proportion when the pause is over the target
+#define BSQ_NURSERY_GROW_SURVIVAL 0.10
 
 //Allocation routines
 #ifdef _WIN32
@@ -74,11 +108,56 @@
 #define BSQ_STACK_SPACE_ALLOC(SIZE) ((SIZE) == 0 ? nullptr : alloca(SIZE))
 #endif
 
-#define BSQ_BUMP_SPACE_ALLOC(SIZE) zxalloc(SIZE)
-#define BSQ_BUMP_SPACE_RELEASE(M) xfree(M)
+//The nursery is page mapped (so fresh space is already zero) and on reuse it is zeroed in BSQ_NURSERY_ZERO_CHUNK steps just ahead of the bump pointer
+#define BSQ_BUMP_SPACE_ALLOC(SIZE) BSQ_PAGE_SPACE_ALLOC(SIZE)
+#define BSQ_BUMP_SPACE_RELEASE(M, SIZE) BSQ_PAGE_SPACE_RELEASE(M, SIZE)
+#define BSQ_NURSERY_ZERO_CHUNK 65536
+
+//Old RC space objects (size includes the meta word) up to BSQ_RC_SLAB_MAX_OBJECT_SIZE are allocated from size class slabs -- larger ones use these
+#define BSQ_FREE_LIST_ALLOC_LARGE(SIZE) xalloc(SIZE)
+#define BSQ_FREE_LIST_RELEASE_LARGE(M) xfree(M)
+
+//Slabs are carved from chunks of pages and the pages of empty slabs are given back to the OS (after keeping a few for reuse)
+#ifdef _WIN32
+#define BSQ_PAGE_SPACE_ALLOC(SIZE) _aligned_malloc(SIZE, BSQ_RC_SLAB_SIZE)
+#define BSQ_PAGE_SPACE_RELEASE(M, SIZE) _aligned_free(M)
+#define BSQ_PAGE_SPACE_DECOMMIT(M, SIZE)
+#define BSQ_PAGE_SPACE_ZEROED false
+#else
+#define BSQ_PAGE_SPACE_ALLOC(SIZE) mmap(nullptr, SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)
+#define BSQ_PAGE_SPACE_RELEASE(M, SIZE) munmap(M, SIZE)
+#define BSQ_PAGE_SPACE_DECOMMIT(M, SIZE) madvise(M, SIZE, MADV_DONTNEED)
+#define BSQ_PAGE_SPACE_ZEROED true
+#endif
+
+//Build with BSQ_NURSERY_HUGE_PAGES to ask for transparent huge pages for the nursery (fewer TLB misses on large nurseries)
+#if defined(BSQ_NURSERY_HUGE_PAGES) && defined(MADV_HUGEPAGE)
+#define BSQ_PAGE_SPACE_ADVISE_HUGE(M, SIZE) madvise(M, SIZE, MADV_HUGEPAGE)
+#else
+#define BSQ_PAGE_SPACE_ADVISE_HUGE(M, SIZE)
+#endif
+
+#define BSQ_RC_SLAB_SIZE 4096
+#define BSQ_RC_SLAB_CHUNK_SLABS 256
+#define BSQ_RC_SLAB_RETAIN_EMPTY 64
+#define BSQ_RC_SLAB_SIZE_CLASS_COUNT 32
+
+//Build with BSQ_RC_SYSTEM_MALLOC to send every old RC space object to malloc (for comparing against the slabs)
+#ifdef BSQ_RC_SYSTEM_MALLOC
+#define BSQ_RC_SLAB_MAX_OBJECT_SIZE 0
+#else
+#define BSQ_RC_SLAB_MAX_OBJECT_SIZE (BSQ_RC_SLAB_SIZE_CLASS_COUNT * sizeof(void*))
+#endif
+
+//Parallel minor collection (--gc-threads=N) -- a worker offers half of its trace stack to the others once it holds more than BSQ_GC_PAR_EXPORT_THRESHOLD objects
+#define BSQ_GC_MAX_THREADS 64
+#define BSQ_GC_PAR_EXPORT_THRESHOLD 64
 
-#define BSQ_FREE_LIST_ALLOC_SMALL(SIZE) xalloc(SIZE)
-#define BSQ_FREE_LIST_RELEASE(SIZE, M) xfree(M)
+//Types that survive their first collection at least BSQ_PRETENURE_SURVIVAL_PERCENT of the time (over at least BSQ_PRETENURE_MIN_ALLOCS allocations) are allocated directly in the old RC space
+//They go back to the nursery every BSQ_PRETENURE_RECHECK_GCS collections so the survival rate is measured again
+#define BSQ_PRETENURE_MIN_ALLOCS 4096
+#define BSQ_PRETENURE_SURVIVAL_PERCENT 90
+#define BSQ_PRETENURE_RECHECK_GCS 32
 
 #define GC_REF_LIST_BLOCK_SIZE_DEFAULT 256
 
@@ -95,7 +174,8 @@
 
 typedef uint64_t GC_META_DATA_WORD;
 #define GC_GET_META_DATA_ADDR(M) ((GC_META_DATA_WORD*)((uint8_t*)M - sizeof(GC_META_DATA_WORD)))
-#define GC_LOAD_META_DATA_WORD(ADDR) (*((GC_META_DATA_WORD*)ADDR))
+//relaxed atomic load (a plain load on x86/arm) -- the background release thread updates old space headers while the mutator reads their type bits
+#define GC_LOAD_META_DATA_WORD(ADDR) (std::atomic_ref<GC_META_DATA_WORD>(*((GC_META_DATA_WORD*)ADDR)).load(std::memory_order_relaxed))
 #define GC_SET_META_DATA_WORD(ADDR, W) (*((GC_META_DATA_WORD*)ADDR) = W)
 
 #define GC_EXTRACT_RC(W) (W & GC_RC_MASK)
@@ -104,6 +184,9 @@ typedef uint64_t GC_META_DATA_WORD;
 #define GC_RC_ZERO ((GC_META_DATA_WORD)0x0)
 #define GC_RC_ONE ((GC_META_DATA_WORD)0x1000000)
 
+//RC for objects loaded from a heap image -- far enough from zero that they are never released
+#define GC_RC_IMMORTAL ((GC_META_DATA_WORD)0x0100000000000000)
+
 #define GC_TEST_IS_UNREACHABLE(W) ((W & GC_REACHABLE_MASK) == 0x0)
 #define GC_TEST_IS_ZERO_RC(W) ((W & GC_RC_MASK) == GC_RC_ZERO)
 #define GC_TEST_IS_YOUNG(W) (W & GC_YOUNG_BIT)
@@ -127,6 +210,8 @@ typedef uint64_t GC_META_DATA_WORD;
 
 #define GC_SET_TYPE_META_DATA_FORWARD_SENTINAL(ADDR) *(ADDR) = 0
 #define GC_IS_TYPE_META_DATA_FORWARD_SENTINAL(W) ((W) == 0)
+//A young object claimed by a parallel GC worker that is still being copied (the bump bit is never set without the young bit otherwise)
+#define GC_FORWARD_BUSY_SENTINAL ((GC_META_DATA_WORD)GC_BUMP_SPACE_BIT)
 #define GC_GET_FORWARD_PTR(M) *((void**)M)
 #define GC_SET_FORWARD_PTR(M, P) *((void**)M) = (void*)P
 
@@ -142,6 +227,9 @@ typedef uint64_t GC_META_DATA_WORD;
 //Generic pointer to a storage location that holds a value
 typedef void* StorageLocationPtr;
 
+//Non-owning view of argument locations -- usually backed by stack space so calls do not heap allocate
+typedef std::span<const StorageLocationPtr> StorageLocationSpan;
+
 #define IS_INLINE_STRING(S) (*(((uint8_t*)(S)) + 15) != 0)
 #define IS_INLINE_BIGNUM(N) false
 
@@ -233,6 +321,19 @@ struct BSQTypeSizeInfo
     const RefMask inlinedmask; //The mask used to traverse this object as part of inline storage (on stack or inline in an object) -- must cover full size of data
 };
 
+//Precomputed form of a RefMask so the collector does not decode the mask string for every object it visits
+//Plain pointer slots are a bitmap (masks longer than 64 slots spill the rest to ptrslots) and the few string/bignum/union slots are listed
+struct GCTracePlan
+{
+    uint64_t ptrbits;
+    bool hasextra; //true if any of the lists below are non-empty
+
+    std::vector<uint32_t> ptrslots;
+    std::vector<uint32_t> stringslots;
+    std::vector<uint32_t> bignumslots;
+    std::vector<uint32_t> unionslots;
+};
+
 #define UNION_UNIVERSAL_CONTENT_SIZE 32
 #define UNION_UNIVERSAL_SIZE 40
 #define UNION_UNIVERSAL_MASK "51111"
@@ -249,6 +350,10 @@ struct GCFunctorSet
 typedef int (*KeyCmpFP)(const BSQType* btype, StorageLocationPtr, StorageLocationPtr);
 constexpr KeyCmpFP EMPTY_KEY_CMP = nullptr;
 
+//Hash consistent with the KeyCmpFP (equal keys hash the same) -- only set for key types where a compare is expensive enough to want the hashed map flavor
+typedef uint64_t (*KeyHashFP)(const BSQType* btype, StorageLocationPtr);
+constexpr KeyHashFP EMPTY_KEY_HASH = nullptr;
+
 typedef uint32_t BSQTypeID;
 typedef uint32_t BSQTupleIndex;
 typedef uint32_t BSQRecordPropertyID;
@@ -0,0 +1,550 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+#include "heap_image.h"
+#include "op_eval.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define BSQ_HEAP_IMAGE_MAGIC "BSQHEAP"
+#define BSQ_HEAP_IMAGE_VERSION 1
+
+//Image layout -- header, const slot table (offset/size pairs), slot values, objects (meta word + heap data), relocations
+struct HeapImageHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t ptrsize;
+    uint64_t key;
+
+    uint64_t slotcount;
+    uint64_t slotbytes;
+    uint64_t objbytes;
+    uint64_t reloccount;
+};
+
+enum class HeapImageRelocKind : uint64_t
+{
+    HeapPtr = 0x0,   //the word is the file offset of an object
+    TypePtr          //the word is the type id of a union value
+};
+
+//pos is the file offset of the word to patch
+struct HeapImageReloc
+{
+    uint64_t pos;
+    HeapImageRelocKind kind;
+};
+
+class HeapImageWriter
+{
+public:
+    std::vector<uint8_t> slotdata;
+    std::vector<uint8_t> objdata;
+    std::vector<HeapImageReloc> relocs;
+
+    //relocations recorded in image space (slot data or object data) and the objects still to copy
+    std::vector<std::pair<bool, uint64_t>> pendingptrs;
+    std::vector<std::pair<bool, uint64_t>> pendingtypes;
+    std::map<void*, uint64_t> objoffsets;
+    std::vector<void*> worklist;
+
+    bool unsupported;
+    std::map<BSQTypeID, bool> regexreach;
+
+    HeapImageWriter() : slotdata(), objdata(), relocs(), pendingptrs(), pendingtypes(), objoffsets(), worklist(), unsupported(false), regexreach() {;}
+
+    //Regex values are pointers to the regexes loaded with the assembly and their GC mask is a nop so the trace plans never see them --
+    //any type whose layout (fields, entries, union options) can reach a Regex is not imaged
+    bool reachesRegex(const BSQType* tt)
+    {
+        auto riter = this->regexreach.find(tt->tid);
+        if(riter != this->regexreach.end())
+        {
+            return riter->second;
+        }
+
+        std::set<BSQTypeID> visited;
+        std::vector<BSQTypeID> ctypes = {tt->tid};
+        bool reaches = false;
+        while(!ctypes.empty() && !reaches)
+        {
+            BSQTypeID tid = ctypes.back();
+            ctypes.pop_back();
+
+            const BSQType* ctype = BSQType::g_typetable[tid];
+            if(ctype == nullptr || !visited.insert(tid).second)
+            {
+                continue;
+            }
+
+            reaches = (tid == BSQ_TYPE_ID_REGEX);
+            pushComponentTypes(ctype, ctypes);
+        }
+
+        this->regexreach[tt->tid] = reaches;
+        return reaches;
+    }
+
+    static void pushComponentTypes(const BSQType* tt, std::vector<BSQTypeID>& ctypes)
+    {
+        if(auto tinfo = dynamic_cast<const BSQTupleInfo*>(tt))
+        {
+            ctypes.insert(ctypes.end(), tinfo->ttypes.cbegin(), tinfo->ttypes.cend());
+        }
+        else if(auto rinfo = dynamic_cast<const BSQRecordInfo*>(tt))
+        {
+            ctypes.insert(ctypes.end(), rinfo->rtypes.cbegin(), rinfo->rtypes.cend());
+        }
+        else if(auto einfo = dynamic_cast<const BSQEntityInfo*>(tt))
+        {
+            ctypes.insert(ctypes.end(), einfo->ftypes.cbegin(), einfo->ftypes.cend());
+        }
+        else if(auto cinfo = dynamic_cast<const BSQConstructableEntityInfo*>(tt))
+        {
+            ctypes.push_back(cinfo->oftype);
+        }
+        else if(auto eltype = dynamic_cast<const BSQEphemeralListType*>(tt))
+        {
+            ctypes.insert(ctypes.end(), eltype->etypes.cbegin(), eltype->etypes.cend());
+        }
+        else if(auto utype = dynamic_cast<const BSQUnionType*>(tt))
+        {
+            ctypes.insert(ctypes.end(), utype->subtypes.cbegin(), utype->subtypes.cend());
+        }
+        else if(auto btype = dynamic_cast<const BSQBoxedStructType*>(tt))
+        {
+            ctypes.push_back(btype->oftype->tid);
+        }
+        else if(auto ltype = dynamic_cast<const BSQListType*>(tt))
+        {
+            ctypes.push_back(ltype->etype);
+        }
+        else if(auto lrtype = dynamic_cast<const BSQListReprType*>(tt))
+        {
+            ctypes.push_back(lrtype->entrytype);
+        }
+        else if(auto mtype = dynamic_cast<const BSQMapType*>(tt))
+        {
+            ctypes.push_back(mtype->ktype);
+            ctypes.push_back(mtype->vtype);
+        }
+        else if(auto mttype = dynamic_cast<const BSQMapTreeType*>(tt))
+        {
+            ctypes.push_back(mttype->keytype);
+            ctypes.push_back(mttype->valuetype);
+        }
+        else if(auto mltype = dynamic_cast<const BSQMapHashLeafType*>(tt))
+        {
+            ctypes.push_back(mltype->keytype);
+            ctypes.push_back(mltype->valuetype);
+        }
+        else
+        {
+            ;
+        }
+    }
+
+    uint8_t* dataFor(bool inobj, uint64_t pos)
+    {
+        return inobj ? (this->objdata.data() + pos) : (this->slotdata.data() + pos);
+    }
+
+    void recordObject(bool inobj, uint64_t pos)
+    {
+        void* obj = *((void**)this->dataFor(inobj, pos));
+        if(obj == nullptr)
+        {
+            return;
+        }
+
+        auto oiter = this->objoffsets.find(obj);
+        if(oiter == this->objoffsets.end())
+        {
+            size_t osize = COMPUTE_REAL_BYTES(obj);
+            uint64_t offset = this->objdata.size() + sizeof(GC_META_DATA_WORD);
+
+            this->objdata.resize(this->objdata.size() + osize);
+            GC_MEM_COPY(this->objdata.data() + offset - sizeof(GC_META_DATA_WORD), GC_GET_META_DATA_ADDR(obj), osize);
+
+            GC_META_DATA_WORD* addr = (GC_META_DATA_WORD*)(this->objdata.data() + offset - sizeof(GC_META_DATA_WORD));
+            *addr = GC_RC_IMMORTAL | GC_EXTRACT_TYPEID(*addr);
+
+            oiter = this->objoffsets.emplace(obj, offset).first;
+            this->worklist.push_back(obj);
+        }
+
+        //object offsets are fixed up to file offsets once the size of the slot data is known
+        *((uint64_t*)this->dataFor(inobj, pos)) = oiter->second;
+        this->pendingptrs.push_back(std::make_pair(inobj, pos));
+    }
+
+    void recordSlotsWithPlan(bool inobj, uint64_t pos, const GCTracePlan& plan);
+
+    void recordUnion(bool inobj, uint64_t pos)
+    {
+        const BSQType* umeta = *((const BSQType**)this->dataFor(inobj, pos));
+        if(umeta == nullptr)
+        {
+            return;
+        }
+
+        //the union type may not list its options (Any) so the content type is checked as well
+        if(this->reachesRegex(umeta))
+        {
+            this->unsupported = true;
+            return;
+        }
+
+        *((uint64_t*)this->dataFor(inobj, pos)) = (uint64_t)umeta->tid;
+        this->pendingtypes.push_back(std::make_pair(inobj, pos));
+
+        //the inlinedmask of the content type covers its representation after the type word (as in gcParProcessSlotsWithUnion)
+        this->recordSlotsWithPlan(inobj, pos + sizeof(void*), umeta->inlinedplan);
+    }
+
+    void processObjects()
+    {
+        //objects are traced from their copies (so the positions are image positions) -- the worklist only says how many are left
+        size_t done = 0;
+        while(done < this->worklist.size())
+        {
+            void* obj = this->worklist[done++];
+            uint64_t pos = this->objoffsets.find(obj)->second;
+
+            this->recordSlotsWithPlan(true, pos, GET_TYPE_META_DATA(obj)->heapplan);
+        }
+    }
+};
+
+void HeapImageWriter::recordSlotsWithPlan(bool inobj, uint64_t pos, const GCTracePlan& plan)
+{
+    uint64_t bits = plan.ptrbits;
+    while(bits != 0)
+    {
+        this->recordObject(inobj, pos + std::countr_zero(bits) * sizeof(void*));
+        bits &= (bits - 1);
+    }
+
+    for(size_t i = 0; i < plan.ptrslots.size(); ++i)
+    {
+        this->recordObject(inobj, pos + plan.ptrslots[i] * sizeof(void*));
+    }
+    for(size_t i = 0; i < plan.stringslots.size(); ++i)
+    {
+        uint64_t spos = pos + plan.stringslots[i] * sizeof(void*);
+        if(!IS_INLINE_STRING(this->dataFor(inobj, spos)))
+        {
+            this->recordObject(inobj, spos);
+        }
+    }
+    for(size_t i = 0; i < plan.bignumslots.size(); ++i)
+    {
+        uint64_t bpos = pos + plan.bignumslots[i] * sizeof(void*);
+        if(!IS_INLINE_BIGNUM(this->dataFor(inobj, bpos)))
+        {
+            this->recordObject(inobj, bpos);
+        }
+    }
+    for(size_t i = 0; i < plan.unionslots.size(); ++i)
+    {
+        this->recordUnion(inobj, pos + plan.unionslots[i] * sizeof(void*));
+    }
+}
+
+uint64_t computeHeapImageKey(const json& jbytecode)
+{
+    //FNV-1a so the key is the same for every build of icpp
+    std::string jstr = jbytecode.dump();
+
+    uint64_t hash = 0xcbf29ce484222325;
+    for(size_t i = 0; i < jstr.size(); ++i)
+    {
+        hash ^= (uint8_t)jstr[i];
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+static uint8_t* mapHeapImage(const std::string& imagefile, size_t& imagesize)
+{
+#ifdef _WIN32
+    FILE* fp = fopen(imagefile.c_str(), "rb");
+    if(fp == nullptr)
+    {
+        return nullptr;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    imagesize = (size_t)ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    uint8_t* image = (uint8_t*)xalloc(std::max(imagesize, (size_t)1));
+    if(fread(image, 1, imagesize, fp) != imagesize)
+    {
+        xfree(image);
+        image = nullptr;
+    }
+    fclose(fp);
+
+    return image;
+#else
+    int fd = open(imagefile.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        return nullptr;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    //private so the collector can still update the (never zero) counts and marks in the object headers -- pages are only copied when that happens
+    imagesize = (size_t)st.st_size;
+    void* image = mmap(nullptr, imagesize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    return image != MAP_FAILED ? (uint8_t*)image : nullptr;
+#endif
+}
+
+static void unmapHeapImage(uint8_t* image, size_t imagesize)
+{
+#ifdef _WIN32
+    xfree(image);
+#else
+    munmap(image, imagesize);
+#endif
+}
+
+//Everything the loader patches or copies has to be inside the image -- the object headers are checked against the type table and the relocations against the slot data,
+//the object starts, and the type table before any word is written
+static bool validateHeapImageContents(const uint8_t* image, size_t imagesize, const HeapImageHeader* hdr, const std::vector<HeapImageConstSlot>& constslots, size_t typecount)
+{
+    if(hdr->slotbytes > imagesize || hdr->objbytes > imagesize || hdr->reloccount > imagesize / sizeof(HeapImageReloc))
+    {
+        return false;
+    }
+
+    size_t slottablepos = sizeof(HeapImageHeader);
+    size_t slotdatapos = slottablepos + hdr->slotcount * 2 * sizeof(uint64_t);
+    size_t objpos = slotdatapos + hdr->slotbytes;
+    size_t relocpos = objpos + hdr->objbytes;
+    if(relocpos + hdr->reloccount * sizeof(HeapImageReloc) != imagesize)
+    {
+        return false;
+    }
+
+    const uint64_t* slottable = (const uint64_t*)(image + slottablepos);
+    for(size_t i = 0; i < hdr->slotcount; ++i)
+    {
+        uint64_t vsize = constslots[i].gtype->allocinfo.inlinedatasize;
+        if(slottable[2 * i] != constslots[i].offset || vsize > hdr->slotbytes || slottable[2 * i + 1] > hdr->slotbytes - vsize)
+        {
+            return false;
+        }
+    }
+
+    //the object section is a sequence of (meta word, heap data) -- each header has to be the immortal header the writer made for a loaded type and the objects have to tile the section
+    std::vector<uint64_t> objstarts;
+    size_t opos = objpos;
+    while(opos < relocpos)
+    {
+        if(relocpos - opos < sizeof(GC_META_DATA_WORD))
+        {
+            return false;
+        }
+
+        GC_META_DATA_WORD w = *((const GC_META_DATA_WORD*)(image + opos));
+        uint64_t tid = GC_EXTRACT_TYPEID(w);
+        if(w != (GC_RC_IMMORTAL | tid) || tid >= typecount || BSQType::g_typetable[tid] == nullptr)
+        {
+            return false;
+        }
+
+        size_t osize = BSQType::g_typetable[tid]->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
+        if(osize > relocpos - opos)
+        {
+            return false;
+        }
+
+        objstarts.push_back(opos + sizeof(GC_META_DATA_WORD));
+        opos += osize;
+    }
+
+    const HeapImageReloc* relocs = (const HeapImageReloc*)(image + relocpos);
+    for(size_t i = 0; i < hdr->reloccount; ++i)
+    {
+        if(relocs[i].pos < slotdatapos || relocs[i].pos > relocpos - sizeof(uint64_t))
+        {
+            return false;
+        }
+
+        uint64_t word = *((const uint64_t*)(image + relocs[i].pos));
+        if(relocs[i].kind == HeapImageRelocKind::HeapPtr)
+        {
+            if(!std::binary_search(objstarts.cbegin(), objstarts.cend(), word))
+            {
+                return false;
+            }
+        }
+        else if(relocs[i].kind == HeapImageRelocKind::TypePtr)
+        {
+            if(word >= typecount || BSQType::g_typetable[word] == nullptr)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool loadHeapImage(const std::string& imagefile, uint64_t key, const std::vector<HeapImageConstSlot>& constslots, size_t typecount)
+{
+    size_t imagesize = 0;
+    uint8_t* image = mapHeapImage(imagefile, imagesize);
+    if(image == nullptr)
+    {
+        return false;
+    }
+
+    const HeapImageHeader* hdr = (const HeapImageHeader*)image;
+    bool current = imagesize >= sizeof(HeapImageHeader) && memcmp(hdr->magic, BSQ_HEAP_IMAGE_MAGIC, sizeof(hdr->magic)) == 0 && hdr->version == BSQ_HEAP_IMAGE_VERSION && hdr->ptrsize == sizeof(void*) && hdr->key == key && hdr->slotcount == constslots.size();
+    if(!current)
+    {
+        unmapHeapImage(image, imagesize);
+        return false;
+    }
+
+    if(!validateHeapImageContents(image, imagesize, hdr, constslots, typecount))
+    {
+        fprintf(stderr, "Heap image %s is truncated or corrupted -- running the initializers instead\n", imagefile.c_str());
+
+        unmapHeapImage(image, imagesize);
+        return false;
+    }
+
+    size_t slottablepos = sizeof(HeapImageHeader);
+    size_t slotdatapos = slottablepos + hdr->slotcount * 2 * sizeof(uint64_t);
+    size_t relocpos = slotdatapos + hdr->slotbytes + hdr->objbytes;
+
+    const HeapImageReloc* relocs = (const HeapImageReloc*)(image + relocpos);
+    for(size_t i = 0; i < hdr->reloccount; ++i)
+    {
+        uint64_t* word = (uint64_t*)(image + relocs[i].pos);
+        if(relocs[i].kind == HeapImageRelocKind::HeapPtr)
+        {
+            *word = (uint64_t)(image + *word);
+        }
+        else
+        {
+            *word = (uint64_t)BSQType::g_typetable[*word];
+        }
+    }
+
+    const uint64_t* slottable = (const uint64_t*)(image + slottablepos);
+    for(size_t i = 0; i < hdr->slotcount; ++i)
+    {
+        GC_MEM_COPY(Evaluator::g_constantbuffer + slottable[2 * i], image + slotdatapos + slottable[2 * i + 1], constslots[i].gtype->allocinfo.inlinedatasize);
+    }
+
+    //the image stays mapped for the rest of the run (the objects are immortal)
+    return true;
+}
+
+void saveHeapImage(const std::string& imagefile, uint64_t key, const std::vector<HeapImageConstSlot>& constslots)
+{
+    HeapImageWriter writer;
+
+    std::vector<uint64_t> slottable;
+    for(size_t i = 0; i < constslots.size(); ++i)
+    {
+        const BSQType* gtype = constslots[i].gtype;
+        if(writer.reachesRegex(gtype))
+        {
+            writer.unsupported = true;
+        }
+
+        uint64_t pos = writer.slotdata.size();
+        writer.slotdata.resize(pos + gtype->allocinfo.inlinedatasize);
+        GC_MEM_COPY(writer.slotdata.data() + pos, Evaluator::g_constantbuffer + constslots[i].offset, gtype->allocinfo.inlinedatasize);
+
+        slottable.push_back(constslots[i].offset);
+        slottable.push_back(pos);
+    }
+
+    //trace the slot values first (nothing is added to the slot data after this so its positions are stable)
+    size_t spos = 0;
+    for(size_t i = 0; i < constslots.size(); ++i)
+    {
+        writer.recordSlotsWithPlan(false, spos, constslots[i].gtype->inlinedplan);
+        spos += constslots[i].gtype->allocinfo.inlinedatasize;
+    }
+    writer.processObjects();
+
+    if(writer.unsupported)
+    {
+        fprintf(stderr, "Heap image not written -- constants with Regex values are not supported\n");
+        return;
+    }
+
+    size_t slotdatapos = sizeof(HeapImageHeader) + slottable.size() * sizeof(uint64_t);
+    size_t objpos = slotdatapos + writer.slotdata.size();
+
+    //object offsets become file offsets now that the layout is known
+    for(size_t i = 0; i < writer.pendingptrs.size(); ++i)
+    {
+        bool inobj = writer.pendingptrs[i].first;
+        uint64_t pos = writer.pendingptrs[i].second;
+
+        *((uint64_t*)writer.dataFor(inobj, pos)) += objpos;
+        writer.relocs.push_back({(inobj ? objpos : slotdatapos) + pos, HeapImageRelocKind::HeapPtr});
+    }
+    for(size_t i = 0; i < writer.pendingtypes.size(); ++i)
+    {
+        bool inobj = writer.pendingtypes[i].first;
+        uint64_t pos = writer.pendingtypes[i].second;
+
+        writer.relocs.push_back({(inobj ? objpos : slotdatapos) + pos, HeapImageRelocKind::TypePtr});
+    }
+
+    HeapImageHeader hdr;
+    GC_MEM_ZERO(&hdr, sizeof(HeapImageHeader));
+    GC_MEM_COPY(hdr.magic, BSQ_HEAP_IMAGE_MAGIC, sizeof(hdr.magic));
+    hdr.version = BSQ_HEAP_IMAGE_VERSION;
+    hdr.ptrsize = sizeof(void*);
+    hdr.key = key;
+    hdr.slotcount = constslots.size();
+    hdr.slotbytes = writer.slotdata.size();
+    hdr.objbytes = writer.objdata.size();
+    hdr.reloccount = writer.relocs.size();
+
+    FILE* fp = fopen(imagefile.c_str(), "wb");
+    if(fp == nullptr)
+    {
+        fprintf(stderr, "Could not open heap image file %s\n", imagefile.c_str());
+        return;
+    }
+
+    fwrite(&hdr, sizeof(HeapImageHeader), 1, fp);
+    fwrite(slottable.data(), sizeof(uint64_t), slottable.size(), fp);
+    fwrite(writer.slotdata.data(), 1, writer.slotdata.size(), fp);
+    fwrite(writer.objdata.data(), 1, writer.objdata.size(), fp);
+    fwrite(writer.relocs.data(), sizeof(HeapImageReloc), writer.relocs.size(), fp);
+    fclose(fp);
+}
@@ -0,0 +1,26 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "common.h"
+#include "runtime/bsqmemory.h"
+
+//A slot in the constant buffer that is set by a global initializer (the value is gtype->allocinfo.inlinedatasize bytes at offset)
+struct HeapImageConstSlot
+{
+    uint64_t offset;
+    const BSQType* gtype;
+};
+
+//Images are keyed on the assembly they were made from so a stale image is never loaded
+uint64_t computeHeapImageKey(const json& jbytecode);
+
+//Map the image and copy the constant values into the constant buffer -- false (and nothing changed) if the image is missing, was made from a different assembly,
+//or has an object header, relocation, or type id that does not check out against the image layout and the type table (typecount entries)
+bool loadHeapImage(const std::string& imagefile, uint64_t key, const std::vector<HeapImageConstSlot>& constslots, size_t typecount);
+
+//Write the constant values and everything reachable from them (after the initializers have run)
+void saveHeapImage(const std::string& imagefile, uint64_t key, const std::vector<HeapImageConstSlot>& constslots);
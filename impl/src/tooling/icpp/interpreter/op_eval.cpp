@@ -68,13 +68,58 @@ BSQ_LANGUAGE_ASSERT(!ISNAN(rarg) & !ISNAN(larg), &(THIS->cframe->invoke->srcFile
 BSQ_LANGUAGE_ASSERT((!ISINFINITE(rarg) | !ISINFINITE(larg)) || ((rarg <= 0) & (0 <= larg)) || ((larg <= 0) & (0 <= rarg)), &(THIS->cframe->invoke->srcFile), THIS->cframe->dbg_currentline, "Infinte values cannot be ordered"); \
 SLPTR_STORE_CONTENTS_AS(BSQBool, THIS->evalTargetVar(bop->trgt), larg OPERATOR rarg);
 
+//Big Macro for generating code for fused primitive compare and conditional jump operations
+#define PrimitiveBinaryCompareJumpCondMacro(THIS, OP, REPRTYPE, OPERATOR) BSQBool jc = SLPTR_LOAD_CONTENTS_AS(REPRTYPE, THIS->evalArgument(OP->larg)) OPERATOR SLPTR_LOAD_CONTENTS_AS(REPRTYPE, THIS->evalArgument(OP->rarg)); \
+SLPTR_STORE_CONTENTS_AS(BSQBool, THIS->evalTargetVar(OP->trgt), jc); \
+return THIS->advanceCurrentOp(jc ? OP->toffset : OP->foffset);
+
 jmp_buf Evaluator::g_entrybuff;
-EvaluatorFrame Evaluator::g_callstack[BSQ_MAX_STACK];
+EvaluatorFrame* Evaluator::g_callstack = nullptr;
+int32_t Evaluator::g_callstackcapacity = 0;
+int32_t Evaluator::g_maxcallstack = BSQ_DEFAULT_MAX_STACK;
 uint8_t* Evaluator::g_constantbuffer = nullptr;
 
 std::map<BSQTypeID, const BSQRegex*> Evaluator::g_validators;
 std::map<std::string, const BSQRegex*> Evaluator::g_regexs;
 
+#ifdef BSQ_THREADED_DISPATCH
+const void* Evaluator::g_dispatchtable[(size_t)OpCodeTag::OpCodeTagCount + 1];
+#endif
+
+void handleStackLimitAbort(const char* stackname)
+{
+#ifdef BSQ_DEBUG_BUILD
+    std::string msg = std::string("Stack limit exceeded (") + stackname + " stack) -- raise ICPP_MAX_STACK for deeper recursion";
+    HANDLE_BSQ_ABORT(msg.c_str(), "[RUNTIME]", -1, 3);
+#else
+    HANDLE_BSQ_ABORT();
+#endif
+}
+
+void Evaluator::growCallStack_slow()
+{
+    if(Evaluator::g_callstackcapacity >= Evaluator::g_maxcallstack)
+    {
+        handleStackLimitAbort("call");
+    }
+
+    //the frames are only referenced by index (cframe is recomputed on every push/pop) so they can move
+    int32_t ncapacity = std::min(std::max(2 * Evaluator::g_callstackcapacity, (int32_t)BSQ_INITIAL_STACK), Evaluator::g_maxcallstack);
+    EvaluatorFrame* ncallstack = new EvaluatorFrame[ncapacity];
+    std::move(Evaluator::g_callstack, Evaluator::g_callstack + Evaluator::g_callstackcapacity, ncallstack);
+
+    delete[] Evaluator::g_callstack;
+    Evaluator::g_callstack = ncallstack;
+    Evaluator::g_callstackcapacity = ncapacity;
+}
+
+void Evaluator::configureStackLimits(int32_t maxcallstack)
+{
+    Evaluator::g_maxcallstack = maxcallstack;
+    GCStack::maxframes = 2 * (uint32_t)maxcallstack;
+    Allocator::maxcollectionnodes = 2 * (size_t)maxcallstack;
+}
+
 void Evaluator::evalDeadFlowOp()
 {
     //This should be unreachable
@@ -623,6 +668,32 @@ void Evaluator::evalInvokeFixedFunctionOp<false>(const InvokeFixedFunctionOp* op
     this->invoke(BSQInvokeDecl::g_invokes[op->invokeId], op->args, resl, op->optmaskoffset != -1 ? this->cframe->masksbase + op->optmaskoffset : nullptr);
 }
 
+const BSQInvokeBodyDecl* Evaluator::resolveVirtualInvoke(BSQVirtualInlineCache& icache, const BSQType* etype, BSQVirtualInvokeID invokeId)
+{
+    for(uint32_t i = 0; i < icache.count; ++i)
+    {
+        if(icache.tids[i] == etype->tid)
+        {
+            icache.hits++;
+            return icache.targets[i];
+        }
+    }
+    icache.misses++;
+
+    auto viter = etype->vtable.find(invokeId);
+    BSQ_INTERNAL_ASSERT(viter != etype->vtable.cend());
+
+    auto trgt = dynamic_cast<const BSQInvokeBodyDecl*>(BSQInvokeDecl::g_invokes[viter->second]);
+    if(icache.count < BSQ_INLINE_CACHE_SIZE)
+    {
+        icache.tids[icache.count] = etype->tid;
+        icache.targets[icache.count] = trgt;
+        icache.count++;
+    }
+
+    return trgt;
+}
+
 void Evaluator::evalInvokeVirtualFunctionOp(const InvokeVirtualFunctionOp* op)
 {
     auto sl = this->evalArgument(op->args[0]);
@@ -630,11 +701,10 @@ void Evaluator::evalInvokeVirtualFunctionOp(const InvokeVirtualFunctionOp* op)
     const BSQType* etype = op->rcvrlayouttype->getVType(sl);
     StorageLocationPtr rcvrloc = op->rcvrlayouttype->getVData_NoAlloc(sl);
 
-    auto viter = etype->vtable.find(op->invokeId);
-    BSQ_INTERNAL_ASSERT(viter != etype->vtable.cend());
+    auto trgt = this->resolveVirtualInvoke(op->icache, etype, op->invokeId);
 
     StorageLocationPtr resl = this->evalTargetVar(op->trgt);
-    this->vinvoke(dynamic_cast<const BSQInvokeBodyDecl*>(BSQInvokeDecl::g_invokes[viter->second]), rcvrloc, op->args, resl, op->optmaskoffset != -1 ? this->cframe->masksbase + op->optmaskoffset : nullptr);
+    this->vinvoke(trgt, rcvrloc, op->args, resl, op->optmaskoffset != -1 ? this->cframe->masksbase + op->optmaskoffset : nullptr);
 }
 
 void Evaluator::evalInvokeVirtualOperatorOp(const InvokeVirtualOperatorOp* op)
@@ -1121,6 +1191,127 @@ void Evaluator::evalVarHomeLocationValueUpdate(const VarHomeLocationValueUpdate*
 #endif    
 } 
 
+template <>
+InterpOp* Evaluator::evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::EqNatJumpCondOp>(const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::EqNatJumpCondOp>* op)
+{
+    PrimitiveBinaryCompareJumpCondMacro(this, op, BSQNat, ==)
+}
+
+template <>
+InterpOp* Evaluator::evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::EqIntJumpCondOp>(const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::EqIntJumpCondOp>* op)
+{
+    PrimitiveBinaryCompareJumpCondMacro(this, op, BSQInt, ==)
+}
+
+template <>
+InterpOp* Evaluator::evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::NeqNatJumpCondOp>(const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::NeqNatJumpCondOp>* op)
+{
+    PrimitiveBinaryCompareJumpCondMacro(this, op, BSQNat, !=)
+}
+
+template <>
+InterpOp* Evaluator::evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::NeqIntJumpCondOp>(const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::NeqIntJumpCondOp>* op)
+{
+    PrimitiveBinaryCompareJumpCondMacro(this, op, BSQInt, !=)
+}
+
+template <>
+InterpOp* Evaluator::evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::LtNatJumpCondOp>(const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::LtNatJumpCondOp>* op)
+{
+    PrimitiveBinaryCompareJumpCondMacro(this, op, BSQNat, <)
+}
+
+template <>
+InterpOp* Evaluator::evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::LtIntJumpCondOp>(const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::LtIntJumpCondOp>* op)
+{
+    PrimitiveBinaryCompareJumpCondMacro(this, op, BSQInt, <)
+}
+
+template <>
+InterpOp* Evaluator::evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::LeNatJumpCondOp>(const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::LeNatJumpCondOp>* op)
+{
+    PrimitiveBinaryCompareJumpCondMacro(this, op, BSQNat, <=)
+}
+
+template <>
+InterpOp* Evaluator::evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::LeIntJumpCondOp>(const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::LeIntJumpCondOp>* op)
+{
+    PrimitiveBinaryCompareJumpCondMacro(this, op, BSQInt, <=)
+}
+
+InterpOp* Evaluator::evalLoadEntityFieldDirectAssignOp(const LoadEntityFieldDirectAssignOp* op)
+{
+    this->evalLoadDirectFieldOp(op->loadop);
+
+    if(op->assignop->sguard.enabled)
+    {
+        this->evalDirectAssignOp<true>(op->assignop);
+    }
+    else
+    {
+        this->evalDirectAssignOp<false>(op->assignop);
+    }
+
+    return this->advanceCurrentOp(2);
+}
+
+InterpOp* Evaluator::evalVarLifetimeBlockOp(const VarLifetimeBlockOp* op)
+{
+#ifdef BSQ_DEBUG_BUILD
+    this->evaluateOpCode(op->firstop);
+    for(uint32_t i = 1; i < op->count; ++i)
+    {
+        this->evaluateOpCode(*(this->cframe->cpos + i));
+    }
+#endif
+
+    return this->advanceCurrentOp(op->count);
+}
+
+InterpOp* Evaluator::evalInvokeSelfTailCallOp(const InvokeSelfTailCallOp* op)
+{
+    const BSQInvokeBodyDecl* idecl = static_cast<const BSQInvokeBodyDecl*>(this->cframe->invoke);
+    uint8_t* cstack = this->cframe->scalarbase;
+
+    //args may read the current params so stage them all before the frame is overwritten -- nothing allocates until they are stored back into the (rooted) frame
+    uint8_t* argstage = (uint8_t*)BSQ_STACK_SPACE_ALLOC(op->argstagebytes);
+    uint8_t* stagepos = argstage;
+    for(size_t i = 0; i < op->invokeop->args.size(); ++i)
+    {
+        BSQ_MEM_COPY(stagepos, this->evalArgument(op->invokeop->args[i]), idecl->paramcopy[i].bytes);
+        stagepos += idecl->paramcopy[i].bytes;
+    }
+
+    GC_MEM_ZERO(this->cframe->mixedbase, idecl->mixedstackBytes);
+    GC_MEM_ZERO(this->cframe->masksbase, idecl->maskSlots * sizeof(BSQBool));
+    for(size_t i = 0; i < idecl->guardvars.size(); ++i)
+    {
+        cstack[idecl->guardvars[i]] = BSQFALSE;
+    }
+
+    stagepos = argstage;
+    for(size_t i = 0; i < idecl->paramcopy.size(); ++i)
+    {
+        BSQ_MEM_COPY(cstack + idecl->paramcopy[i].foffset, stagepos, idecl->paramcopy[i].bytes);
+        stagepos += idecl->paramcopy[i].bytes;
+    }
+
+    this->cframe->argmask = nullptr;
+#ifdef BSQ_DEBUG_BUILD
+    this->cframe->dbg_locals.clear();
+#endif
+
+#ifdef BSQ_PROFILE
+    if(Profiler::g_profiler != nullptr)
+    {
+        Profiler::g_profiler->countTailCall(idecl);
+    }
+#endif
+
+    this->cframe->cpos = idecl->body.data();
+    return *this->cframe->cpos;
+}
+
 void Evaluator::evaluateOpCode(const InterpOp* op)
 {    
     switch(op->tag)
@@ -1855,8 +2046,290 @@ void Evaluator::evaluateOpCode(const InterpOp* op)
     }
 }
 
+#ifdef BSQ_THREADED_DISPATCH
+
+#ifdef BSQ_DEBUG_BUILD
+#define BSQ_DISPATCH_DEBUG_HOOK(OP) if(this->debuggerattached) { if(this->advanceLineAndProcsssBP(OP)) { Evaluator::fpDebuggerAction(this); } }
+#else
+#define BSQ_DISPATCH_DEBUG_HOOK(OP)
+#endif
+
+#define BSQ_DISPATCH_OP(OP) BSQ_DISPATCH_DEBUG_HOOK(OP) goto *((OP)->dispatch);
+#define BSQ_DISPATCH_NEXT() if(++this->cframe->cpos == this->cframe->epos) { return; } op = *this->cframe->cpos; BSQ_DISPATCH_OP(op)
+#define BSQ_DISPATCH_JUMP(NOP) op = NOP; if(op == nullptr) { return; } BSQ_DISPATCH_OP(op)
+
+#define BSQ_DISPATCH_LINK(TAG) Evaluator::g_dispatchtable[(size_t)OpCodeTag::TAG] = &&L_##TAG;
+#define BSQ_PROFILE_DISPATCH_SLOT ((size_t)OpCodeTag::OpCodeTagCount)
+
+void Evaluator::evaluateOpCodeBlocksThreaded(bool linkonly)
+{
+    //
+    //Ops that are hot in typical code get a dedicated label, everything else is linked to the generic label and goes through the evaluateOpCode switch
+    //
+    if(linkonly)
+    {
+        for(size_t i = 0; i < (size_t)OpCodeTag::OpCodeTagCount; ++i)
+        {
+            Evaluator::g_dispatchtable[i] = &&L_Generic;
+        }
+
+        BSQ_DISPATCH_LINK(JumpOp)
+        BSQ_DISPATCH_LINK(JumpCondOp)
+        BSQ_DISPATCH_LINK(JumpNoneOp)
+        BSQ_DISPATCH_LINK(DirectAssignOp)
+        BSQ_DISPATCH_LINK(LoadEntityFieldDirectOp)
+        BSQ_DISPATCH_LINK(InvokeFixedFunctionOp)
+        BSQ_DISPATCH_LINK(PrefixNotOp)
+        BSQ_DISPATCH_LINK(RegisterAssignOp)
+        BSQ_DISPATCH_LINK(ReturnAssignOp)
+        BSQ_DISPATCH_LINK(VarLifetimeStartOp)
+        BSQ_DISPATCH_LINK(VarLifetimeEndOp)
+        BSQ_DISPATCH_LINK(AddNatOp)
+        BSQ_DISPATCH_LINK(AddIntOp)
+        BSQ_DISPATCH_LINK(SubNatOp)
+        BSQ_DISPATCH_LINK(SubIntOp)
+        BSQ_DISPATCH_LINK(MultNatOp)
+        BSQ_DISPATCH_LINK(MultIntOp)
+        BSQ_DISPATCH_LINK(EqNatOp)
+        BSQ_DISPATCH_LINK(EqIntOp)
+        BSQ_DISPATCH_LINK(NeqNatOp)
+        BSQ_DISPATCH_LINK(NeqIntOp)
+        BSQ_DISPATCH_LINK(LtNatOp)
+        BSQ_DISPATCH_LINK(LtIntOp)
+        BSQ_DISPATCH_LINK(LeNatOp)
+        BSQ_DISPATCH_LINK(LeIntOp)
+        BSQ_DISPATCH_LINK(EqNatJumpCondOp)
+        BSQ_DISPATCH_LINK(EqIntJumpCondOp)
+        BSQ_DISPATCH_LINK(NeqNatJumpCondOp)
+        BSQ_DISPATCH_LINK(NeqIntJumpCondOp)
+        BSQ_DISPATCH_LINK(LtNatJumpCondOp)
+        BSQ_DISPATCH_LINK(LtIntJumpCondOp)
+        BSQ_DISPATCH_LINK(LeNatJumpCondOp)
+        BSQ_DISPATCH_LINK(LeIntJumpCondOp)
+        BSQ_DISPATCH_LINK(LoadEntityFieldDirectAssignOp)
+        BSQ_DISPATCH_LINK(VarLifetimeBlockOp)
+        BSQ_DISPATCH_LINK(InvokeSelfTailCallOp)
+
+#ifdef BSQ_PROFILE
+        Evaluator::g_dispatchtable[BSQ_PROFILE_DISPATCH_SLOT] = &&L_Profile;
+#endif
+
+        return;
+    }
+
+    InterpOp* op = this->getCurrentOp();
+    BSQ_DISPATCH_OP(op)
+
+#ifdef BSQ_PROFILE
+L_Profile:
+    {
+        Profiler::g_profiler->countOp(static_cast<const BSQInvokeBodyDecl*>(this->cframe->invoke), this->cframe->cpos);
+        goto *Evaluator::g_dispatchtable[(size_t)op->tag];
+    }
+#endif
+L_Generic:
+    {
+        this->evaluateOpCode(op);
+        BSQ_DISPATCH_NEXT()
+    }
+L_JumpOp:
+    {
+        BSQ_DISPATCH_JUMP(this->evalJumpOp(static_cast<const JumpOp*>(op)))
+    }
+L_JumpCondOp:
+    {
+        BSQ_DISPATCH_JUMP(this->evalJumpCondOp(static_cast<const JumpCondOp*>(op)))
+    }
+L_JumpNoneOp:
+    {
+        BSQ_DISPATCH_JUMP(this->evalJumpNoneOp(static_cast<const JumpNoneOp*>(op)))
+    }
+L_DirectAssignOp:
+    {
+        auto daop = static_cast<const DirectAssignOp*>(op);
+        if(daop->sguard.enabled)
+        {
+            this->evalDirectAssignOp<true>(daop);
+        }
+        else
+        {
+            this->evalDirectAssignOp<false>(daop);
+        }
+        BSQ_DISPATCH_NEXT()
+    }
+L_LoadEntityFieldDirectOp:
+    {
+        this->evalLoadDirectFieldOp(static_cast<const LoadEntityFieldDirectOp*>(op));
+        BSQ_DISPATCH_NEXT()
+    }
+L_InvokeFixedFunctionOp:
+    {
+        auto opc = static_cast<const InvokeFixedFunctionOp*>(op);
+        if(opc->sguard.enabled)
+        {
+            this->evalInvokeFixedFunctionOp<true>(opc);
+        }
+        else
+        {
+            this->evalInvokeFixedFunctionOp<false>(opc);
+        }
+        BSQ_DISPATCH_NEXT()
+    }
+L_PrefixNotOp:
+    {
+        this->evalPrefixNotOp(static_cast<const PrefixNotOp*>(op));
+        BSQ_DISPATCH_NEXT()
+    }
+L_RegisterAssignOp:
+    {
+        auto opc = static_cast<const RegisterAssignOp*>(op);
+        if(opc->sguard.enabled)
+        {
+            this->evalRegisterAssignOp<true>(opc);
+        }
+        else
+        {
+            this->evalRegisterAssignOp<false>(opc);
+        }
+        BSQ_DISPATCH_NEXT()
+    }
+L_ReturnAssignOp:
+    {
+        this->evalReturnAssignOp(static_cast<const ReturnAssignOp*>(op));
+        BSQ_DISPATCH_NEXT()
+    }
+L_VarLifetimeStartOp:
+    {
+        this->evalVarLifetimeStartOp(static_cast<const VarLifetimeStartOp*>(op));
+        BSQ_DISPATCH_NEXT()
+    }
+L_VarLifetimeEndOp:
+    {
+        this->evalVarLifetimeEndOp(static_cast<const VarLifetimeEndOp*>(op));
+        BSQ_DISPATCH_NEXT()
+    }
+L_AddNatOp:
+    {
+        PrimitiveBinaryOperatorMacroChecked(this, op, OpCodeTag::AddNatOp, BSQNat, +, __builtin_add_overflow, "Nat addition overflow")
+        BSQ_DISPATCH_NEXT()
+    }
+L_AddIntOp:
+    {
+        PrimitiveBinaryOperatorMacroChecked(this, op, OpCodeTag::AddIntOp, BSQInt, +, __builtin_add_overflow, "Int addition overflow/underflow")
+        BSQ_DISPATCH_NEXT()
+    }
+L_SubNatOp:
+    {
+        PrimitiveBinaryOperatorMacroChecked(this, op, OpCodeTag::SubNatOp, BSQNat, -, __builtin_sub_overflow, "Nat subtraction overflow")
+        BSQ_DISPATCH_NEXT()
+    }
+L_SubIntOp:
+    {
+        PrimitiveBinaryOperatorMacroChecked(this, op, OpCodeTag::SubIntOp, BSQInt, -, __builtin_sub_overflow, "Int subtraction overflow/underflow")
+        BSQ_DISPATCH_NEXT()
+    }
+L_MultNatOp:
+    {
+        PrimitiveBinaryOperatorMacroChecked(this, op, OpCodeTag::MultNatOp, BSQNat, *, __builtin_mul_overflow, "Nat multiplication overflow")
+        BSQ_DISPATCH_NEXT()
+    }
+L_MultIntOp:
+    {
+        PrimitiveBinaryOperatorMacroChecked(this, op, OpCodeTag::MultIntOp, BSQInt, *, __builtin_mul_overflow, "Int multiplication underflow/overflow")
+        BSQ_DISPATCH_NEXT()
+    }
+L_EqNatOp:
+    {
+        PrimitiveBinaryComparatorMacroSafe(this, op, OpCodeTag::EqNatOp, BSQNat, ==)
+        BSQ_DISPATCH_NEXT()
+    }
+L_EqIntOp:
+    {
+        PrimitiveBinaryComparatorMacroSafe(this, op, OpCodeTag::EqIntOp, BSQInt, ==)
+        BSQ_DISPATCH_NEXT()
+    }
+L_NeqNatOp:
+    {
+        PrimitiveBinaryComparatorMacroSafe(this, op, OpCodeTag::NeqNatOp, BSQNat, !=)
+        BSQ_DISPATCH_NEXT()
+    }
+L_NeqIntOp:
+    {
+        PrimitiveBinaryComparatorMacroSafe(this, op, OpCodeTag::NeqIntOp, BSQInt, !=)
+        BSQ_DISPATCH_NEXT()
+    }
+L_LtNatOp:
+    {
+        PrimitiveBinaryComparatorMacroSafe(this, op, OpCodeTag::LtNatOp, BSQNat, <)
+        BSQ_DISPATCH_NEXT()
+    }
+L_LtIntOp:
+    {
+        PrimitiveBinaryComparatorMacroSafe(this, op, OpCodeTag::LtIntOp, BSQInt, <)
+        BSQ_DISPATCH_NEXT()
+    }
+L_LeNatOp:
+    {
+        PrimitiveBinaryComparatorMacroSafe(this, op, OpCodeTag::LeNatOp, BSQNat, <=)
+        BSQ_DISPATCH_NEXT()
+    }
+L_LeIntOp:
+    {
+        PrimitiveBinaryComparatorMacroSafe(this, op, OpCodeTag::LeIntOp, BSQInt, <=)
+        BSQ_DISPATCH_NEXT()
+    }
+L_EqNatJumpCondOp:
+    {
+        BSQ_DISPATCH_JUMP(this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::EqNatJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::EqNatJumpCondOp>*>(op)))
+    }
+L_EqIntJumpCondOp:
+    {
+        BSQ_DISPATCH_JUMP(this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::EqIntJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::EqIntJumpCondOp>*>(op)))
+    }
+L_NeqNatJumpCondOp:
+    {
+        BSQ_DISPATCH_JUMP(this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::NeqNatJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::NeqNatJumpCondOp>*>(op)))
+    }
+L_NeqIntJumpCondOp:
+    {
+        BSQ_DISPATCH_JUMP(this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::NeqIntJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::NeqIntJumpCondOp>*>(op)))
+    }
+L_LtNatJumpCondOp:
+    {
+        BSQ_DISPATCH_JUMP(this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::LtNatJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::LtNatJumpCondOp>*>(op)))
+    }
+L_LtIntJumpCondOp:
+    {
+        BSQ_DISPATCH_JUMP(this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::LtIntJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::LtIntJumpCondOp>*>(op)))
+    }
+L_LeNatJumpCondOp:
+    {
+        BSQ_DISPATCH_JUMP(this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::LeNatJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::LeNatJumpCondOp>*>(op)))
+    }
+L_LeIntJumpCondOp:
+    {
+        BSQ_DISPATCH_JUMP(this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::LeIntJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::LeIntJumpCondOp>*>(op)))
+    }
+L_LoadEntityFieldDirectAssignOp:
+    {
+        BSQ_DISPATCH_JUMP(this->evalLoadEntityFieldDirectAssignOp(static_cast<const LoadEntityFieldDirectAssignOp*>(op)))
+    }
+L_VarLifetimeBlockOp:
+    {
+        BSQ_DISPATCH_JUMP(this->evalVarLifetimeBlockOp(static_cast<const VarLifetimeBlockOp*>(op)))
+    }
+L_InvokeSelfTailCallOp:
+    {
+        BSQ_DISPATCH_JUMP(this->evalInvokeSelfTailCallOp(static_cast<const InvokeSelfTailCallOp*>(op)))
+    }
+}
+#endif
+
 void Evaluator::evaluateOpCodeBlocks()
 {
+#ifdef BSQ_THREADED_DISPATCH
+    this->evaluateOpCodeBlocksThreaded(false);
+#else
     InterpOp* op = this->getCurrentOp();
     do
     {
@@ -1870,6 +2343,13 @@ void Evaluator::evaluateOpCodeBlocks()
         }
 #endif
 
+#ifdef BSQ_PROFILE
+        if(Profiler::g_profiler != nullptr)
+        {
+            Profiler::g_profiler->countOp(static_cast<const BSQInvokeBodyDecl*>(this->cframe->invoke), this->cframe->cpos);
+        }
+#endif
+
         switch(op->tag)
         {
         case OpCodeTag::JumpOp:
@@ -1887,6 +2367,61 @@ void Evaluator::evaluateOpCodeBlocks()
             op = this->evalJumpNoneOp(static_cast<const JumpNoneOp*>(op));
             break;
         }
+        case OpCodeTag::EqNatJumpCondOp:
+        {
+            op = this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::EqNatJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::EqNatJumpCondOp>*>(op));
+            break;
+        }
+        case OpCodeTag::EqIntJumpCondOp:
+        {
+            op = this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::EqIntJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::EqIntJumpCondOp>*>(op));
+            break;
+        }
+        case OpCodeTag::NeqNatJumpCondOp:
+        {
+            op = this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::NeqNatJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::NeqNatJumpCondOp>*>(op));
+            break;
+        }
+        case OpCodeTag::NeqIntJumpCondOp:
+        {
+            op = this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::NeqIntJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::NeqIntJumpCondOp>*>(op));
+            break;
+        }
+        case OpCodeTag::LtNatJumpCondOp:
+        {
+            op = this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::LtNatJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::LtNatJumpCondOp>*>(op));
+            break;
+        }
+        case OpCodeTag::LtIntJumpCondOp:
+        {
+            op = this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::LtIntJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::LtIntJumpCondOp>*>(op));
+            break;
+        }
+        case OpCodeTag::LeNatJumpCondOp:
+        {
+            op = this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::LeNatJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::LeNatJumpCondOp>*>(op));
+            break;
+        }
+        case OpCodeTag::LeIntJumpCondOp:
+        {
+            op = this->evalPrimitiveBinaryCompareJumpCondOp<OpCodeTag::LeIntJumpCondOp>(static_cast<const PrimitiveBinaryCompareJumpCondOp<OpCodeTag::LeIntJumpCondOp>*>(op));
+            break;
+        }
+        case OpCodeTag::LoadEntityFieldDirectAssignOp:
+        {
+            op = this->evalLoadEntityFieldDirectAssignOp(static_cast<const LoadEntityFieldDirectAssignOp*>(op));
+            break;
+        }
+        case OpCodeTag::VarLifetimeBlockOp:
+        {
+            op = this->evalVarLifetimeBlockOp(static_cast<const VarLifetimeBlockOp*>(op));
+            break;
+        }
+        case OpCodeTag::InvokeSelfTailCallOp:
+        {
+            op = this->evalInvokeSelfTailCallOp(static_cast<const InvokeSelfTailCallOp*>(op));
+            break;
+        }
         default:
         {
             this->evaluateOpCode(op);
@@ -1895,8 +2430,9 @@ void Evaluator::evaluateOpCodeBlocks()
         }
         }
     } while (this->hasMoreOps());
+#endif
 }
-    
+
 void Evaluator::evaluateBody(StorageLocationPtr resultsl, const BSQType* restype, Argument resarg)
 {
     this->evaluateOpCodeBlocks();
@@ -1907,27 +2443,24 @@ void Evaluator::invoke(const BSQInvokeDecl* call, const std::vector<Argument>& a
 {
     if(call->isPrimitive())
     {
-        std::vector<StorageLocationPtr> pv(args.size(), (StorageLocationPtr)nullptr);
-        std::transform(args.cbegin(), args.cend(), pv.begin(), [this](const Argument& arg) {
+        StorageLocationPtr* pv = (StorageLocationPtr*)BSQ_STACK_SPACE_ALLOC(args.size() * sizeof(StorageLocationPtr));
+        std::transform(args.cbegin(), args.cend(), pv, [this](const Argument& arg) {
             return this->evalArgument(arg);
         });
 
-        this->evaluatePrimitiveBody((const BSQInvokePrimitiveDecl*)call, pv, resultsl, call->resultType);
+        this->evaluatePrimitiveBody((const BSQInvokePrimitiveDecl*)call, StorageLocationSpan(pv, args.size()), resultsl, call->resultType);
     }
     else
     {
         const BSQInvokeBodyDecl* idecl = (const BSQInvokeBodyDecl*)call;
 
-        size_t cssize = idecl->scalarstackBytes + idecl->mixedstackBytes;
-        uint8_t* cstack = (uint8_t*)BSQ_STACK_SPACE_ALLOC(cssize);
-        GC_MEM_ZERO(cstack, cssize);
+        //only the mixed (GC visible) part of the frame needs clearing -- the prelude zeroes the scalar slots that can be read before the body writes them
+        uint8_t* cstack = (uint8_t*)BSQ_STACK_SPACE_ALLOC(idecl->scalarstackBytes + idecl->mixedstackBytes);
+        GC_MEM_ZERO(cstack + idecl->scalarstackBytes, idecl->mixedstackBytes);
 
         for(size_t i = 0; i < args.size(); ++i)
         {
-            StorageLocationPtr argv = this->evalArgument(args[i]);
-            StorageLocationPtr pv = Evaluator::evalParameterInfo(idecl->paraminfo[i], cstack, cstack + idecl->scalarstackBytes);
-            
-            idecl->params[i].ptype->storeValue(pv, argv);
+            BSQ_MEM_COPY(cstack + idecl->paramcopy[i].foffset, this->evalArgument(args[i]), idecl->paramcopy[i].bytes);
         }
 
         size_t maskslotbytes = idecl->maskSlots * sizeof(BSQBool);
@@ -1942,19 +2475,13 @@ void Evaluator::invoke(const BSQInvokeDecl* call, const std::vector<Argument>& a
 
 void Evaluator::vinvoke(const BSQInvokeBodyDecl* idecl, StorageLocationPtr rcvr, const std::vector<Argument>& args, StorageLocationPtr resultsl, BSQBool* optmask)
 {
-    size_t cssize = idecl->scalarstackBytes + idecl->mixedstackBytes;
-    uint8_t* cstack = (uint8_t*)BSQ_STACK_SPACE_ALLOC(cssize);
-    GC_MEM_ZERO(cstack, cssize);
-
-    StorageLocationPtr pv = Evaluator::evalParameterInfo(idecl->paraminfo[0], cstack, cstack + idecl->scalarstackBytes);
-    idecl->params[0].ptype->storeValue(pv, rcvr);
+    uint8_t* cstack = (uint8_t*)BSQ_STACK_SPACE_ALLOC(idecl->scalarstackBytes + idecl->mixedstackBytes);
+    GC_MEM_ZERO(cstack + idecl->scalarstackBytes, idecl->mixedstackBytes);
 
+    BSQ_MEM_COPY(cstack + idecl->paramcopy[0].foffset, rcvr, idecl->paramcopy[0].bytes);
     for(size_t i = 1; i < args.size(); ++i)
     {
-        StorageLocationPtr argv = this->evalArgument(args[i]);
-        StorageLocationPtr pv = Evaluator::evalParameterInfo(idecl->paraminfo[i], cstack, cstack + idecl->scalarstackBytes);
-            
-        idecl->params[i].ptype->storeValue(pv, argv);
+        BSQ_MEM_COPY(cstack + idecl->paramcopy[i].foffset, this->evalArgument(args[i]), idecl->paramcopy[i].bytes);
     }
 
     size_t maskslotbytes = idecl->maskSlots * sizeof(BSQBool);
@@ -1970,11 +2497,36 @@ void Evaluator::invokePrelude(const BSQInvokeBodyDecl* invk, uint8_t* cstack, ui
 {
     uint8_t* mixedslots = cstack + invk->scalarstackBytes;
 
+    //the scalar part of the frame is not cleared -- zero the optional args that were not passed (the trailing argmaskSize params) and the guard flag vars
+    if(optmask != nullptr)
+    {
+        size_t optstart = invk->paramcopy.size() - invk->argmaskSize;
+        for(size_t i = 0; i < invk->argmaskSize; ++i)
+        {
+            if(!optmask[i])
+            {
+                GC_MEM_ZERO(cstack + invk->paramcopy[optstart + i].foffset, invk->paramcopy[optstart + i].bytes);
+            }
+        }
+    }
+
+    for(size_t i = 0; i < invk->guardvars.size(); ++i)
+    {
+        cstack[invk->guardvars[i]] = BSQFALSE;
+    }
+
+#ifdef BSQ_PROFILE
+    if(Profiler::g_profiler != nullptr)
+    {
+        Profiler::g_profiler->enterInvoke(invk);
+    }
+#endif
+
     GCStack::pushFrame((void**)mixedslots, invk->mixedMask);
 #ifdef BSQ_DEBUG_BUILD
-    this->pushFrame(this->computeCallIntoStepMode(), this->computeCurrentBreakpoint(), invk, cstack, mixedslots, optmask, maskslots, &invk->body);
+    this->pushFrame(this->computeCallIntoStepMode(), this->computeCurrentBreakpoint(), invk, cstack, mixedslots, optmask, maskslots, invk->body.data(), invk->body.size());
 #else
-    this->pushFrame(invk, cstack, mixedslots, optmask, maskslots, &invk->body);
+    this->pushFrame(invk, cstack, mixedslots, optmask, maskslots, invk->body.data(), invk->body.size());
 #endif
 }
     
@@ -1982,9 +2534,16 @@ void Evaluator::invokePostlude()
 {
     this->popFrame();
     GCStack::popFrame();
+
+#ifdef BSQ_PROFILE
+    if(Profiler::g_profiler != nullptr)
+    {
+        Profiler::g_profiler->exitInvoke();
+    }
+#endif
 }
 
-void Evaluator::evaluatePrimitiveBody(const BSQInvokePrimitiveDecl* invk, const std::vector<StorageLocationPtr>& params, StorageLocationPtr resultsl, const BSQType* restype)
+void Evaluator::evaluatePrimitiveBody(const BSQInvokePrimitiveDecl* invk, StorageLocationSpan params, StorageLocationPtr resultsl, const BSQType* restype)
 {
     LambdaEvalThunk eethunk(this);
 
@@ -2311,7 +2870,6 @@ void Evaluator::evaluatePrimitiveBody(const BSQInvokePrimitiveDecl* invk, const
     case BSQPrimitiveImplTag::s_list_append_ne: {
         const BSQListTypeFlavor& lflavor = BSQListOps::g_flavormap.find(invk->binds.find("T")->second->tid)->second;
 
-        Allocator::GlobalAllocator.ensureSpace(std::max(lflavor.pv8type->allocinfo.heapsize, lflavor.treetype->allocinfo.heapsize) + sizeof(GC_META_DATA_WORD));
         auto rr = BSQListOps::list_append(lflavor, LIST_LOAD_DATA(params[0]), LIST_LOAD_DATA(params[1]));
         LIST_STORE_RESULT_REPR(rr, resultsl);
         break;
@@ -2319,25 +2877,25 @@ void Evaluator::evaluatePrimitiveBody(const BSQInvokePrimitiveDecl* invk, const
     case BSQPrimitiveImplTag::s_list_slice_start: {
         const BSQListTypeFlavor& lflavor = BSQListOps::g_flavormap.find(invk->binds.find("T")->second->tid)->second;
 
-        BSQListSpineIterator liter(LIST_LOAD_TYPE_INFO_REPR(params[0]), LIST_LOAD_DATA(params[0]));
-        Allocator::GlobalAllocator.registerCollectionIterator(&liter);
+        auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
+        auto rnode = Allocator::GlobalAllocator.registerCollectionNode(LIST_LOAD_DATA(params[0]));
 
-        auto rr = BSQListOps::s_slice_start(lflavor, liter, LIST_LOAD_TYPE_INFO_REPR(params[0]), SLPTR_LOAD_CONTENTS_AS(BSQNat, params[1]), 0);
+        auto rr = BSQListOps::s_slice_start_ne(lflavor, rnode, SLPTR_LOAD_CONTENTS_AS(BSQNat, params[1]));
         LIST_STORE_RESULT_REPR(rr, resultsl);
-        
-        Allocator::GlobalAllocator.releaseCollectionIterator(&liter);
+
+        Allocator::GlobalAllocator.resetCollectionNodeEnd(gcpoint);
         break;
     }
     case BSQPrimitiveImplTag::s_list_slice_end: {
         const BSQListTypeFlavor& lflavor = BSQListOps::g_flavormap.find(invk->binds.find("T")->second->tid)->second;
 
-        BSQListSpineIterator liter(LIST_LOAD_TYPE_INFO_REPR(params[0]), LIST_LOAD_DATA(params[0]));
-        Allocator::GlobalAllocator.registerCollectionIterator(&liter);
+        auto gcpoint = Allocator::GlobalAllocator.getCollectionNodeCurrentEnd();
+        auto rnode = Allocator::GlobalAllocator.registerCollectionNode(LIST_LOAD_DATA(params[0]));
 
-        auto rr = BSQListOps::s_slice_end(lflavor, liter, LIST_LOAD_TYPE_INFO_REPR(params[0]), SLPTR_LOAD_CONTENTS_AS(BSQNat, params[1]), 0);
+        auto rr = BSQListOps::s_slice_end_ne(lflavor, rnode, SLPTR_LOAD_CONTENTS_AS(BSQNat, params[1]));
         LIST_STORE_RESULT_REPR(rr, resultsl);
-        
-        Allocator::GlobalAllocator.releaseCollectionIterator(&liter);
+
+        Allocator::GlobalAllocator.resetCollectionNodeEnd(gcpoint);
         break;
     }
     case BSQPrimitiveImplTag::s_list_safe_get: {
@@ -2439,16 +2997,34 @@ void Evaluator::evaluatePrimitiveBody(const BSQInvokePrimitiveDecl* invk, const
         break;
     }
     case BSQPrimitiveImplTag::s_map_has_ne: {
-        auto rr = BSQMapOps::s_lookup_ne(MAP_LOAD_REPR(params[0]), MAP_LOAD_TYPE_INFO_REPR(params[0]), params[1], invk->binds.find("K")->second);
+        void* rr = nullptr;
+        if(BSQMapOps::isHashRepr(MAP_LOAD_TYPE_INFO(params[0])))
+        {
+            rr = BSQMapOps::s_hash_lookup_ne(MAP_LOAD_REPR(params[0]), params[1], invk->binds.find("K")->second);
+        }
+        else
+        {
+            rr = BSQMapOps::s_lookup_ne(MAP_LOAD_REPR(params[0]), MAP_LOAD_TYPE_INFO_REPR(params[0]), params[1], invk->binds.find("K")->second);
+        }
         SLPTR_STORE_CONTENTS_AS(BSQBool, resultsl, (BSQBool)(rr != nullptr));
         break;
     }
     case BSQPrimitiveImplTag::s_map_find_ne: {
-        auto ttype = MAP_LOAD_TYPE_INFO_REPR(params[0]);
-        auto rr = BSQMapOps::s_lookup_ne(MAP_LOAD_REPR(params[0]), ttype, params[1], invk->binds.find("K")->second);
-        BSQ_INTERNAL_ASSERT(rr != nullptr);
+        if(BSQMapOps::isHashRepr(MAP_LOAD_TYPE_INFO(params[0])))
+        {
+            auto rr = BSQMapOps::s_hash_lookup_ne(MAP_LOAD_REPR(params[0]), params[1], invk->binds.find("K")->second);
+            BSQ_INTERNAL_ASSERT(rr != nullptr);
 
-        invk->binds.find("K")->second->storeValue(resultsl, ttype->getValueLocation(rr));
+            invk->binds.find("V")->second->storeValue(resultsl, static_cast<const BSQMapHashLeafType*>(GET_TYPE_META_DATA(rr))->getValueLocation(rr));
+        }
+        else
+        {
+            auto ttype = MAP_LOAD_TYPE_INFO_REPR(params[0]);
+            auto rr = BSQMapOps::s_lookup_ne(MAP_LOAD_REPR(params[0]), ttype, params[1], invk->binds.find("K")->second);
+            BSQ_INTERNAL_ASSERT(rr != nullptr);
+
+            invk->binds.find("V")->second->storeValue(resultsl, ttype->getValueLocation(rr));
+        }
         break;
     }
     case BSQPrimitiveImplTag::s_map_union_ne: {
@@ -2463,7 +3039,14 @@ void Evaluator::evaluatePrimitiveBody(const BSQInvokePrimitiveDecl* invk, const
         const BSQMapTypeFlavor& mflavor = BSQMapOps::g_flavormap.find(std::make_pair(invk->binds.find("K")->second->tid, invk->binds.find("V")->second->tid))->second;
 
         auto rr = BSQMapOps::s_submap_ne(mflavor, eethunk, MAP_LOAD_REPR(params[0]), MAP_LOAD_TYPE_INFO_REPR(params[0]), invk->pcodes.find("p")->second, params);
-        MAP_STORE_RESULT_REPR(rr.first, rr.second, resultsl);
+        if(rr.first == nullptr)
+        {
+            MAP_STORE_RESULT_EMPTY(resultsl);
+        }
+        else
+        {
+            MAP_STORE_RESULT_REPR(rr.first, rr.second, resultsl);
+        }
         break;
     }
     case BSQPrimitiveImplTag::s_map_remap_ne: {
@@ -2492,7 +3075,14 @@ void Evaluator::evaluatePrimitiveBody(const BSQInvokePrimitiveDecl* invk, const
         const BSQMapTypeFlavor& mflavor = BSQMapOps::g_flavormap.find(std::make_pair(invk->binds.find("K")->second->tid, invk->binds.find("V")->second->tid))->second;
 
         auto rr = BSQMapOps::s_remove_ne(mflavor, MAP_LOAD_REPR(params[0]), MAP_LOAD_TYPE_INFO_REPR(params[0]), params[1]);
-        MAP_STORE_RESULT_REPR(rr, MAP_LOAD_COUNT(params[0]) - 1, resultsl);
+        if(rr == nullptr)
+        {
+            MAP_STORE_RESULT_EMPTY(resultsl);
+        }
+        else
+        {
+            MAP_STORE_RESULT_REPR(rr, MAP_LOAD_COUNT(params[0]) - 1, resultsl);
+        }
         break;
     }
     default: {
@@ -2502,17 +3092,66 @@ void Evaluator::evaluatePrimitiveBody(const BSQInvokePrimitiveDecl* invk, const
     }
 }
 
+void Evaluator::linkOpDispatch()
+{
+#ifdef BSQ_THREADED_DISPATCH
+    this->evaluateOpCodeBlocksThreaded(true);
+
+    for(size_t i = 0; i < BSQInvokeDecl::g_invokes.size(); ++i)
+    {
+        auto invk = BSQInvokeDecl::g_invokes[i];
+        if(invk != nullptr && !invk->isPrimitive())
+        {
+            const std::vector<InterpOp*>& body = static_cast<const BSQInvokeBodyDecl*>(invk)->body;
+            for(size_t j = 0; j < body.size(); ++j)
+            {
+#ifdef BSQ_PROFILE
+                body[j]->dispatch = (Profiler::g_profiler == nullptr) ? Evaluator::g_dispatchtable[(size_t)body[j]->tag] : Evaluator::g_dispatchtable[BSQ_PROFILE_DISPATCH_SLOT];
+#else
+                body[j]->dispatch = Evaluator::g_dispatchtable[(size_t)body[j]->tag];
+#endif
+            }
+        }
+    }
+#endif
+}
+
+void Evaluator::displayInlineCacheStats(FILE* fp)
+{
+    for(size_t i = 0; i < BSQInvokeDecl::g_invokes.size(); ++i)
+    {
+        auto invk = BSQInvokeDecl::g_invokes[i];
+        if(invk == nullptr || invk->isPrimitive())
+        {
+            continue;
+        }
+
+        auto idecl = static_cast<const BSQInvokeBodyDecl*>(invk);
+        for(size_t j = 0; j < idecl->body.size(); ++j)
+        {
+            if(idecl->body[j]->tag == OpCodeTag::InvokeVirtualFunctionOp)
+            {
+                auto vop = static_cast<const InvokeVirtualFunctionOp*>(idecl->body[j]);
+                if(vop->icache.hits + vop->icache.misses != 0)
+                {
+                    auto kind = (vop->icache.count <= 1) ? "mono" : ((vop->icache.count == BSQ_INLINE_CACHE_SIZE && vop->icache.misses > vop->icache.count) ? "mega" : "poly");
+                    fprintf(fp, "%s@%i -- %s hits: %" PRIu64 " misses: %" PRIu64 "\n", idecl->name.c_str(), (int)vop->sinfo.line, kind, vop->icache.hits, vop->icache.misses);
+                }
+            }
+        }
+    }
+    fflush(fp);
+}
+
 void Evaluator::invokeGlobalCons(const BSQInvokeBodyDecl* invk, StorageLocationPtr resultsl, const BSQType* restype, Argument resarg)
 {
-    size_t cssize = invk->scalarstackBytes + invk->mixedstackBytes;
-    uint8_t* cstack = (uint8_t*)BSQ_STACK_SPACE_ALLOC(cssize);
-    GC_MEM_ZERO(cstack, cssize);
+    uint8_t* cstack = (uint8_t*)BSQ_STACK_SPACE_ALLOC(invk->scalarstackBytes + invk->mixedstackBytes);
+    GC_MEM_ZERO(cstack + invk->scalarstackBytes, invk->mixedstackBytes);
 
     size_t maskslotbytes = invk->maskSlots * sizeof(BSQBool);
     BSQBool* maskslots = (BSQBool*)BSQ_STACK_SPACE_ALLOC(maskslotbytes);
     GC_MEM_ZERO(maskslots, maskslotbytes);
 
-
     this->invokePrelude(invk, cstack, maskslots, nullptr);
     this->evaluateBody(resultsl, restype, resarg);
     this->invokePostlude();
@@ -2533,16 +3172,14 @@ void Evaluator::invokeMain(const BSQInvokeBodyDecl* invk, uint8_t* istack, Stora
     this->invokePostlude();
 }
 
-void Evaluator::linvoke(const BSQInvokeBodyDecl* call, const std::vector<StorageLocationPtr>& args, StorageLocationPtr resultsl)
+void Evaluator::linvoke(const BSQInvokeBodyDecl* call, StorageLocationSpan args, StorageLocationPtr resultsl)
 {
-    size_t cssize = call->scalarstackBytes + call->mixedstackBytes;
-    uint8_t* cstack = (uint8_t*)BSQ_STACK_SPACE_ALLOC(cssize);
-    GC_MEM_ZERO(cstack, cssize);
+    uint8_t* cstack = (uint8_t*)BSQ_STACK_SPACE_ALLOC(call->scalarstackBytes + call->mixedstackBytes);
+    GC_MEM_ZERO(cstack + call->scalarstackBytes, call->mixedstackBytes);
 
     for(size_t i = 0; i < args.size(); ++i)
     {
-        StorageLocationPtr pv = Evaluator::evalParameterInfo(call->paraminfo[i], cstack, cstack + call->scalarstackBytes);
-        call->params[i].ptype->storeValue(pv, args[i]);
+        BSQ_MEM_COPY(cstack + call->paramcopy[i].foffset, args[i], call->paramcopy[i].bytes);
     }
 
     size_t maskslotbytes = call->maskSlots * sizeof(BSQBool);
@@ -2554,16 +3191,14 @@ void Evaluator::linvoke(const BSQInvokeBodyDecl* call, const std::vector<Storage
     this->invokePostlude();
 }
 
-bool Evaluator::iinvoke(const BSQInvokeBodyDecl* call, const std::vector<StorageLocationPtr>& args, BSQBool* optmask)
+bool Evaluator::iinvoke(const BSQInvokeBodyDecl* call, StorageLocationSpan args, BSQBool* optmask)
 {
-    size_t cssize = call->scalarstackBytes + call->mixedstackBytes;
-    uint8_t* cstack = (uint8_t*)BSQ_STACK_SPACE_ALLOC(cssize);
-    GC_MEM_ZERO(cstack, cssize);
+    uint8_t* cstack = (uint8_t*)BSQ_STACK_SPACE_ALLOC(call->scalarstackBytes + call->mixedstackBytes);
+    GC_MEM_ZERO(cstack + call->scalarstackBytes, call->mixedstackBytes);
 
     for(size_t i = 0; i < args.size(); ++i)
     {
-        StorageLocationPtr pv = Evaluator::evalParameterInfo(call->paraminfo[i], cstack, cstack + call->scalarstackBytes);
-        call->params[i].ptype->storeValue(pv, args[i]);
+        BSQ_MEM_COPY(cstack + call->paramcopy[i].foffset, args[i], call->paramcopy[i].bytes);
     }
 
     size_t maskslotbytes = call->maskSlots * sizeof(BSQBool);
@@ -2578,16 +3213,14 @@ bool Evaluator::iinvoke(const BSQInvokeBodyDecl* call, const std::vector<Storage
     return (bool)ok;
 }
 
-void Evaluator::cinvoke(const BSQInvokeBodyDecl* call, const std::vector<StorageLocationPtr>& args, BSQBool* optmask, StorageLocationPtr resultsl)
+void Evaluator::cinvoke(const BSQInvokeBodyDecl* call, StorageLocationSpan args, BSQBool* optmask, StorageLocationPtr resultsl)
 {
-    size_t cssize = call->scalarstackBytes + call->mixedstackBytes;
-    uint8_t* cstack = (uint8_t*)BSQ_STACK_SPACE_ALLOC(cssize);
-    GC_MEM_ZERO(cstack, cssize);
+    uint8_t* cstack = (uint8_t*)BSQ_STACK_SPACE_ALLOC(call->scalarstackBytes + call->mixedstackBytes);
+    GC_MEM_ZERO(cstack + call->scalarstackBytes, call->mixedstackBytes);
 
     for(size_t i = 0; i < args.size(); ++i)
     {
-        StorageLocationPtr pv = Evaluator::evalParameterInfo(call->paraminfo[i], cstack, cstack + call->scalarstackBytes);
-        call->params[i].ptype->storeValue(pv, args[i]);
+        BSQ_MEM_COPY(cstack + call->paramcopy[i].foffset, args[i], call->paramcopy[i].bytes);
     }
 
     size_t maskslotbytes = call->maskSlots * sizeof(BSQBool);
@@ -2599,7 +3232,7 @@ void Evaluator::cinvoke(const BSQInvokeBodyDecl* call, const std::vector<Storage
     this->invokePostlude();
 }
 
-void LambdaEvalThunk::invoke(const BSQInvokeBodyDecl* call, const std::vector<StorageLocationPtr>& args, StorageLocationPtr resultsl)
+void LambdaEvalThunk::invoke(const BSQInvokeBodyDecl* call, StorageLocationSpan args, StorageLocationPtr resultsl)
 {
     static_cast<Evaluator*>(this->ctx)->linvoke(call, args, resultsl);
 }
@@ -2609,9 +3242,9 @@ bool ICPPParseJSON::checkInvokeOk(const std::string& checkinvoke, StorageLocatio
     auto invkid = MarshalEnvironment::g_invokeToIdMap.find(checkinvoke)->second;
     auto invk = dynamic_cast<const BSQInvokeBodyDecl*>(BSQInvokeDecl::g_invokes[invkid]);
 
-    std::vector<StorageLocationPtr> args = {value};
+    StorageLocationPtr args[1] = {value};
     BSQBool bb = BSQFALSE;
-    ctx.linvoke(invk, args, &bb);
+    ctx.linvoke(invk, StorageLocationSpan(args, 1), &bb);
 
     return bb;
 }
@@ -3007,9 +3640,9 @@ StorageLocationPtr ICPPParseJSON::getValueForContainerElementParse(const APIModu
         const BSQMapType* maptype = dynamic_cast<const BSQMapType*>(this->containerstack.back().first);
         const BSQMapTypeFlavor& mflavor = BSQMapOps::g_flavormap.find(std::make_pair(maptype->ktype, maptype->vtype))->second;
 
-        //We are very creative here and use the fact that the kv layout in the tree is identical to the kv layout in the tuple!
-        auto rr = Allocator::GlobalAllocator.registerTempRoot(mflavor.treetype);
-        return (void*)((uint8_t*)rr->root + mflavor.treetype->keyoffset);
+        //the map is built from the parsed [K, V] tuples when the container is complete
+        auto rr = Allocator::GlobalAllocator.registerTempRoot(mflavor.tupletype);
+        return rr->root;
     }
 }
 
@@ -3028,7 +3661,7 @@ void ICPPParseJSON::completeParseContainer(const APIModule* apimodule, const ITy
         }
         else
         {
-            auto lstart = Allocator::GlobalAllocator.getTempRootCurrScope().begin();
+            auto lstart = Allocator::GlobalAllocator.getTempRootCurrScopeBegin();
             void* rres = BSQListOps::s_temp_root_to_list_rec(lflavor, lstart, this->containerstack.back().second);
 
             LIST_STORE_RESULT_REPR(rres, value);
@@ -3057,24 +3690,27 @@ void ICPPParseJSON::completeParseContainer(const APIModule* apimodule, const ITy
         }
         else
         {
-            std::list<BSQTempRootNode>& roots = Allocator::GlobalAllocator.getTempRootCurrScope();
-            std::vector<BSQTempRootNode> opv(roots.cbegin(), roots.cend());
+            BSQTempRootNode* lstart = Allocator::GlobalAllocator.getTempRootCurrScopeBegin();
+            auto lsize = Allocator::GlobalAllocator.getTempRootCurrScopeSize();
 
-            std::stable_sort(opv.begin(), opv.end(), [&](const BSQTempRootNode& ln, const BSQTempRootNode& rn) {
-                return mflavor.keytype->fpkeycmp(mflavor.keytype, mflavor.treetype->getKeyLocation(ln.root), mflavor.treetype->getKeyLocation(rn.root)) < 0;
-            });
-
-            //check for dups in the input
-            auto fl = std::adjacent_find(opv.begin(), opv.end(), [&](const BSQTempRootNode& ln, const BSQTempRootNode& rn) {
-                return mflavor.keytype->fpkeycmp(mflavor.keytype, mflavor.treetype->getKeyLocation(ln.root), mflavor.treetype->getKeyLocation(rn.root)) == 0;
-            });
+            bool unique = BSQMapOps::s_sort_temp_root_entries(mflavor, lstart, lsize);
 
             std::string fname("[JSON_PARSE]");
-            BSQ_LANGUAGE_ASSERT(fl != opv.end(), (&fname), -1, "Duplicate keys in map");
+            BSQ_LANGUAGE_ASSERT(unique, (&fname), -1, "Duplicate keys in map");
 
-            std::list<BSQTempRootNode> ltomap(opv.begin(), opv.end());
-            auto lstart = ltomap.begin();
-            void* rres = BSQMapOps::s_temp_root_to_map_rec(mflavor, lstart, this->containerstack.back().second);
+            void* rres = nullptr;
+            if(mflavor.hashleaftype != nullptr)
+            {
+                const BSQTupleInfo* tupinfo = dynamic_cast<const BSQTupleInfo*>(mflavor.tupletype);
+                for(size_t i = 0; i < lsize; ++i)
+                {
+                    rres = BSQMapOps::s_hash_add_ne(mflavor, rres, mflavor.tupletype->indexStorageLocationOffset(lstart[i].root, tupinfo->idxoffsets[0]), mflavor.tupletype->indexStorageLocationOffset(lstart[i].root, tupinfo->idxoffsets[1]), false);
+                }
+            }
+            else
+            {
+                rres = BSQMapOps::s_temp_root_to_map_ne(mflavor, lstart, lsize);
+            }
 
             MAP_STORE_RESULT_REPR(rres, this->containerstack.back().second, value);
         }
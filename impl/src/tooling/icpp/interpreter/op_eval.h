@@ -13,6 +13,7 @@
 #include "runtime/bsqlist.h"
 
 #include "collection_eval.h"
+#include "profiler.h"
 
 class Evaluator;
 typedef void (*DebuggerActionFP)(Evaluator* vv);
@@ -107,25 +108,34 @@ public:
     BSQBool* argmask;
     BSQBool* masksbase;
 
-    const std::vector<InterpOp*>* ops;
-    std::vector<InterpOp*>::const_iterator cpos;
-    std::vector<InterpOp*>::const_iterator epos;
+    //instruction pointer into the op pointer array of the invoke body (each step still loads the op object it points to -- the ops are not a flat encoding)
+    InterpOp* const* cpos;
+    InterpOp* const* epos;
 };
 
 class Evaluator
 {
 public:
     static jmp_buf g_entrybuff;
-    static EvaluatorFrame g_callstack[BSQ_MAX_STACK];
+    static EvaluatorFrame* g_callstack;
+    static int32_t g_callstackcapacity;
+    static int32_t g_maxcallstack;
     static uint8_t* g_constantbuffer;
 
     static std::map<BSQTypeID, const BSQRegex*> g_validators;
     static std::map<std::string, const BSQRegex*> g_regexs;
 
+#ifdef BSQ_THREADED_DISPATCH
+    //one label per tag plus the profile label at BSQ_PROFILE_DISPATCH_SLOT -- when profiling every op is linked there (it counts the op and then jumps to the real label)
+    static const void* g_dispatchtable[(size_t)OpCodeTag::OpCodeTagCount + 1];
+#endif
+
 private:
     EvaluatorFrame* cframe = nullptr;
     int32_t cpos = -1;
 
+    static void growCallStack_slow();
+
 public:
     inline StorageLocationPtr evalConstArgument(Argument arg)
     {
@@ -355,11 +365,15 @@ private:
         Evaluator::g_callstack[this->cpos - 1].dbg_prevreturnbp = std::make_pair(Evaluator::g_callstack[this->cpos - 1].dbg_currentline, BreakPoint{this->cframe->invoke, this->cframe->dbg_currentline, this->call_count});
     }
 
-    inline void pushFrame(StepMode smode, const BreakPoint& callerpos, const BSQInvokeDecl* invk, uint8_t* scalarbase, uint8_t* mixedbase, BSQBool* argmask, BSQBool* masksbase, const std::vector<InterpOp*>* ops)
+    inline void pushFrame(StepMode smode, const BreakPoint& callerpos, const BSQInvokeDecl* invk, uint8_t* scalarbase, uint8_t* mixedbase, BSQBool* argmask, BSQBool* masksbase, InterpOp* const* ops, size_t opcount)
     {
         this->call_count++;
 
         this->cpos++;
+        if(this->cpos == Evaluator::g_callstackcapacity)
+        {
+            Evaluator::growCallStack_slow();
+        }
         auto cf = Evaluator::g_callstack + this->cpos;
 
         cf->dbg_currentline = -1;
@@ -373,17 +387,20 @@ private:
         cf->mixedbase = mixedbase;
         cf->argmask = argmask;
         cf->masksbase = masksbase;
-        cf->ops = ops;
 
-        cf->cpos = cf->ops->cbegin();
-        cf->epos = cf->ops->cend();
+        cf->cpos = ops;
+        cf->epos = ops + opcount;
 
         this->cframe = Evaluator::g_callstack + this->cpos;
     }
 #else
-    inline void pushFrame(const BSQInvokeDecl* invk, uint8_t* scalarbase, uint8_t* mixedbase, BSQBool* argmask, BSQBool* masksbase, const std::vector<InterpOp*>* ops) 
+    inline void pushFrame(const BSQInvokeDecl* invk, uint8_t* scalarbase, uint8_t* mixedbase, BSQBool* argmask, BSQBool* masksbase, InterpOp* const* ops, size_t opcount) 
     {
         this->cpos++;
+        if(this->cpos == Evaluator::g_callstackcapacity)
+        {
+            Evaluator::growCallStack_slow();
+        }
 
         auto cf = Evaluator::g_callstack + cpos;
         cf->invoke = invk;
@@ -391,13 +408,9 @@ private:
         cf->mixedbase = mixedbase;
         cf->argmask = argmask;
         cf->masksbase = masksbase;
-        cf->ops = ops;
 
-        if constexpr(!isbultin) 
-        {
-            cf->cpos = cf->ops->cbegin();
-            cf->epos = cf->ops->cend();
-        }
+        cf->cpos = ops;
+        cf->epos = ops + opcount;
 
         this->cframe = Evaluator::g_callstack + this->cpos;
     }
@@ -443,7 +456,7 @@ private:
     inline InterpOp* advanceCurrentOp()
     {
         this->cframe->cpos++;
-        return *this->cframe->cpos;
+        return (this->cframe->cpos != this->cframe->epos) ? *this->cframe->cpos : nullptr;
     }
 
     inline BSQBool* evalMaskLocation(int32_t gmaskoffset)
@@ -556,6 +569,7 @@ private:
     template <bool isGuarded>
     void evalInvokeFixedFunctionOp(const InvokeFixedFunctionOp* op);
 
+    const BSQInvokeBodyDecl* resolveVirtualInvoke(BSQVirtualInlineCache& icache, const BSQType* etype, BSQVirtualInvokeID invokeId);
     void evalInvokeVirtualFunctionOp(const InvokeVirtualFunctionOp* op);
     void evalInvokeVirtualOperatorOp(const InvokeVirtualOperatorOp* op);
 
@@ -612,8 +626,20 @@ private:
     void evalVarLifetimeStartOp(const VarLifetimeStartOp* op);
     void evalVarLifetimeEndOp(const VarLifetimeEndOp* op);
     void evalVarHomeLocationValueUpdate(const VarHomeLocationValueUpdate* op);
+
+    template <OpCodeTag ttag>
+    InterpOp* evalPrimitiveBinaryCompareJumpCondOp(const PrimitiveBinaryCompareJumpCondOp<ttag>* op);
+
+    InterpOp* evalLoadEntityFieldDirectAssignOp(const LoadEntityFieldDirectAssignOp* op);
+    InterpOp* evalVarLifetimeBlockOp(const VarLifetimeBlockOp* op);
+    InterpOp* evalInvokeSelfTailCallOp(const InvokeSelfTailCallOp* op);
+
     void evaluateOpCode(const InterpOp* op);
 
+#ifdef BSQ_THREADED_DISPATCH
+    void evaluateOpCodeBlocksThreaded(bool linkonly);
+#endif
+
     void evaluateOpCodeBlocks();
     void evaluateBody(StorageLocationPtr resultsl, const BSQType* restype, Argument resarg);
     
@@ -623,17 +649,23 @@ private:
     void invokePrelude(const BSQInvokeBodyDecl* invk, uint8_t* cstack, uint8_t* maskslots, BSQBool* optmask);
     void invokePostlude();
 
-    void evaluatePrimitiveBody(const BSQInvokePrimitiveDecl* invk, const std::vector<StorageLocationPtr>& params, StorageLocationPtr resultsl, const BSQType* restype);
+    void evaluatePrimitiveBody(const BSQInvokePrimitiveDecl* invk, StorageLocationSpan params, StorageLocationPtr resultsl, const BSQType* restype);
 
 public:
+    void linkOpDispatch();
+    static void displayInlineCacheStats(FILE* fp);
+
+    //set the call depth limit (and the gc frame and collection node limits that are derived from it)
+    static void configureStackLimits(int32_t maxcallstack);
+
     void invokeGlobalCons(const BSQInvokeBodyDecl* invk, StorageLocationPtr resultsl, const BSQType* restype, Argument resarg);
 
     static size_t initialMainStackSize(const BSQInvokeBodyDecl* invk);
     void invokeMain(const BSQInvokeBodyDecl* invk, uint8_t* istack, StorageLocationPtr resultsl, const BSQType* restype, Argument resarg);
 
-    void linvoke(const BSQInvokeBodyDecl* call, const std::vector<StorageLocationPtr>& args, StorageLocationPtr resultsl);
-    bool iinvoke(const BSQInvokeBodyDecl* call, const std::vector<StorageLocationPtr>& args, BSQBool* optmask);
-    void cinvoke(const BSQInvokeBodyDecl* call, const std::vector<StorageLocationPtr>& args, BSQBool* optmask, StorageLocationPtr resultsl);
+    void linvoke(const BSQInvokeBodyDecl* call, StorageLocationSpan args, StorageLocationPtr resultsl);
+    bool iinvoke(const BSQInvokeBodyDecl* call, StorageLocationSpan args, BSQBool* optmask);
+    void cinvoke(const BSQInvokeBodyDecl* call, StorageLocationSpan args, BSQBool* optmask, StorageLocationPtr resultsl);
 };
 
 class ICPPParseJSON : public ApiManagerJSON<StorageLocationPtr, Evaluator>
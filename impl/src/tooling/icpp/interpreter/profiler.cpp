@@ -0,0 +1,183 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+#include "profiler.h"
+
+#include <tuple>
+
+//Names for the OpCodeTag values (keep in the same order as the enum)
+static const char* s_opcodenames[] = {
+    "Invalid", "DeadFlowOp", "AbortOp", "AssertOp", "DebugOp", "LoadUnintVariableValueOp", "NoneInitUnionOp",
+    "StoreConstantMaskValueOp", "DirectAssignOp", "BoxOp", "ExtractOp", "LoadConstOp", "TupleHasIndexOp",
+    "RecordHasPropertyOp", "LoadTupleIndexDirectOp", "LoadTupleIndexVirtualOp", "LoadTupleIndexSetGuardDirectOp",
+    "LoadTupleIndexSetGuardVirtualOp", "LoadRecordPropertyDirectOp", "LoadRecordPropertyVirtualOp",
+    "LoadRecordPropertySetGuardDirectOp", "LoadRecordPropertySetGuardVirtualOp", "LoadEntityFieldDirectOp",
+    "LoadEntityFieldVirtualOp", "ProjectTupleOp", "ProjectRecordOp", "ProjectEntityOp", "UpdateTupleOp",
+    "UpdateRecordOp", "UpdateEntityOp", "LoadFromEpehmeralListOp", "MultiLoadFromEpehmeralListOp",
+    "SliceEphemeralListOp", "InvokeFixedFunctionOp", "InvokeVirtualFunctionOp", "InvokeVirtualOperatorOp",
+    "ConstructorTupleOp", "ConstructorTupleFromEphemeralListOp", "ConstructorRecordOp",
+    "ConstructorRecordFromEphemeralListOp", "EphemeralListExtendOp", "ConstructorEphemeralListOp",
+    "ConstructorEntityDirectOp", "PrefixNotOp", "AllTrueOp", "SomeTrueOp", "BinKeyEqFastOp", "BinKeyEqStaticOp",
+    "BinKeyEqVirtualOp", "BinKeyLessFastOp", "BinKeyLessStaticOp", "BinKeyLessVirtualOp", "TypeIsNoneOp",
+    "TypeIsSomeOp", "TypeIsNothingOp", "TypeTagIsOp", "TypeTagSubtypeOfOp", "JumpOp", "JumpCondOp", "JumpNoneOp",
+    "RegisterAssignOp", "ReturnAssignOp", "ReturnAssignOfConsOp", "VarLifetimeStartOp", "VarLifetimeEndOp",
+    "VarHomeLocationValueUpdate", "NegateIntOp", "NegateBigIntOp", "NegateRationalOp", "NegateFloatOp",
+    "NegateDecimalOp", "AddNatOp", "AddIntOp", "AddBigNatOp", "AddBigIntOp", "AddRationalOp", "AddFloatOp",
+    "AddDecimalOp", "SubNatOp", "SubIntOp", "SubBigNatOp", "SubBigIntOp", "SubRationalOp", "SubFloatOp",
+    "SubDecimalOp", "MultNatOp", "MultIntOp", "MultBigNatOp", "MultBigIntOp", "MultRationalOp", "MultFloatOp",
+    "MultDecimalOp", "DivNatOp", "DivIntOp", "DivBigNatOp", "DivBigIntOp", "DivRationalOp", "DivFloatOp",
+    "DivDecimalOp", "EqNatOp", "EqIntOp", "EqBigNatOp", "EqBigIntOp", "EqRationalOp", "EqFloatOp", "EqDecimalOp",
+    "NeqNatOp", "NeqIntOp", "NeqBigNatOp", "NeqBigIntOp", "NeqRationalOp", "NeqFloatOp", "NeqDecimalOp", "LtNatOp",
+    "LtIntOp", "LtBigNatOp", "LtBigIntOp", "LtRationalOp", "LtFloatOp", "LtDecimalOp", "LeNatOp", "LeIntOp",
+    "LeBigNatOp", "LeBigIntOp", "LeRationalOp", "LeFloatOp", "LeDecimalOp", "EqNatJumpCondOp", "EqIntJumpCondOp",
+    "NeqNatJumpCondOp", "NeqIntJumpCondOp", "LtNatJumpCondOp", "LtIntJumpCondOp", "LeNatJumpCondOp", "LeIntJumpCondOp",
+    "LoadEntityFieldDirectAssignOp", "VarLifetimeBlockOp", "InvokeSelfTailCallOp"
+};
+static_assert(sizeof(s_opcodenames) / sizeof(const char*) == (size_t)OpCodeTag::OpCodeTagCount, "OpCodeTag name table is out of sync with the enum");
+
+Profiler* Profiler::g_profiler = nullptr;
+
+Profiler::Profiler() : lastopstats(nullptr), lastoppos(0), lastoptime(0), lastopalloc(0)
+{
+    this->invokestats.resize(BSQInvokeDecl::g_invokes.size(), ProfileInvokeStats{0, 0, 0, 0, 0, 0, {}, {}, {}});
+    for(size_t i = 0; i < BSQInvokeDecl::g_invokes.size(); ++i)
+    {
+        auto invk = BSQInvokeDecl::g_invokes[i];
+        if(invk != nullptr && !invk->isPrimitive())
+        {
+            size_t opcount = static_cast<const BSQInvokeBodyDecl*>(invk)->body.size();
+            this->invokestats[i].opcounts.resize(opcount, 0);
+            this->invokestats[i].optimes.resize(opcount, 0);
+            this->invokestats[i].opallocs.resize(opcount, 0);
+        }
+    }
+
+    //root of the call tree (not an invoke)
+    this->callnodes.push_back(ProfileCallNode{nullptr, 0, {}, 0});
+}
+
+void Profiler::enterInvoke(const BSQInvokeBodyDecl* invk)
+{
+    size_t pnode = this->activations.empty() ? 0 : this->activations.back().callnode;
+
+    size_t cnode = 0;
+    auto citer = this->callnodes[pnode].children.find(invk->ikey);
+    if(citer != this->callnodes[pnode].children.end())
+    {
+        cnode = citer->second;
+    }
+    else
+    {
+        cnode = this->callnodes.size();
+        this->callnodes[pnode].children[invk->ikey] = cnode;
+        this->callnodes.push_back(ProfileCallNode{invk, pnode, {}, 0});
+    }
+
+    this->invokestats[invk->ikey].calls++;
+    this->invokestats[invk->ikey].active++;
+    this->activations.push_back(ProfileActivation{invk, cnode, Profiler::now(), 0, Allocator::GlobalAllocator.totalAllocatedBytes(), 0});
+}
+
+void Profiler::exitInvoke()
+{
+    ProfileActivation act = this->activations.back();
+    this->activations.pop_back();
+
+    uint64_t itime = Profiler::now() - act.starttime;
+    uint64_t ialloc = Allocator::GlobalAllocator.totalAllocatedBytes() - act.startalloc;
+
+    ProfileInvokeStats& stats = this->invokestats[act.invk->ikey];
+    stats.exclusivetime += itime - act.childtime;
+    stats.exclusivealloc += ialloc - act.childalloc;
+
+    stats.active--;
+    if(stats.active == 0)
+    {
+        stats.inclusivetime += itime;
+        stats.inclusivealloc += ialloc;
+    }
+
+    this->callnodes[act.callnode].exclusivetime += itime - act.childtime;
+
+    if(!this->activations.empty())
+    {
+        this->activations.back().childtime += itime;
+        this->activations.back().childalloc += ialloc;
+    }
+}
+
+void Profiler::finish()
+{
+    this->chargeLastOp(Profiler::now(), Allocator::GlobalAllocator.totalAllocatedBytes());
+    this->lastopstats = nullptr;
+
+    while(!this->activations.empty())
+    {
+        this->exitInvoke();
+    }
+}
+
+std::string Profiler::collapsedStackFor(size_t node) const
+{
+    std::string frame = this->callnodes[node].invk->name;
+    std::replace_if(frame.begin(), frame.end(), [](char c) { return c == ';' || c == ' '; }, '_');
+
+    size_t pnode = this->callnodes[node].parent;
+    return (pnode == 0) ? frame : (this->collapsedStackFor(pnode) + ";" + frame);
+}
+
+void Profiler::writeCollapsedStacks(FILE* fp) const
+{
+    for(size_t i = 1; i < this->callnodes.size(); ++i)
+    {
+        if(this->callnodes[i].exclusivetime != 0)
+        {
+            fprintf(fp, "%s %llu\n", this->collapsedStackFor(i).c_str(), (unsigned long long)this->callnodes[i].exclusivetime);
+        }
+    }
+    fflush(fp);
+}
+
+void Profiler::displayInvokeStats(FILE* fp) const
+{
+    for(size_t i = 0; i < this->invokestats.size(); ++i)
+    {
+        const ProfileInvokeStats& stats = this->invokestats[i];
+        if(stats.calls == 0)
+        {
+            continue;
+        }
+
+        auto idecl = static_cast<const BSQInvokeBodyDecl*>(BSQInvokeDecl::g_invokes[i]);
+        fprintf(fp, "%s -- calls: %llu inclusive: %lluus exclusive: %lluus alloc inclusive: %lluB exclusive: %lluB\n", idecl->name.c_str(), (unsigned long long)stats.calls, (unsigned long long)(stats.inclusivetime / 1000), (unsigned long long)(stats.exclusivetime / 1000), (unsigned long long)stats.inclusivealloc, (unsigned long long)stats.exclusivealloc);
+
+        //count, time and alloc for each line
+        std::map<OpCodeTag, uint64_t> tagcounts;
+        std::map<uint32_t, std::tuple<uint64_t, uint64_t, uint64_t>> linestats;
+        for(size_t j = 0; j < stats.opcounts.size(); ++j)
+        {
+            if(stats.opcounts[j] != 0)
+            {
+                tagcounts[idecl->body[j]->tag] += stats.opcounts[j];
+
+                auto& lstats = linestats[idecl->body[j]->sinfo.line];
+                std::get<0>(lstats) += stats.opcounts[j];
+                std::get<1>(lstats) += stats.optimes[j];
+                std::get<2>(lstats) += stats.opallocs[j];
+            }
+        }
+
+        for(auto titer = tagcounts.cbegin(); titer != tagcounts.cend(); ++titer)
+        {
+            fprintf(fp, "    op %s: %llu\n", s_opcodenames[(size_t)titer->first], (unsigned long long)titer->second);
+        }
+
+        for(auto liter = linestats.cbegin(); liter != linestats.cend(); ++liter)
+        {
+            fprintf(fp, "    line %i: %llu ops %lluus %lluB\n", (int)liter->first, (unsigned long long)std::get<0>(liter->second), (unsigned long long)(std::get<1>(liter->second) / 1000), (unsigned long long)std::get<2>(liter->second));
+        }
+    }
+    fflush(fp);
+}
@@ -0,0 +1,118 @@
+//-------------------------------------------------------------------------------------------------------
+// Copyright (C) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+//-------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "common.h"
+#include "runtime/bsqop.h"
+#include "runtime/bsqinvoke.h"
+#include "runtime/bsqmemory.h"
+
+#include <chrono>
+
+//Counts for a single invoke body (times are in ns and alloc is in bytes of nursery allocation)
+struct ProfileInvokeStats
+{
+    uint64_t calls;
+    uint64_t inclusivetime;
+    uint64_t exclusivetime;
+    uint64_t inclusivealloc;
+    uint64_t exclusivealloc;
+
+    //number of open activations (so recursive calls are only counted once in the inclusive totals)
+    uint32_t active;
+
+    //executed count, time (ns) and nursery allocation (bytes) for each op in the body (by position) -- the per tag and per line numbers are computed from these when reporting
+    //an op is charged from when it is dispatched until the next op is (so a call op only gets the call setup and the callee ops get the rest)
+    std::vector<uint64_t> opcounts;
+    std::vector<uint64_t> optimes;
+    std::vector<uint64_t> opallocs;
+};
+
+//A node in the dynamic call tree -- used to emit the collapsed stacks
+struct ProfileCallNode
+{
+    const BSQInvokeBodyDecl* invk;
+    size_t parent;
+    std::map<BSQInvokeID, size_t> children;
+    uint64_t exclusivetime;
+};
+
+struct ProfileActivation
+{
+    const BSQInvokeBodyDecl* invk;
+    size_t callnode;
+
+    uint64_t starttime;
+    uint64_t childtime;
+    size_t startalloc;
+    size_t childalloc;
+};
+
+//Counting profiler for the evaluator -- g_profiler is null unless profiling was requested (ICPP_PROFILE or --profile) so the evaluator hooks are a single null check per call
+class Profiler
+{
+private:
+    std::vector<ProfileInvokeStats> invokestats;
+    std::vector<ProfileCallNode> callnodes;
+    std::vector<ProfileActivation> activations;
+
+    //the last op that was dispatched and the clock/allocation when it was
+    ProfileInvokeStats* lastopstats;
+    size_t lastoppos;
+    uint64_t lastoptime;
+    size_t lastopalloc;
+
+    void chargeLastOp(uint64_t optime, size_t opalloc)
+    {
+        if(this->lastopstats != nullptr)
+        {
+            this->lastopstats->optimes[this->lastoppos] += optime - this->lastoptime;
+            this->lastopstats->opallocs[this->lastoppos] += opalloc - this->lastopalloc;
+        }
+    }
+
+    static inline uint64_t now()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::string collapsedStackFor(size_t node) const;
+
+public:
+    static Profiler* g_profiler;
+
+    Profiler();
+
+    void enterInvoke(const BSQInvokeBodyDecl* invk);
+    void exitInvoke();
+
+    inline void countTailCall(const BSQInvokeBodyDecl* invk)
+    {
+        this->invokestats[invk->ikey].calls++;
+    }
+
+    inline void countOp(const BSQInvokeBodyDecl* invk, InterpOp* const* cpos)
+    {
+        uint64_t optime = Profiler::now();
+        size_t opalloc = Allocator::GlobalAllocator.totalAllocatedBytes();
+        this->chargeLastOp(optime, opalloc);
+
+        ProfileInvokeStats& stats = this->invokestats[invk->ikey];
+        size_t oppos = (size_t)(cpos - invk->body.data());
+        stats.opcounts[oppos]++;
+
+        this->lastopstats = &stats;
+        this->lastoppos = oppos;
+        this->lastoptime = optime;
+        this->lastopalloc = opalloc;
+    }
+
+    //close any activations left open by an abort so the totals are consistent
+    void finish();
+
+    void writeCollapsedStacks(FILE* fp) const;
+    void displayInvokeStats(FILE* fp) const;
+};
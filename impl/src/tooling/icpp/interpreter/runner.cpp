@@ -5,8 +5,11 @@
 
 #include "op_eval.h"
 #include "asm_load.h"
+#include "asm_opt.h"
 
 #include <chrono>
+#include <cerrno>
+#include <cctype>
 #include <iostream>
 #include <fstream>
 
@@ -165,48 +168,360 @@ std::pair<bool, json> run(Evaluator& runner, const APIModule* api, const std::st
     }
 }
 
-void parseArgs(int argc, char** argv, std::string& mode, bool& debugger, std::string& prog, std::string& input)
+//a positive count with an optional K, M or G (power of 2) suffix -- 0 if it does not parse, is 0 or overflows
+size_t parseSizeArg(const char* str)
+{
+    if(!std::isdigit((unsigned char)str[0]))
+    {
+        return 0;
+    }
+
+    errno = 0;
+    char* end = nullptr;
+    unsigned long long val = std::strtoull(str, &end, 10);
+    if(errno == ERANGE || val == 0)
+    {
+        return 0;
+    }
+
+    unsigned long long scale = 1;
+    if(*end == 'K' || *end == 'k')
+    {
+        scale = 1024;
+        end++;
+    }
+    else if(*end == 'M' || *end == 'm')
+    {
+        scale = 1024 * 1024;
+        end++;
+    }
+    else if(*end == 'G' || *end == 'g')
+    {
+        scale = 1024 * 1024 * 1024;
+        end++;
+    }
+    else
+    {
+        ;
+    }
+
+    if(*end != '\0' || val > (unsigned long long)SIZE_MAX / scale)
+    {
+        return 0;
+    }
+
+    return (size_t)(val * scale);
+}
+
+//a positive pause target in microseconds converted to nanoseconds -- 0 if it does not parse, is 0 or overflows
+uint64_t parsePauseArg(const char* str)
+{
+    if(!std::isdigit((unsigned char)str[0]))
+    {
+        return 0;
+    }
+
+    errno = 0;
+    char* end = nullptr;
+    unsigned long long val = std::strtoull(str, &end, 10);
+    if(errno == ERANGE || val == 0 || *end != '\0' || val > UINT64_MAX / 1000)
+    {
+        return 0;
+    }
+
+    return (uint64_t)val * 1000;
+}
+
+//a positive thread count -- 0 if it does not parse, is 0 or overflows (counts above BSQ_GC_MAX_THREADS are clamped when the evacuator is configured)
+uint32_t parseThreadCountArg(const char* str)
+{
+    if(!std::isdigit((unsigned char)str[0]))
+    {
+        return 0;
+    }
+
+    errno = 0;
+    char* end = nullptr;
+    unsigned long long val = std::strtoull(str, &end, 10);
+    if(errno == ERANGE || val == 0 || *end != '\0' || val > UINT32_MAX)
+    {
+        return 0;
+    }
+
+    return (uint32_t)val;
+}
+
+//exit with a message if a command line size/pause/thread flag did not parse
+template <typename T>
+T checkFlagArg(const std::string& sarg, T val)
+{
+    if(val == 0)
+    {
+        fprintf(stderr, "Invalid value in %s (expected a positive number that does not overflow)\n", sarg.c_str());
+        fflush(stderr);
+        exit(1);
+    }
+    return val;
+}
+
+//the nursery knobs from the environment -- the command line flags override these
+GCNurseryPolicy loadNurseryPolicyFromEnv()
+{
+    GCNurseryPolicy policy = Allocator::GlobalAllocator.getNurseryPolicy();
+
+    const char* minenv = std::getenv("ICPP_GC_NURSERY_MIN");
+    if(minenv != nullptr && parseSizeArg(minenv) != 0)
+    {
+        policy.minsize = parseSizeArg(minenv);
+    }
+
+    const char* maxenv = std::getenv("ICPP_GC_NURSERY_MAX");
+    if(maxenv != nullptr && parseSizeArg(maxenv) != 0)
+    {
+        policy.maxsize = parseSizeArg(maxenv);
+    }
+
+    const char* pauseenv = std::getenv("ICPP_GC_TARGET_PAUSE_US");
+    if(pauseenv != nullptr && parsePauseArg(pauseenv) != 0)
+    {
+        policy.targetpausens = parsePauseArg(pauseenv);
+    }
+
+    return policy;
+}
+
+void parseArgs(int argc, char** argv, std::string& mode, bool& debugger, bool& profile, uint32_t& gcthreads, bool& gcbgrelease, bool& gcnopretenure, GCNurseryPolicy& nursery, std::string& heapimage, std::string& prog, std::string& input)
 {
     bool isstream = false;
     debugger = false;
-    for(int i = 0; i < argc; ++i)
+    profile = false;
+    gcthreads = 1;
+    gcbgrelease = false;
+    gcnopretenure = false;
+
+    std::vector<std::string> positional;
+    for(int i = 1; i < argc; ++i)
     {
         std::string sarg(argv[i]);
 
         isstream |= (sarg == "--stream");
         debugger |= (sarg == "--debug");
+        profile |= (sarg == "--profile");
+        gcbgrelease |= (sarg == "--gc-background-release");
+        gcnopretenure |= (sarg == "--gc-no-pretenure");
+
+        if(sarg.starts_with("--gc-threads="))
+        {
+            gcthreads = checkFlagArg(sarg, parseThreadCountArg(sarg.c_str() + 13));
+        }
+        else if(sarg.starts_with("--gc-nursery-min="))
+        {
+            nursery.minsize = checkFlagArg(sarg, parseSizeArg(sarg.c_str() + 17));
+        }
+        else if(sarg.starts_with("--gc-nursery-max="))
+        {
+            nursery.maxsize = checkFlagArg(sarg, parseSizeArg(sarg.c_str() + 17));
+        }
+        else if(sarg.starts_with("--gc-target-pause-us="))
+        {
+            nursery.targetpausens = checkFlagArg(sarg, parsePauseArg(sarg.c_str() + 21));
+        }
+        else if(sarg.starts_with("--heap-image="))
+        {
+            heapimage = sarg.substr(13);
+        }
+        else if(sarg != "--stream" && sarg != "--debug" && sarg != "--profile" && sarg != "--gc-background-release" && sarg != "--gc-no-pretenure")
+        {
+            positional.push_back(sarg);
+        }
     }
 
     if(isstream)
     {
         mode = "stream";
     }
-    else if(argc == 3 || (argc == 4 && debugger))
+    else if(positional.size() == 2)
     {
         mode = "run";
-        prog = std::string(debugger ? argv[2] : argv[1]);
-        input = std::string(debugger ? argv[3] : argv[2]);
+        prog = positional[0];
+        input = positional[1];
     }
     else
     {
-        fprintf(stderr, "Usage: icpp [--debug] bytecode.bsqir args[]\n");
-        fprintf(stderr, "Usage: icpp [--debug] --stream\n");
+        fprintf(stderr, "Usage: icpp [--debug] [--profile] [--gc-threads=N] [--gc-background-release] [--gc-no-pretenure] [--gc-nursery-min=SIZE] [--gc-nursery-max=SIZE] [--gc-target-pause-us=N] [--heap-image=FILE] bytecode.bsqir args[]\n");
+        fprintf(stderr, "Usage: icpp [--debug] [--profile] [--gc-threads=N] [--gc-background-release] [--gc-no-pretenure] [--gc-nursery-min=SIZE] [--gc-nursery-max=SIZE] [--gc-target-pause-us=N] [--heap-image=FILE] --stream\n");
         fflush(stderr);
         exit(1);
     }
 }
 
+json gcCycleToJSON(const GCCycleTelemetry& cycle)
+{
+    return {
+        {"rootsns", cycle.rootsns}, {"heapns", cycle.heapns}, {"releasens", cycle.releasens}, {"pausens", cycle.totalns},
+        {"promotedbytes", cycle.promotedbytes}, {"releasedbytes", cycle.releasedbytes},
+        {"nurserybytes", cycle.nurserybytes}, {"nurseryusedbytes", cycle.nurseryusedbytes}, {"liveoldbytes", cycle.liveoldbytes},
+        {"maybezerocount", cycle.maybezerocount}, {"releasebacklog", cycle.releasebacklog}
+    };
+}
+
+//totals and maximums over all the collections -- included with the result when ICPP_OUTPUT_MODE is not simple
+json gcTelemetrySummary()
+{
+    const std::vector<GCCycleTelemetry>& cycles = Allocator::GlobalAllocator.getGCTelemetry();
+
+    GCCycleTelemetry total = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    GCCycleTelemetry max = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    for(size_t i = 0; i < cycles.size(); ++i)
+    {
+        const GCCycleTelemetry& cc = cycles[i];
+
+        total.rootsns += cc.rootsns;
+        total.heapns += cc.heapns;
+        total.releasens += cc.releasens;
+        total.totalns += cc.totalns;
+        total.promotedbytes += cc.promotedbytes;
+        total.releasedbytes += cc.releasedbytes;
+
+        max.totalns = std::max(max.totalns, cc.totalns);
+        max.nurserybytes = std::max(max.nurserybytes, cc.nurserybytes);
+        max.liveoldbytes = std::max(max.liveoldbytes, cc.liveoldbytes);
+        max.maybezerocount = std::max(max.maybezerocount, cc.maybezerocount);
+        max.releasebacklog = std::max(max.releasebacklog, cc.releasebacklog);
+    }
+
+    return {
+        {"collections", cycles.size()},
+        {"pausens", {{"total", total.totalns}, {"max", max.totalns}, {"roots", total.rootsns}, {"heap", total.heapns}, {"release", total.releasens}}},
+        {"promotedbytes", total.promotedbytes},
+        {"releasedbytes", total.releasedbytes},
+        {"nurserybytes", cycles.empty() ? (size_t)0 : cycles.back().nurserybytes},
+        {"maxnurserybytes", max.nurserybytes},
+        {"maxliveoldbytes", max.liveoldbytes},
+        {"maxmaybezerocount", max.maybezerocount},
+        {"maxreleasebacklog", max.releasebacklog}
+    };
+}
+
+//one JSON object per line for each collection (ICPP_GC_TELEMETRY=file)
+void writeGCTelemetryLines(const std::string& telemetryfile)
+{
+    FILE* fp = fopen(telemetryfile.c_str(), "w");
+    if(fp == nullptr)
+    {
+        fprintf(stderr, "Could not open GC telemetry file %s\n", telemetryfile.c_str());
+        return;
+    }
+
+    const std::vector<GCCycleTelemetry>& cycles = Allocator::GlobalAllocator.getGCTelemetry();
+    for(size_t i = 0; i < cycles.size(); ++i)
+    {
+        fprintf(fp, "%s\n", gcCycleToJSON(cycles[i]).dump().c_str());
+    }
+    fclose(fp);
+}
+
+void startProfiling(Evaluator& runner)
+{
+#ifdef BSQ_PROFILE
+    Profiler::g_profiler = new Profiler();
+
+    //relink so every op goes through the profile counting label
+    runner.linkOpDispatch();
+#endif
+}
+
+void finishProfiling(const std::string& profilefile)
+{
+    Profiler::g_profiler->finish();
+
+    FILE* fp = fopen(profilefile.c_str(), "w");
+    if(fp == nullptr)
+    {
+        fprintf(stderr, "Could not open profile file %s\n", profilefile.c_str());
+    }
+    else
+    {
+        Profiler::g_profiler->writeCollapsedStacks(fp);
+        fclose(fp);
+    }
+
+    Profiler::g_profiler->displayInvokeStats(stderr);
+}
+
 int main(int argc, char** argv)
 {
     std::string mode;
     bool debugger = false;
     std::string prog;
     std::string input;
-    parseArgs(argc, argv, mode, debugger, prog, input);
+    bool profile = false;
+    uint32_t gcthreads;
+    bool gcbgrelease;
+    bool gcnopretenure;
+    GCNurseryPolicy nursery = loadNurseryPolicyFromEnv();
+
+    //load the initialized constants from (or save them to) a heap image instead of running the global initializers on every start (--heap-image=FILE or ICPP_HEAP_IMAGE)
+    const char* heapimageenv = std::getenv("ICPP_HEAP_IMAGE");
+    std::string heapimage = (heapimageenv != nullptr) ? std::string(heapimageenv) : std::string("");
+
+    parseArgs(argc, argv, mode, debugger, profile, gcthreads, gcbgrelease, gcnopretenure, nursery, heapimage, prog, input);
 
     const char* outputenv = std::getenv("ICPP_OUTPUT_MODE");
     std::string outmode(outputenv != nullptr ? outputenv : "simple");
 
+    //print the per invoke counts of the load time rewrites to stderr
+    bool loadstats = std::getenv("ICPP_LOAD_STATS") != nullptr;
+
+    //print the per call site virtual inline cache counts to stderr after the run
+    bool icstats = std::getenv("ICPP_IC_STATS") != nullptr;
+
+    //limit on the call depth -- deep recursion aborts cleanly when it is hit (the native stack may also need to be raised with ulimit)
+    const char* maxstackenv = std::getenv("ICPP_MAX_STACK");
+    if(maxstackenv != nullptr && std::atoi(maxstackenv) > 0)
+    {
+        Evaluator::configureStackLimits(std::atoi(maxstackenv));
+    }
+
+    //evacuate the nursery with N threads (--gc-threads=N)
+    if(gcthreads > 1)
+    {
+        GCParallelEvacuator::configure(gcthreads);
+    }
+
+    //free dead old space objects on a background thread instead of in the collection pause (--gc-background-release)
+    if(gcbgrelease)
+    {
+        GCBackgroundReleaser::configure();
+    }
+
+    //keep every allocation in the nursery instead of pretenuring the types that nearly always survive (--gc-no-pretenure)
+    Allocator::g_pretenure = !gcnopretenure;
+
+    //bounds on the nursery size and the pause it is sized to fit in (--gc-nursery-min=SIZE --gc-nursery-max=SIZE --gc-target-pause-us=N with 0 for no target)
+    Allocator::GlobalAllocator.configureNursery(nursery);
+
+    //print the collection count, pause times, where the release work was done and the per type survival to stderr after the run
+    bool gcstats = std::getenv("ICPP_GC_STATS") != nullptr;
+
+    //write the per collection phase times, promoted/released bytes, nursery size and list lengths as JSON lines to ICPP_GC_TELEMETRY
+    const char* telemetryenv = std::getenv("ICPP_GC_TELEMETRY");
+    std::string telemetryfile = (telemetryenv != nullptr) ? std::string(telemetryenv) : std::string("");
+
+    //the per collection entries are only recorded when something reports them
+    Allocator::g_telemetry = !telemetryfile.empty() || outmode != "simple";
+
+    //write collapsed stacks (flamegraph.pl input) to ICPP_PROFILE (or icpp_profile.folded with --profile) and the per invoke op/line/time/alloc counts to stderr
+    const char* profileenv = std::getenv("ICPP_PROFILE");
+    std::string profilefile = (profileenv != nullptr && profileenv[0] != '\0') ? std::string(profileenv) : std::string(profile ? "icpp_profile.folded" : "");
+#ifndef BSQ_PROFILE
+    if(!profilefile.empty())
+    {
+        fprintf(stderr, "icpp was built without BSQ_PROFILE -- ignoring --profile/ICPP_PROFILE\n");
+        profilefile = std::string("");
+    }
+#endif
+
     if(mode == "stream")
     {
         auto payload = getIRFromStdIn();
@@ -235,14 +550,47 @@ int main(int argc, char** argv)
         runner.debuggerattached = debugger;
 #endif 
 
-        loadAssembly(jcode["bytecode"], runner);
+        loadAssembly(jcode["bytecode"], runner, heapimage);
+        if(loadstats)
+        {
+            displayRewriteStats(stderr);
+        }
+
+        if(!profilefile.empty())
+        {
+            startProfiling(runner);
+        }
 
         auto start = std::chrono::system_clock::now();
         auto res = run(runner, api, jmain, jargs);
         auto end = std::chrono::system_clock::now();
 
+        //no more collections -- let the release thread finish so the stats are final (configure also registers this with atexit for the exit paths)
+        GCBackgroundReleaser::shutdown();
+
+        if(icstats)
+        {
+            Evaluator::displayInlineCacheStats(stderr);
+        }
+
+        if(gcstats)
+        {
+            Allocator::GlobalAllocator.displayGCStats(stderr);
+        }
+
+        if(!profilefile.empty())
+        {
+            finishProfiling(profilefile);
+        }
+
+        if(!telemetryfile.empty())
+        {
+            writeGCTelemetryLines(telemetryfile);
+        }
+
         int delta_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
         auto jout = res.second.dump(4);
+        auto jgc = outmode != "simple" ? gcTelemetrySummary().dump() : std::string("");
         if(res.first)
         {
             if(outmode == "simple")
@@ -251,7 +599,7 @@ int main(int argc, char** argv)
             }
             else
             {
-                printf("{\"status\": \"success\", \"time\": %i, \"value\": %s}\n", delta_ms, jout.c_str());
+                printf("{\"status\": \"success\", \"time\": %i, \"gc\": %s, \"value\": %s}\n", delta_ms, jgc.c_str(), jout.c_str());
             }
             fflush(stdout);
             return 0;
@@ -264,7 +612,7 @@ int main(int argc, char** argv)
             }
             else
             {
-                printf("{\"status\": \"failure\", \"time\": %i, \"msg\": %s}\n", delta_ms, jout.c_str());
+                printf("{\"status\": \"failure\", \"time\": %i, \"gc\": %s, \"msg\": %s}\n", delta_ms, jgc.c_str(), jout.c_str());
             }
             fflush(stdout);
 
@@ -300,7 +648,16 @@ int main(int argc, char** argv)
         const APIModule* api = APIModule::jparse(jcode["api"]);
 
         Evaluator runner;
-        loadAssembly(jcode["bytecode"], runner);
+        loadAssembly(jcode["bytecode"], runner, heapimage);
+        if(loadstats)
+        {
+            displayRewriteStats(stderr);
+        }
+
+        if(!profilefile.empty())
+        {
+            startProfiling(runner);
+        }
 
 #ifdef BSQ_DEBUG_BUILD
         runner.debuggerattached = debugger;
@@ -310,8 +667,32 @@ int main(int argc, char** argv)
         auto res = run(runner, api, jmain, jargs);
         auto end = std::chrono::system_clock::now();
 
+        //no more collections -- let the release thread finish so the stats are final (configure also registers this with atexit for the exit paths)
+        GCBackgroundReleaser::shutdown();
+
+        if(icstats)
+        {
+            Evaluator::displayInlineCacheStats(stderr);
+        }
+
+        if(gcstats)
+        {
+            Allocator::GlobalAllocator.displayGCStats(stderr);
+        }
+
+        if(!profilefile.empty())
+        {
+            finishProfiling(profilefile);
+        }
+
+        if(!telemetryfile.empty())
+        {
+            writeGCTelemetryLines(telemetryfile);
+        }
+
         int delta_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
         auto jout = res.second.dump(4);
+        auto jgc = outmode != "simple" ? gcTelemetrySummary().dump() : std::string("");
         if(res.first)
         {
             if(outmode == "simple")
@@ -321,7 +702,7 @@ int main(int argc, char** argv)
             }
             else
             {
-                printf("{\"status\": \"success\", \"time\": %i \"value\": %s}\n", (int)delta_ms, jout.c_str());
+                printf("{\"status\": \"success\", \"time\": %i, \"gc\": %s, \"value\": %s}\n", (int)delta_ms, jgc.c_str(), jout.c_str());
             }
             fflush(stdout);
             return 0;
@@ -334,7 +715,7 @@ int main(int argc, char** argv)
             }
             else
             {
-                printf("{\"status\": \"failure\", \"msg\": %s}\n", jout.c_str());
+                printf("{\"status\": \"failure\", \"gc\": %s, \"msg\": %s}\n", jgc.c_str(), jout.c_str());
             }
             fflush(stdout);
             return 1;
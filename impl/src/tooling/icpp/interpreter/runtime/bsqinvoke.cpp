@@ -585,11 +585,36 @@ BSQInvokeBodyDecl* BSQInvokeBodyDecl::jsonLoad(json v)
 
     std::vector<InterpOp*> body;
     auto jbody = v["body"];
+
+    //most ops are well under 128 bytes so this usually puts the whole body in one block
+    InterpOpArena* oparena = new InterpOpArena(std::max((size_t)512, jbody.size() * 128));
+    InterpOpArena::g_currentarena = oparena;
     std::transform(jbody.cbegin(), jbody.cend(), std::back_inserter(body), [](json jop) {
         return InterpOp::jparse(jop);
     });
+    InterpOpArena::g_currentarena = nullptr;
+
+    auto idecl = new BSQInvokeBodyDecl(j_name(v), ikey, srcfile, j_sinfoStart(v), j_sinfoEnd(v), recursive, params, rtype, paraminfo, resultArg, v["scalarStackBytes"].get<size_t>(), v["mixedStackBytes"].get<size_t>(), mask, v["maskSlots"].get<uint32_t>(), body, v["argmaskSize"].get<uint32_t>(), v["isUserCode"].get<bool>(), oparena);
+
+    //guard flags held in local scalar vars (parameters are always written by the caller)
+    std::for_each(jbody.cbegin(), jbody.cend(), [idecl](json jop) {
+        if(!jop.contains("sguard") || !jop["sguard"]["enabled"].get<bool>() || jop["sguard"]["guard"]["gindex"].get<int32_t>() != -1)
+        {
+            return;
+        }
+
+        auto gvaroffset = jop["sguard"]["guard"]["gvaroffset"].get<int32_t>();
+        bool isparam = std::any_of(idecl->paraminfo.cbegin(), idecl->paraminfo.cend(), [gvaroffset](const ParameterInfo& pinfo) {
+            return pinfo.kind == ArgumentTag::ScalarVal && pinfo.poffset == (uint32_t)gvaroffset;
+        });
+
+        if(gvaroffset >= 0 && !isparam && std::find(idecl->guardvars.cbegin(), idecl->guardvars.cend(), (uint32_t)gvaroffset) == idecl->guardvars.cend())
+        {
+            idecl->guardvars.push_back((uint32_t)gvaroffset);
+        }
+    });
 
-    return new BSQInvokeBodyDecl(j_name(v), ikey, srcfile, j_sinfoStart(v), j_sinfoEnd(v), recursive, params, rtype, paraminfo, resultArg, v["scalarStackBytes"].get<size_t>(), v["mixedStackBytes"].get<size_t>(), mask, v["maskSlots"].get<uint32_t>(), body, v["argmaskSize"].get<uint32_t>(), v["isUserCode"].get<bool>());
+    return idecl;
 }
 
 BSQInvokePrimitiveDecl* BSQInvokePrimitiveDecl::jsonLoad(json v)
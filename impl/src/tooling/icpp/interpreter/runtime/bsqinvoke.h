@@ -53,30 +53,71 @@ public:
     static void jsonLoad(json v);
 };
 
+//Counts of the load time rewrites (asm_opt.cpp) applied to an invoke body
+struct BSQInvokeRewriteStats
+{
+    uint32_t foldedops;
+    uint32_t deadbranches;
+    uint32_t specializedops;
+    uint32_t fusedops;
+    uint32_t tailcalls;
+};
+
+//Offset (from the start of the frame) and size of a parameter slot -- storeValue is a plain copy of assigndatasize for every layout so args can be copied directly
+struct ParameterCopyInfo
+{
+    uint32_t foffset;
+    uint32_t bytes;
+};
+
 class BSQInvokeBodyDecl : public BSQInvokeDecl 
 {
 public:
-    const std::vector<InterpOp*> body;
+    std::vector<InterpOp*> body;
     const uint32_t argmaskSize;
 
     const std::vector<ParameterInfo> paraminfo;
+    std::vector<ParameterCopyInfo> paramcopy;
     const Argument resultArg;
 
+    //scalar (non parameter) slots read as statement guard flags -- scalar slots are not cleared on entry so these are zeroed explicitly
+    std::vector<uint32_t> guardvars;
+
     const size_t scalarstackBytes;
     const size_t mixedstackBytes;
     RefMask mixedMask;
 
     const uint32_t maskSlots;
 
-    BSQInvokeBodyDecl(std::string name, BSQInvokeID ikey, std::string srcFile, SourceInfo sinfoStart, SourceInfo sinfoEnd, bool recursive, std::vector<BSQFunctionParameter> params, const BSQType* resultType, std::vector<ParameterInfo> paraminfo, Argument resultArg, size_t scalarstackBytes, size_t mixedstackBytes, RefMask mixedMask, uint32_t maskSlots, std::vector<InterpOp*> body, uint32_t argmaskSize, bool isusercode)
-    : BSQInvokeDecl(name, ikey, srcFile, sinfoStart, sinfoEnd, recursive, params, resultType, isusercode), body(body), argmaskSize(argmaskSize), paraminfo(paraminfo), resultArg(resultArg), scalarstackBytes(scalarstackBytes), mixedstackBytes(mixedstackBytes), mixedMask(mixedMask), maskSlots(maskSlots)
-    {;}
+    BSQInvokeRewriteStats rwstats;
+
+    //storage for the ops in body
+    InterpOpArena* oparena;
+
+    //ops the load time rewrites took out of body that a fused/tail call op still refers to -- destructed along with body
+    std::vector<InterpOp*> replacedops;
+
+    BSQInvokeBodyDecl(std::string name, BSQInvokeID ikey, std::string srcFile, SourceInfo sinfoStart, SourceInfo sinfoEnd, bool recursive, std::vector<BSQFunctionParameter> params, const BSQType* resultType, std::vector<ParameterInfo> paraminfo, Argument resultArg, size_t scalarstackBytes, size_t mixedstackBytes, RefMask mixedMask, uint32_t maskSlots, std::vector<InterpOp*> body, uint32_t argmaskSize, bool isusercode, InterpOpArena* oparena)
+    : BSQInvokeDecl(name, ikey, srcFile, sinfoStart, sinfoEnd, recursive, params, resultType, isusercode), body(body), argmaskSize(argmaskSize), paraminfo(paraminfo), resultArg(resultArg), scalarstackBytes(scalarstackBytes), mixedstackBytes(mixedstackBytes), mixedMask(mixedMask), maskSlots(maskSlots), rwstats({0, 0, 0, 0, 0}), oparena(oparena), replacedops()
+    {
+        for(size_t i = 0; i < this->paraminfo.size(); ++i)
+        {
+            uint32_t foffset = this->paraminfo[i].poffset + (this->paraminfo[i].kind == ArgumentTag::ScalarVal ? 0 : (uint32_t)this->scalarstackBytes);
+            this->paramcopy.push_back({foffset, (uint32_t)this->params[i].ptype->allocinfo.assigndatasize});
+        }
+    }
 
     virtual ~BSQInvokeBodyDecl()
     {
         std::for_each(this->body.begin(), this->body.end(), [](InterpOp* op) {
             delete(op);
         });
+
+        std::for_each(this->replacedops.begin(), this->replacedops.end(), [](InterpOp* op) {
+            delete(op);
+        });
+
+        delete this->oparena;
     }
 
     virtual bool isPrimitive() const override
@@ -138,5 +179,5 @@ public:
     LambdaEvalThunk(void* ctx): ctx(ctx) {;}
     ~LambdaEvalThunk() {;}
 
-    void invoke(const BSQInvokeBodyDecl* call, const std::vector<StorageLocationPtr>& args, StorageLocationPtr resultsl);
+    void invoke(const BSQInvokeBodyDecl* call, StorageLocationSpan args, StorageLocationPtr resultsl);
 };
@@ -71,7 +71,7 @@ public:
         return ((uint8_t*)repr) + sizeof(uint64_t) + (i * this->entrysize);
     }
 
-    inline static void initializePVData(void* pvinto, const std::vector<StorageLocationPtr>& vals, const BSQType* entrytype)
+    inline static void initializePVData(void* pvinto, StorageLocationSpan vals, const BSQType* entrytype)
     {
         auto intoloc = ((uint8_t*)pvinto) + sizeof(uint64_t);
 
@@ -138,7 +138,7 @@ public:
     inline static void slicePVData(void* pvinto, void* pvfrom, int16_t start, int16_t end, uint64_t entrysize)
     {
         auto intoloc = ((uint8_t*)pvinto) + sizeof(uint64_t);
-        auto fromloc = ((uint8_t*)pvfrom) + (sizeof(uint64_t) + (*((uint64_t*)pvinto) * start));
+        auto fromloc = ((uint8_t*)pvfrom) + (sizeof(uint64_t) + (start * entrysize));
         auto bytecount = ((end - start) * entrysize);
 
         GC_MEM_COPY(intoloc, fromloc, bytecount);
@@ -188,7 +188,7 @@ public:
         auto fromloc = ((uint8_t*)pvfrom) + sizeof(uint64_t);
         
         uint64_t jj = 0;
-        for(size_t i = 0; i < 8; ++i)
+        for(size_t i = 0; i < end; ++i)
         {
             if(i != idx)
             {
@@ -204,6 +204,10 @@ public:
     }
 };
 
+//Trees are weight balanced (as the map trees with delta = 3 and gamma = 2) on the element counts -- leaves are never split so only tree nodes are rotated
+#define BSQ_LIST_TREE_DELTA 3
+#define BSQ_LIST_TREE_GAMMA 2
+
 struct BSQListTreeRepr
 {
     void* l;
@@ -226,6 +230,27 @@ public:
     {
         return ((BSQListTreeRepr*)repr)->size;
     }
+
+    inline static bool isTree(void* repr)
+    {
+        return GET_TYPE_META_DATA_AS(BSQListReprType, repr)->lkind == ListReprKind::TreeElement;
+    }
+
+    inline static uint64_t getSize(void* repr)
+    {
+        return BSQListTreeType::isTree(repr) ? ((BSQListTreeRepr*)repr)->size : (uint64_t)BSQPartialVectorType::getPVCount(repr);
+    }
+
+    //true if the subtree l is not too light compared to r
+    inline static bool isBalanced(void* l, void* r)
+    {
+        return BSQ_LIST_TREE_DELTA * BSQListTreeType::getSize(l) >= BSQListTreeType::getSize(r);
+    }
+
+    inline static bool isSingleRotation(void* l, void* r)
+    {
+        return BSQListTreeType::getSize(l) < BSQ_LIST_TREE_GAMMA * BSQListTreeType::getSize(r);
+    }
 };
 
 struct BSQListTypeFlavor
@@ -294,7 +319,7 @@ public:
             this->iterstack.pop_back();
         }
 
-        rr = static_cast<BSQListTreeRepr*>(rr)->r;
+        rr = static_cast<BSQListTreeRepr*>(this->iterstack.back())->r;
         const BSQListReprType* rt = static_cast<const BSQListReprType*>(GET_TYPE_META_DATA(rr));
         while(rt->lkind == ListReprKind::TreeElement)
         {
@@ -382,7 +407,7 @@ public:
             this->iterstack.pop_back();
         }
 
-        rr = static_cast<BSQListTreeRepr*>(rr)->r;
+        rr = static_cast<BSQListTreeRepr*>(this->iterstack.back())->l;
         const BSQListReprType* rt = static_cast<const BSQListReprType*>(GET_TYPE_META_DATA(rr));
         while(rt->lkind == ListReprKind::TreeElement)
         {
@@ -15,10 +15,15 @@
 #define MAP_STORE_RESULT_REPR(R, COUNT, SL) SLPTR_STORE_UNION_INLINE_TYPE(GET_TYPE_META_DATA(R), SL); SLPTR_STORE_CONTENTS_AS(BSQNat, SLPTR_LOAD_UNION_INLINE_DATAPTR(SL), COUNT); SLPTR_STORE_CONTENTS_AS_GENERIC_HEAPOBJ(SLPTR_LOAD_UNION_INLINE_DATAPTR(SL) + 8, R)
 #define MAP_STORE_RESULT_EMPTY(SL) SLPTR_STORE_UNION_INLINE_TYPE(BSQWellKnownType::g_typeNone, SL); SLPTR_STORE_CONTENTS_AS(BSQNat, SLPTR_LOAD_UNION_INLINE_DATAPTR(SL), 0)
 
+//Weight balanced (Adams/Hirai-Yamamoto with delta = 3 and gamma = 2) so the size of the subtree is kept in each node
+#define BSQ_MAP_TREE_DELTA 3
+#define BSQ_MAP_TREE_GAMMA 2
+
 struct BSQMapTreeRepr
 {
     void* l;
     void* r;
+    uint64_t size;
 };
 
 class BSQMapTreeType : public BSQRefType
@@ -40,6 +45,7 @@ public:
     {
         ((BSQMapTreeRepr*)repr)->l = nullptr;
         ((BSQMapTreeRepr*)repr)->r = nullptr;
+        ((BSQMapTreeRepr*)repr)->size = 1;
 
         ktype->storeValue((StorageLocationPtr)((uint8_t*)repr + this->keyoffset), ksl);
         vtype->storeValue((StorageLocationPtr)((uint8_t*)repr + this->valueoffset), vsl);
@@ -49,6 +55,7 @@ public:
     {
         ((BSQMapTreeRepr*)repr)->l = l;
         ((BSQMapTreeRepr*)repr)->r = r;
+        ((BSQMapTreeRepr*)repr)->size = BSQMapTreeType::getSize(l) + BSQMapTreeType::getSize(r) + 1;
 
         ktype->storeValue((StorageLocationPtr)((uint8_t*)repr + this->keyoffset), ksl);
         vtype->storeValue((StorageLocationPtr)((uint8_t*)repr + this->valueoffset), vsl);
@@ -64,6 +71,22 @@ public:
         return ((BSQMapTreeRepr*)repr)->r;
     }
 
+    inline static uint64_t getSize(void* repr)
+    {
+        return repr != nullptr ? ((BSQMapTreeRepr*)repr)->size : 0;
+    }
+
+    //true if the subtree l is not too light compared to r (weights are size + 1)
+    inline static bool isBalanced(void* l, void* r)
+    {
+        return BSQ_MAP_TREE_DELTA * (BSQMapTreeType::getSize(l) + 1) >= (BSQMapTreeType::getSize(r) + 1);
+    }
+
+    inline static bool isSingleRotation(void* l, void* r)
+    {
+        return (BSQMapTreeType::getSize(l) + 1) < BSQ_MAP_TREE_GAMMA * (BSQMapTreeType::getSize(r) + 1);
+    }
+
     StorageLocationPtr getKeyLocation(void* repr) const
     {
         return (StorageLocationPtr)((uint8_t*)repr + this->keyoffset);
@@ -139,13 +162,115 @@ public:
 
     inline void pop()
     {
-        assert(this->valid());
+        assert(!this->iterstack.empty());
 
         this->lcurr = this->iterstack.back();
         this->iterstack.pop_back();
     }
 };
 
+//Hashed (HAMT) repr for maps with a hashable key -- each node is a word of bitmaps (the low 32 bits are the positions that hold a leaf chain
+//and the high 32 bits the positions that hold a sub node) followed by the children in position order. The node types only depend on the 
+//number of children so they are shared by all the maps. Leaves with the same full hash are chained with the next pointer.
+#define BSQ_MAP_HASH_BITS 5
+#define BSQ_MAP_HASH_WIDTH 32
+#define BSQ_MAP_HASH_POS(H, SHIFT) ((uint32_t)(((H) >> (SHIFT)) & (BSQ_MAP_HASH_WIDTH - 1)))
+
+#define BSQ_MAP_HASH_DATAMAP(BITMAP) ((uint32_t)(BITMAP))
+#define BSQ_MAP_HASH_NODEMAP(BITMAP) ((uint32_t)((BITMAP) >> 32))
+
+struct BSQMapHashNodeRepr
+{
+    uint64_t bitmap;
+};
+
+class BSQMapHashNodeType : public BSQRefType
+{
+public:
+    const uint32_t width;
+
+    BSQMapHashNodeType(BSQTypeID tid, uint32_t width, RefMask heapmask, std::string name)
+    : BSQRefType(tid, sizeof(uint64_t) + width * sizeof(void*), heapmask, {}, EMPTY_KEY_CMP, nullptr, name), width(width)
+    {;}
+
+    virtual ~BSQMapHashNodeType() {;}
+
+    inline static uint64_t getBitmap(void* repr)
+    {
+        return ((BSQMapHashNodeRepr*)repr)->bitmap;
+    }
+
+    inline static void** getChildren(void* repr)
+    {
+        return (void**)((uint8_t*)repr + sizeof(uint64_t));
+    }
+
+    inline static uint32_t getWidth(void* repr)
+    {
+        return std::popcount(BSQ_MAP_HASH_DATAMAP(((BSQMapHashNodeRepr*)repr)->bitmap) | BSQ_MAP_HASH_NODEMAP(((BSQMapHashNodeRepr*)repr)->bitmap));
+    }
+
+    //index in the children of the (occupied) position
+    inline static uint32_t childIndex(uint64_t bitmap, uint32_t pos)
+    {
+        uint32_t occupied = BSQ_MAP_HASH_DATAMAP(bitmap) | BSQ_MAP_HASH_NODEMAP(bitmap);
+        return std::popcount(occupied & ((1u << pos) - 1));
+    }
+};
+
+struct BSQMapHashLeafRepr
+{
+    void* next;
+    uint64_t hash;
+};
+
+class BSQMapHashLeafType : public BSQRefType
+{
+public:
+    const BSQTypeID keytype;
+    const uint32_t keyoffset;
+
+    const BSQTypeID valuetype;
+    const uint32_t valueoffset;
+
+    //Same K/V layout as the tree node (with next/hash in place of l/r/size)
+    BSQMapHashLeafType(BSQTypeID tid, const BSQMapTreeType* treetype, std::string name)
+    : BSQRefType(tid, treetype->allocinfo.heapsize - sizeof(void*), treetype->allocinfo.heapmask + 1, {}, EMPTY_KEY_CMP, nullptr, name), 
+        keytype(treetype->keytype), keyoffset(treetype->keyoffset - sizeof(void*)), valuetype(treetype->valuetype), valueoffset(treetype->valueoffset - sizeof(void*))
+    {;}
+
+    virtual ~BSQMapHashLeafType() {;}
+
+    inline void initialize(void* repr, uint64_t hash, StorageLocationPtr ksl, const BSQType* ktype, StorageLocationPtr vsl, const BSQType* vtype, void* next) const
+    {
+        ((BSQMapHashLeafRepr*)repr)->next = next;
+        ((BSQMapHashLeafRepr*)repr)->hash = hash;
+
+        ktype->storeValue((StorageLocationPtr)((uint8_t*)repr + this->keyoffset), ksl);
+        vtype->storeValue((StorageLocationPtr)((uint8_t*)repr + this->valueoffset), vsl);
+    }
+
+    inline static void* getNext(void* repr)
+    {
+        return ((BSQMapHashLeafRepr*)repr)->next;
+    }
+
+    inline static uint64_t getHash(void* repr)
+    {
+        return ((BSQMapHashLeafRepr*)repr)->hash;
+    }
+
+    StorageLocationPtr getKeyLocation(void* repr) const
+    {
+        return (StorageLocationPtr)((uint8_t*)repr + this->keyoffset);
+    }
+
+    StorageLocationPtr getValueLocation(void* repr) const
+    {
+        return (StorageLocationPtr)((uint8_t*)repr + this->valueoffset);
+    }
+};
+
 struct BSQMapTypeFlavor
 {
     const BSQTypeID mtype;
@@ -156,6 +281,9 @@ struct BSQMapTypeFlavor
     const BSQType* tupletype;
 
     const BSQMapTreeType* treetype;
+
+    //set (by the loader) when the map uses the hashed repr
+    const BSQMapHashLeafType* hashleaftype;
 };
 
 //MAP
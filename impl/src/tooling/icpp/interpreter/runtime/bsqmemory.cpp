@@ -5,27 +5,909 @@
 
 #include "bsqmemory.h"
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
 const BSQType** BSQType::g_typetable = nullptr;
 
-GCStackEntry GCStack::frames[BSQ_MAX_STACK];
+GCStackEntry* GCStack::frames = nullptr;
 uint32_t GCStack::stackp = 0;
+uint32_t GCStack::capacity = 0;
+uint32_t GCStack::maxframes = 2 * BSQ_DEFAULT_MAX_STACK;
+
+void GCStack::growFrames_slow()
+{
+    if(GCStack::capacity >= GCStack::maxframes)
+    {
+        handleStackLimitAbort("GC frame");
+    }
+
+    uint32_t ncapacity = std::min(std::max(2 * GCStack::capacity, (uint32_t)BSQ_INITIAL_STACK), GCStack::maxframes);
+    GCStackEntry* nframes = (GCStackEntry*)malloc(ncapacity * sizeof(GCStackEntry));
+    std::copy(GCStack::frames, GCStack::frames + GCStack::stackp, nframes);
+
+    free(GCStack::frames);
+    GCStack::frames = nframes;
+    GCStack::capacity = ncapacity;
+}
+
+void BumpSpaceAllocator::ensureSpace_slow(size_t required)
+{
+    if(!this->extendZeroedSpace(required))
+    {
+        Allocator::GlobalAllocator.collect();
+
+        //the nursery is empty after a collection so this always has the space
+        this->extendZeroedSpace(required);
+    }
+}
+
+RCSlab* RCSpaceAllocator::allocateSlab_slow(size_t sclass)
+{
+    RCSlab* slab = nullptr;
+    if(!this->emptyslabs.empty())
+    {
+        slab = this->emptyslabs.back();
+        this->emptyslabs.pop_back();
+    }
+    else if(!this->decommittedslabs.empty())
+    {
+        slab = this->decommittedslabs.back();
+        this->decommittedslabs.pop_back();
+    }
+    else
+    {
+        if(this->chunkpos == this->chunkend)
+        {
+            //over allocate by a slab so the chunk can be aligned
+            size_t csize = (BSQ_RC_SLAB_CHUNK_SLABS + 1) * BSQ_RC_SLAB_SIZE;
+            uint8_t* chunk = (uint8_t*)BSQ_PAGE_SPACE_ALLOC(csize);
+            assert(chunk != nullptr && chunk != (uint8_t*)-1);
+
+            this->chunkpos = (uint8_t*)(((uintptr_t)chunk + BSQ_RC_SLAB_SIZE - 1) & ~((uintptr_t)BSQ_RC_SLAB_SIZE - 1));
+            this->chunkend = this->chunkpos + BSQ_RC_SLAB_CHUNK_SLABS * BSQ_RC_SLAB_SIZE;
+        }
 
-void BumpSpaceAllocator::ensureSpace_slow()
+        slab = (RCSlab*)this->chunkpos;
+        this->chunkpos += BSQ_RC_SLAB_SIZE;
+    }
+
+    size_t hsize = (sizeof(RCSlab) + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    size_t osize = RCSpaceAllocator::objectSizeFor(sclass);
+
+    slab->freelist = nullptr;
+    slab->bumppos = ((uint8_t*)slab) + hsize;
+    slab->sizeclass = (uint32_t)sclass;
+    slab->livecount = 0;
+    slab->capacity = (uint32_t)((BSQ_RC_SLAB_SIZE - hsize) / osize);
+    slab->pendingempty = false;
+
+    this->linkPartial(slab);
+    return slab;
+}
+
+void RCSpaceAllocator::releaseEmptySlabs()
 {
-    Allocator::GlobalAllocator.collect();
+    for(size_t i = 0; i < this->pendingempty.size(); ++i)
+    {
+        RCSlab* slab = this->pendingempty[i];
+        slab->pendingempty = false;
+
+        //keep the slab at the head of the partial list for its class so alternating alloc/release does not churn slabs
+        if(slab->livecount != 0 || this->partial[slab->sizeclass] == slab)
+        {
+            continue;
+        }
+
+        this->unlinkPartial(slab);
+        if(this->emptyslabs.size() < BSQ_RC_SLAB_RETAIN_EMPTY)
+        {
+            this->emptyslabs.push_back(slab);
+        }
+        else
+        {
+            BSQ_PAGE_SPACE_DECOMMIT(slab, BSQ_RC_SLAB_SIZE);
+            this->decommittedslabs.push_back(slab);
+        }
+    }
+
+    this->pendingempty.clear();
 }
 
 Allocator Allocator::GlobalAllocator;
+bool Allocator::g_pretenure = true;
+bool Allocator::g_telemetry = false;
+
+std::vector<BSQCollectionGCReprNode*> Allocator::collectionsegments = { new BSQCollectionGCReprNode[BSQ_INITIAL_STACK] };
+size_t Allocator::collectionsegmentidx = 0;
+BSQCollectionGCReprNode* Allocator::collectionnodesend = Allocator::collectionsegments[0];
+BSQCollectionGCReprNode* Allocator::collectionnodeslimit = Allocator::collectionsegments[0] + BSQ_INITIAL_STACK;
+size_t Allocator::maxcollectionnodes = 2 * BSQ_DEFAULT_MAX_STACK;
+
+void Allocator::nextCollectionSegment_slow()
+{
+    if((Allocator::collectionsegmentidx + 1) * BSQ_INITIAL_STACK >= Allocator::maxcollectionnodes)
+    {
+        handleStackLimitAbort("collection node");
+    }
+
+    //segments are kept once allocated so a deep op only pays for them once
+    Allocator::collectionsegmentidx++;
+    if(Allocator::collectionsegmentidx == Allocator::collectionsegments.size())
+    {
+        Allocator::collectionsegments.push_back(new BSQCollectionGCReprNode[BSQ_INITIAL_STACK]);
+    }
 
-BSQCollectionGCReprNode* Allocator::collectionnodesend = Allocator::collectionnodes;
-BSQCollectionGCReprNode Allocator::collectionnodes[BSQ_MAX_STACK];
-std::list<BSQCollectionIterator*> Allocator::collectioniters;
-std::vector<std::list<BSQTempRootNode>> Allocator::alloctemps;
+    Allocator::collectionnodesend = Allocator::collectionsegments[Allocator::collectionsegmentidx];
+    Allocator::collectionnodeslimit = Allocator::collectionnodesend + BSQ_INITIAL_STACK;
+}
+BSQCollectionIterator* Allocator::collectioniters = nullptr;
+
+std::vector<BSQTempRootNode> Allocator::temproots;
+std::vector<BSQTempRootScope> Allocator::temprootscopes;
+std::vector<uint8_t*> Allocator::temprootsegments = { (uint8_t*)zxalloc(BSQ_TEMP_ROOT_SEGMENT_SIZE) };
+size_t Allocator::temprootsegmentidx = 0;
+uint8_t* Allocator::temprootpos = Allocator::temprootsegments[0];
+uint8_t* Allocator::temprootlimit = Allocator::temprootsegments[0] + BSQ_TEMP_ROOT_SEGMENT_SIZE;
+
+void Allocator::nextTempRootSegment_slow()
+{
+    Allocator::temprootsegmentidx++;
+    if(Allocator::temprootsegmentidx == Allocator::temprootsegments.size())
+    {
+        Allocator::temprootsegments.push_back((uint8_t*)zxalloc(BSQ_TEMP_ROOT_SEGMENT_SIZE));
+    }
+
+    Allocator::temprootpos = Allocator::temprootsegments[Allocator::temprootsegmentidx];
+    Allocator::temprootlimit = Allocator::temprootpos + BSQ_TEMP_ROOT_SEGMENT_SIZE;
+}
 
 #ifdef BSQ_DEBUG_BUILD
     std::map<size_t, std::pair<const BSQType*, void*>> Allocator::dbg_idToObjMap;
 #endif
 
+void Allocator::displayGCStats(FILE* fp) const
+{
+    double totalms = (double)this->pausestats.totalns / 1000000.0;
+    double maxms = (double)this->pausestats.maxns / 1000000.0;
+    double avgms = this->pausestats.count != 0 ? totalms / (double)this->pausestats.count : 0.0;
+
+    fprintf(fp, "GC: %llu collections with %u thread(s) -- pause total %.3fms max %.3fms avg %.3fms\n", (unsigned long long)this->pausestats.count, GCParallelEvacuator::g_threadcount, totalms, maxms, avgms);
+
+    //the release thread may still be working on the last batch
+    GCBackgroundReleaser::waitForIdle();
+
+    double pausereleasems = (double)this->pausestats.pausereleasens / 1000000.0;
+    double backgroundreleasems = (double)this->pausestats.backgroundreleasens / 1000000.0;
+    fprintf(fp, "GC: released %zu bytes -- %.3fms in the pause and %.3fms on the background release thread\n", (size_t)this->pausestats.releasedbytes, pausereleasems, backgroundreleasems);
+
+    const GCNurseryPolicy& policy = this->bumpalloc.getPolicy();
+    fprintf(fp, "GC: nursery %zuKB (bounds %zuKB-%zuKB target pause %.3fms)\n", this->bumpalloc.currentNurserySize() / 1024, policy.minsize / 1024, policy.maxsize / 1024, (double)policy.targetpausens / 1000000.0);
+
+    //survival of the most allocated types (and how many were allocated directly in the old space)
+    std::vector<size_t> tids;
+    for(size_t i = 0; i < this->typesurvival.size(); ++i)
+    {
+        const GCTypeSurvival& ts = this->typesurvival[i];
+        if(ts.totalallocated + ts.allocated + ts.totalpretenured != 0)
+        {
+            tids.push_back(i);
+        }
+    }
+
+    auto totalfor = [this](size_t tid) {
+        const GCTypeSurvival& ts = this->typesurvival[tid];
+        return ts.totalallocated + ts.allocated + ts.totalpretenured;
+    };
+    std::stable_sort(tids.begin(), tids.end(), [&totalfor](size_t t1, size_t t2) { return totalfor(t1) > totalfor(t2); });
+
+    for(size_t i = 0; i < std::min(tids.size(), (size_t)10); ++i)
+    {
+        const GCTypeSurvival& ts = this->typesurvival[tids[i]];
+        uint64_t nursery = ts.totalallocated + ts.allocated;
+        uint64_t survived = ts.totalsurvived + ts.survived;
+        double survivalpct = nursery != 0 ? (100.0 * (double)survived) / (double)nursery : 0.0;
+
+        fprintf(fp, "GC: %s -- %llu in nursery (%.1f%% survived) %llu pretenured%s\n", BSQType::g_typetable[tids[i]]->name.c_str(), (unsigned long long)nursery, survivalpct, (unsigned long long)ts.totalpretenured, ts.pretenuregcs != 0 ? " [pretenuring]" : "");
+    }
+}
+
+void Allocator::updatePretenuring()
+{
+    //the release thread owns the old space between collections so the mutator cannot allocate in it then
+    bool enabled = Allocator::g_pretenure && !GCBackgroundReleaser::g_enabled;
+
+    for(size_t i = 0; i < this->typesurvival.size(); ++i)
+    {
+        GCTypeSurvival& ts = this->typesurvival[i];
+        if(ts.pretenuregcs != 0)
+        {
+            //when this hits 0 the type goes back to the nursery and a new window starts
+            ts.pretenuregcs--;
+        }
+        else if(ts.allocated >= BSQ_PRETENURE_MIN_ALLOCS)
+        {
+            if(enabled && (ts.survived * 100) >= (ts.allocated * BSQ_PRETENURE_SURVIVAL_PERCENT))
+            {
+                ts.pretenuregcs = BSQ_PRETENURE_RECHECK_GCS;
+            }
+
+            ts.totalallocated += ts.allocated;
+            ts.totalsurvived += ts.survived;
+            ts.allocated = 0;
+            ts.survived = 0;
+        }
+    }
+}
+
+//////////////////////////////////
+//Background release
+
+struct GCReleaseThread
+{
+    std::mutex lock;
+    std::condition_variable startcv;
+    std::condition_variable donecv;
+    bool pending;
+    bool stopping;
+
+    std::thread worker;
+};
+
+bool GCBackgroundReleaser::g_enabled = false;
+
+//never freed -- shutdown joins the thread but the pointer stays valid for any late waitForIdle
+static GCReleaseThread* s_gcrelease = nullptr;
+
+static void gcReleaseLoop()
+{
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(s_gcrelease->lock);
+            s_gcrelease->startcv.wait(lock, []() { return s_gcrelease->pending || s_gcrelease->stopping; });
+            if(!s_gcrelease->pending)
+            {
+                return;
+            }
+        }
+
+        GCBackgroundReleaser::releaseAll();
+
+        {
+            std::lock_guard<std::mutex> lock(s_gcrelease->lock);
+            s_gcrelease->pending = false;
+            s_gcrelease->donecv.notify_all();
+        }
+    }
+}
+
+void GCBackgroundReleaser::configure()
+{
+    GCBackgroundReleaser::g_enabled = true;
+
+    s_gcrelease = new GCReleaseThread();
+    s_gcrelease->pending = false;
+    s_gcrelease->stopping = false;
+    s_gcrelease->worker = std::thread(gcReleaseLoop);
+
+    //the thread frees into GlobalAllocator so it must be finished before the statics are destroyed (on a return from main or an exit)
+    std::atexit(GCBackgroundReleaser::shutdown);
+}
+
+void GCBackgroundReleaser::start()
+{
+    {
+        std::lock_guard<std::mutex> lock(s_gcrelease->lock);
+        s_gcrelease->pending = true;
+    }
+    s_gcrelease->startcv.notify_one();
+}
+
+void GCBackgroundReleaser::waitForIdle()
+{
+    if(GCBackgroundReleaser::g_enabled)
+    {
+        std::unique_lock<std::mutex> lock(s_gcrelease->lock);
+        s_gcrelease->donecv.wait(lock, []() { return !s_gcrelease->pending; });
+    }
+}
+
+void GCBackgroundReleaser::shutdown()
+{
+    if(GCBackgroundReleaser::g_enabled && s_gcrelease->worker.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_gcrelease->lock);
+            s_gcrelease->stopping = true;
+        }
+        s_gcrelease->startcv.notify_one();
+
+        //a pending release is finished before the thread exits
+        s_gcrelease->worker.join();
+    }
+}
+
+void GCBackgroundReleaser::releaseAll()
+{
+    Allocator& alloc = Allocator::GlobalAllocator;
+    auto releasestart = std::chrono::steady_clock::now();
+
+    //the marks from the pause are still set so objects the mutator holds only from its roots are not released
+    size_t releasedbytes = alloc.processRelease(SIZE_MAX);
+    alloc.pausestats.releasedbytes += releasedbytes;
+    if(Allocator::g_telemetry)
+    {
+        alloc.gctelemetry.back().releasedbytes += releasedbytes;
+    }
+
+    for(size_t i = 0; i < alloc.deferredmarks.size(); ++i)
+    {
+        std::atomic_ref<GC_META_DATA_WORD>(*GC_GET_META_DATA_ADDR(alloc.deferredmarks[i])).fetch_and(GC_RC_MASK | GC_YOUNG_BIT | GC_TYPE_ID_MASK, std::memory_order_relaxed);
+    }
+    alloc.deferredmarks.clear();
+
+    alloc.pausestats.backgroundreleasens += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - releasestart).count();
+}
+
+//////////////////////////////////
+//Parallel minor collection
+
+struct GCParallelWorker
+{
+    uint32_t id;
+
+    //promoted objects still to trace -- shared is the part the other workers may take when they run out
+    std::vector<void*> local;
+    std::mutex sharedlock;
+    std::vector<void*> shared;
+    std::atomic<size_t> sharedcount;
+
+    //each worker promotes into its own slabs so the copy path takes no locks
+    RCSlab* slabs[BSQ_RC_SLAB_SIZE_CLASS_COUNT];
+    std::vector<void*> newroots;
+    size_t promotedbytes;
+
+    //promoted count per type id (for the pretenuring survival rates)
+    std::vector<uint64_t> survived;
+};
+
+uint32_t GCParallelEvacuator::g_threadcount = 1;
+
+static std::vector<GCParallelWorker*> s_gcworkers;
+static std::mutex s_gcslablock;
+
+struct GCWorkerPool
+{
+    std::mutex lock;
+    std::condition_variable startcv;
+    std::condition_variable donecv;
+    uint64_t generation;
+    uint32_t running;
+};
+
+//never freed -- the parked pool threads are still waiting on it when the statics are destroyed at exit
+static GCWorkerPool* s_gcpool = nullptr;
+
+//workers that may still produce work -- the trace is done when this hits zero
+static std::atomic<uint32_t> s_gcactive(0);
+
+//start of the current parallel trace (worker 0 records the roots time from it)
+static std::chrono::steady_clock::time_point s_gcstart;
+
+static void* gcParAllocatePromoted(GCParallelWorker& wk, size_t osize)
+{
+    if(osize > BSQ_RC_SLAB_MAX_OBJECT_SIZE)
+    {
+        return BSQ_FREE_LIST_ALLOC_LARGE(osize);
+    }
+
+    size_t sclass = RCSpaceAllocator::sizeClassFor(osize);
+    RCSlab* slab = wk.slabs[sclass];
+    if(slab == nullptr || slab->livecount == slab->capacity)
+    {
+        //full slabs are dropped just like they leave the partial list in the serial path
+        slab = GCParallelEvacuator::takeSlab(sclass);
+        wk.slabs[sclass] = slab;
+    }
+
+    return RCSpaceAllocator::allocateFromSlab(slab);
+}
+
+//Called by the worker that won the claim on the young object at addr (its header is the busy sentinel and w is the original word)
+template <bool isRoot>
+static void* gcParEvacuate(GCParallelWorker& wk, void* obj, GC_META_DATA_WORD* addr, GC_META_DATA_WORD w)
+{
+    const BSQType* ometa = GET_TYPE_META_DATA_FROM_WORD(w);
+    size_t osize = ometa->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
+
+    void* nobj = gcParAllocatePromoted(wk, osize);
+    wk.promotedbytes += osize;
+    wk.survived[ometa->tid]++;
+
+    void* robj = (void*)((uint8_t*)nobj + sizeof(GC_META_DATA_WORD));
+    GC_MEM_COPY(robj, obj, ometa->allocinfo.heapsize);
+
+    if(!ometa->isLeaf())
+    {
+        wk.local.push_back(robj);
+    }
+
+    if constexpr (isRoot)
+    {
+        GC_INIT_OLD_RC_ROOT_REF(nobj, w);
+        wk.newroots.push_back(robj);
+    }
+    else
+    {
+        GC_INIT_OLD_RC_HEAP_REF(nobj, w);
+    }
+
+    GC_SET_FORWARD_PTR(obj, robj);
+    std::atomic_ref<GC_META_DATA_WORD>(*addr).store(0, std::memory_order_release);
+
+    return robj;
+}
+
+template <bool isRoot>
+static void gcParProcessSlot(GCParallelWorker& wk, void** slot)
+{
+    void* v = *slot;
+    if(v == nullptr)
+    {
+        return;
+    }
+
+    GC_META_DATA_WORD* addr = GC_GET_META_DATA_ADDR(v);
+    std::atomic_ref<GC_META_DATA_WORD> aw(*addr);
+    GC_META_DATA_WORD w = aw.load(std::memory_order_acquire);
+    if(GC_TEST_IS_YOUNG(w) && aw.compare_exchange_strong(w, GC_FORWARD_BUSY_SENTINAL, std::memory_order_acquire))
+    {
+        *slot = gcParEvacuate<isRoot>(wk, v, addr, w);
+        return;
+    }
+
+    //another worker has (or is) moving it so wait for the copy and follow the forward pointer
+    while(w == GC_FORWARD_BUSY_SENTINAL)
+    {
+        std::this_thread::yield();
+        w = aw.load(std::memory_order_acquire);
+    }
+
+    if(GC_IS_TYPE_META_DATA_FORWARD_SENTINAL(w))
+    {
+        v = GC_GET_FORWARD_PTR(v);
+        *slot = v;
+        addr = GC_GET_META_DATA_ADDR(v);
+    }
+
+    std::atomic_ref<GC_META_DATA_WORD> ow(*addr);
+    if constexpr (isRoot)
+    {
+        ow.fetch_or(GC_MARK_BIT, std::memory_order_relaxed);
+    }
+    else
+    {
+        ow.fetch_add(GC_RC_ONE, std::memory_order_relaxed);
+    }
+}
+
+template <bool isRoot>
+static void gcParProcessSlotWithString(GCParallelWorker& wk, void** slot)
+{
+    if(!IS_INLINE_STRING(*slot))
+    {
+        gcParProcessSlot<isRoot>(wk, slot);
+    }
+}
+
+template <bool isRoot>
+static void gcParProcessSlotWithBigNum(GCParallelWorker& wk, void** slot)
+{
+    if(!IS_INLINE_BIGNUM(*slot))
+    {
+        gcParProcessSlot<isRoot>(wk, slot);
+    }
+}
+
+template <bool isRoot>
+static void gcParProcessSlotsWithPlan(GCParallelWorker& wk, void** slots, const GCTracePlan& plan);
+
+//the inlinedmask of the content type covers its representation after the type word
+template <bool isRoot>
+static void gcParProcessSlotsWithUnion(GCParallelWorker& wk, void** slots)
+{
+    if(*slots != nullptr)
+    {
+        const BSQType* umeta = ((const BSQType*)(*slots));
+        gcParProcessSlotsWithPlan<isRoot>(wk, slots + 1, umeta->inlinedplan);
+    }
+}
+
+template <bool isRoot>
+static void gcParProcessSlotsWithPlan(GCParallelWorker& wk, void** slots, const GCTracePlan& plan)
+{
+    uint64_t bits = plan.ptrbits;
+    while(bits != 0)
+    {
+        gcParProcessSlot<isRoot>(wk, slots + std::countr_zero(bits));
+        bits &= (bits - 1);
+    }
+
+    if(plan.hasextra)
+    {
+        for(size_t i = 0; i < plan.ptrslots.size(); ++i)
+        {
+            gcParProcessSlot<isRoot>(wk, slots + plan.ptrslots[i]);
+        }
+        for(size_t i = 0; i < plan.stringslots.size(); ++i)
+        {
+            gcParProcessSlotWithString<isRoot>(wk, slots + plan.stringslots[i]);
+        }
+        for(size_t i = 0; i < plan.bignumslots.size(); ++i)
+        {
+            gcParProcessSlotWithBigNum<isRoot>(wk, slots + plan.bignumslots[i]);
+        }
+        for(size_t i = 0; i < plan.unionslots.size(); ++i)
+        {
+            gcParProcessSlotsWithUnion<isRoot>(wk, slots + plan.unionslots[i]);
+        }
+    }
+}
+
+static void gcParProcessRootSlotsWithMask(GCParallelWorker& wk, void** slots, RefMask mask)
+{
+    void** cslot = slots;
+
+    RefMask cmaskop = mask;
+    while (*cmaskop)
+    {
+        char op = *cmaskop++;
+        switch(op)
+        {
+            case PTR_FIELD_MASK_NOP:
+                break;
+            case PTR_FIELD_MASK_PTR:
+                gcParProcessSlot<true>(wk, cslot);
+                break;
+            case PTR_FIELD_MASK_STRING:
+                gcParProcessSlotWithString<true>(wk, cslot);
+                break;
+            case PTR_FIELD_MASK_BIGNUM:
+                gcParProcessSlotWithBigNum<true>(wk, cslot);
+                break;
+            default:
+                gcParProcessSlotsWithUnion<true>(wk, cslot);
+                break;
+        }
+        cslot++;
+    }
+}
+
+static void gcParShareWork(GCParallelWorker& wk)
+{
+    std::lock_guard<std::mutex> lock(wk.sharedlock);
+
+    //share the oldest half -- the owner keeps working on the most recently promoted (and likely cache warm) objects
+    size_t half = wk.local.size() / 2;
+    wk.shared.insert(wk.shared.end(), wk.local.begin(), wk.local.begin() + half);
+    wk.local.erase(wk.local.begin(), wk.local.begin() + half);
+    wk.sharedcount.store(wk.shared.size(), std::memory_order_relaxed);
+}
+
+static bool gcParReclaimShared(GCParallelWorker& wk)
+{
+    std::lock_guard<std::mutex> lock(wk.sharedlock);
+    if(wk.shared.empty())
+    {
+        return false;
+    }
+
+    wk.local.insert(wk.local.end(), wk.shared.begin(), wk.shared.end());
+    wk.shared.clear();
+    wk.sharedcount.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+static bool gcParSteal(GCParallelWorker& wk)
+{
+    size_t nworkers = s_gcworkers.size();
+    for(size_t i = 1; i < nworkers; ++i)
+    {
+        GCParallelWorker* victim = s_gcworkers[(wk.id + i) % nworkers];
+        if(victim->sharedcount.load(std::memory_order_relaxed) == 0)
+        {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(victim->sharedlock);
+        size_t take = (victim->shared.size() + 1) / 2;
+        if(take == 0)
+        {
+            continue;
+        }
+
+        wk.local.insert(wk.local.end(), victim->shared.end() - take, victim->shared.end());
+        victim->shared.resize(victim->shared.size() - take);
+        victim->sharedcount.store(victim->shared.size(), std::memory_order_relaxed);
+        return true;
+    }
+
+    return false;
+}
+
+static bool gcParAnyShared()
+{
+    for(size_t i = 0; i < s_gcworkers.size(); ++i)
+    {
+        if(s_gcworkers[i]->sharedcount.load(std::memory_order_relaxed) != 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void gcParDrain(GCParallelWorker& wk)
+{
+    do
+    {
+        while(!wk.local.empty())
+        {
+            void* obj = wk.local.back();
+            wk.local.pop_back();
+
+            //other workers may be bumping the RC of this copy so only the (stable) type id bits are read
+            GC_META_DATA_WORD w = std::atomic_ref<GC_META_DATA_WORD>(*GC_GET_META_DATA_ADDR(obj)).load(std::memory_order_relaxed);
+            gcParProcessSlotsWithPlan<false>(wk, (void**)obj, GET_TYPE_META_DATA_FROM_WORD(w)->heapplan);
+
+            if(wk.local.size() > BSQ_GC_PAR_EXPORT_THRESHOLD && wk.sharedcount.load(std::memory_order_relaxed) == 0)
+            {
+                gcParShareWork(wk);
+            }
+        }
+    } while(gcParReclaimShared(wk));
+}
+
+static void gcParRunWorker(GCParallelWorker& wk)
+{
+    //frames are striped over the workers and worker 0 takes everything else
+    for(size_t i = wk.id; i < GCStack::stackp; i += s_gcworkers.size())
+    {
+        gcParProcessRootSlotsWithMask(wk, GCStack::frames[i].framep, GCStack::frames[i].mask);
+    }
+
+    if(wk.id == 0)
+    {
+        GCParallelEvacuator::processSharedRoots(wk);
+    }
+
+    bool working = true;
+    while(working)
+    {
+        gcParDrain(wk);
+        if(gcParSteal(wk))
+        {
+            continue;
+        }
+
+        //idle workers hold no work so once none are active everything reachable has been traced
+        working = false;
+        s_gcactive.fetch_sub(1, std::memory_order_acq_rel);
+        while(!working && s_gcactive.load(std::memory_order_acquire) != 0)
+        {
+            if(gcParAnyShared())
+            {
+                s_gcactive.fetch_add(1, std::memory_order_acq_rel);
+                working = gcParSteal(wk);
+                if(!working)
+                {
+                    s_gcactive.fetch_sub(1, std::memory_order_acq_rel);
+                }
+            }
+
+            std::this_thread::yield();
+        }
+    }
+}
+
+static void gcParPoolLoop(uint32_t id)
+{
+    uint64_t seen = 0;
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(s_gcpool->lock);
+            s_gcpool->startcv.wait(lock, [&seen]() { return s_gcpool->generation != seen; });
+            seen = s_gcpool->generation;
+        }
+
+        gcParRunWorker(*s_gcworkers[id]);
+
+        {
+            std::lock_guard<std::mutex> lock(s_gcpool->lock);
+            s_gcpool->running--;
+            if(s_gcpool->running == 0)
+            {
+                s_gcpool->donecv.notify_one();
+            }
+        }
+    }
+}
+
+void GCParallelEvacuator::configure(uint32_t nthreads)
+{
+    GCParallelEvacuator::g_threadcount = std::min(std::max(nthreads, (uint32_t)1), (uint32_t)BSQ_GC_MAX_THREADS);
+    s_gcpool = new GCWorkerPool();
+    s_gcpool->generation = 0;
+    s_gcpool->running = 0;
+
+    for(uint32_t i = 0; i < GCParallelEvacuator::g_threadcount; ++i)
+    {
+        GCParallelWorker* wk = new GCParallelWorker();
+        wk->id = i;
+        wk->sharedcount.store(0);
+        std::fill(wk->slabs, wk->slabs + BSQ_RC_SLAB_SIZE_CLASS_COUNT, nullptr);
+        wk->promotedbytes = 0;
+
+        s_gcworkers.push_back(wk);
+    }
+
+    //the calling thread is worker 0 and the pool threads just park between collections
+    for(uint32_t i = 1; i < GCParallelEvacuator::g_threadcount; ++i)
+    {
+        std::thread(gcParPoolLoop, i).detach();
+    }
+}
+
+void GCParallelEvacuator::evacuate()
+{
+    for(size_t i = 0; i < s_gcworkers.size(); ++i)
+    {
+        s_gcworkers[i]->survived.resize(Allocator::GlobalAllocator.typesurvival.size(), 0);
+    }
+
+    s_gcstart = std::chrono::steady_clock::now();
+    s_gcactive.store((uint32_t)s_gcworkers.size(), std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(s_gcpool->lock);
+        s_gcpool->running = (uint32_t)s_gcworkers.size() - 1;
+        s_gcpool->generation++;
+    }
+    s_gcpool->startcv.notify_all();
+
+    gcParRunWorker(*s_gcworkers[0]);
+
+    {
+        std::unique_lock<std::mutex> lock(s_gcpool->lock);
+        s_gcpool->donecv.wait(lock, []() { return s_gcpool->running == 0; });
+    }
+
+    for(size_t i = 0; i < s_gcworkers.size(); ++i)
+    {
+        GCParallelEvacuator::mergeWorker(*s_gcworkers[i]);
+    }
+}
+
+RCSlab* GCParallelEvacuator::takeSlab(size_t sclass)
+{
+    std::lock_guard<std::mutex> lock(s_gcslablock);
+    return Allocator::GlobalAllocator.rcspace.takeSlab(sclass);
+}
+
+void GCParallelEvacuator::processSharedRoots(GCParallelWorker& wk)
+{
+    //objects pretenured since the last collection are traced just like promoted ones (so other workers can take them)
+    while(!Allocator::GlobalAllocator.pretenuredobjs.empty())
+    {
+        wk.local.push_back(Allocator::GlobalAllocator.pretenuredobjs.deque());
+    }
+
+    if(Allocator::GlobalAllocator.globals_mem != nullptr)
+    {
+        gcParProcessRootSlotsWithMask(wk, (void**)Allocator::GlobalAllocator.globals_mem, Allocator::GlobalAllocator.globals_mask);
+    }
+
+    for(size_t j = 0; j <= Allocator::collectionsegmentidx; ++j)
+    {
+        BSQCollectionGCReprNode* cni = Allocator::collectionsegments[j];
+        BSQCollectionGCReprNode* cnend = (j == Allocator::collectionsegmentidx) ? Allocator::collectionnodesend : (cni + BSQ_INITIAL_STACK);
+        while(cni < cnend)
+        {
+            gcParProcessSlot<true>(wk, &(cni->repr));
+            cni++;
+        }
+    }
+
+    for(BSQCollectionIterator* citer = Allocator::collectioniters; citer != nullptr; citer = citer->gcnext)
+    {
+        gcParProcessSlot<true>(wk, &(citer->lcurr));
+        for(auto piter = citer->iterstack.begin(); piter != citer->iterstack.end(); piter++)
+        {
+            gcParProcessSlot<true>(wk, &(*piter));
+        }
+    }
+
+    for(size_t i = 0; i < Allocator::temproots.size(); ++i)
+    {
+        gcParProcessSlotsWithPlan<true>(wk, (void**)Allocator::temproots[i].root, Allocator::temproots[i].rtype->inlinedplan);
+    }
+
+    //worker 0 has scanned its stripe of the frames and all the shared roots (so the rest of the parallel trace is counted as heap time)
+    Allocator::GlobalAllocator.currentcycle.rootsns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_gcstart).count();
+}
+
+void GCParallelEvacuator::mergeWorker(GCParallelWorker& wk)
+{
+    for(size_t i = 0; i < BSQ_RC_SLAB_SIZE_CLASS_COUNT; ++i)
+    {
+        if(wk.slabs[i] != nullptr)
+        {
+            Allocator::GlobalAllocator.rcspace.returnSlab(wk.slabs[i]);
+            wk.slabs[i] = nullptr;
+        }
+    }
+
+    for(size_t i = 0; i < wk.newroots.size(); ++i)
+    {
+        Allocator::GlobalAllocator.newMaybeZeroCounts.enque(wk.newroots[i]);
+    }
+    wk.newroots.clear();
+
+    for(size_t i = 0; i < wk.survived.size(); ++i)
+    {
+        Allocator::GlobalAllocator.typesurvival[i].survived += wk.survived[i];
+        wk.survived[i] = 0;
+    }
+
+    Allocator::GlobalAllocator.liveoldspace += wk.promotedbytes;
+    Allocator::GlobalAllocator.cyclepromotedbytes += wk.promotedbytes;
+    MEM_STATS_OP(Allocator::GlobalAllocator.promotedbytes += wk.promotedbytes);
+    wk.promotedbytes = 0;
+}
+
+GCTracePlan buildGCTracePlan(RefMask mask)
+{
+    GCTracePlan plan{0, false, {}, {}, {}, {}};
+    if(mask == nullptr)
+    {
+        return plan;
+    }
+
+    for(uint32_t i = 0; mask[i] != '\0'; ++i)
+    {
+        switch(mask[i])
+        {
+            case PTR_FIELD_MASK_NOP:
+                break;
+            case PTR_FIELD_MASK_PTR:
+                if(i < 64)
+                {
+                    plan.ptrbits |= ((uint64_t)1 << i);
+                }
+                else
+                {
+                    plan.ptrslots.push_back(i);
+                }
+                break;
+            case PTR_FIELD_MASK_STRING:
+                plan.stringslots.push_back(i);
+                break;
+            case PTR_FIELD_MASK_BIGNUM:
+                plan.bignumslots.push_back(i);
+                break;
+            default:
+                plan.unionslots.push_back(i);
+                break;
+        }
+    }
+
+    plan.hasextra = !(plan.ptrslots.empty() & plan.stringslots.empty() & plan.bignumslots.empty() & plan.unionslots.empty());
+    return plan;
+}
+
 void gcProcessRootOperator_nopImpl(const BSQType* btype, void** data)
 {
     return;
@@ -33,7 +915,7 @@ void gcProcessRootOperator_nopImpl(const BSQType* btype, void** data)
 
 void gcProcessRootOperator_inlineImpl(const BSQType* btype, void** data)
 {
-    Allocator::gcProcessSlotsWithMask<true>(data, btype->allocinfo.inlinedmask);
+    Allocator::gcProcessSlotsWithPlan<true>(data, btype->inlinedplan);
 }
 
 void gcProcessRootOperator_refImpl(const BSQType* btype, void** data)
@@ -58,22 +940,22 @@ void gcProcessHeapOperator_nopImpl(const BSQType* btype, void** data)
 
 void gcProcessHeapOperator_inlineImpl(const BSQType* btype, void** data)
 {
-    Allocator::gcProcessSlotsWithMask<true>(data, btype->allocinfo.inlinedmask);
+    Allocator::gcProcessSlotsWithPlan<false>(data, btype->inlinedplan);
 }
 
 void gcProcessHeapOperator_refImpl(const BSQType* btype, void** data)
 {
-    Allocator::gcProcessSlot<true>(data);
+    Allocator::gcProcessSlot<false>(data);
 }
 
 void gcProcessHeapOperator_stringImpl(const BSQType* btype, void** data)
 {
-    Allocator::gcProcessSlotWithString<true>(data);
+    Allocator::gcProcessSlotWithString<false>(data);
 }
 
 void gcProcessHeapOperator_bignumImpl(const BSQType* btype, void** data)
 {
-    Allocator::gcProcessSlotWithBigNum<true>(data);
+    Allocator::gcProcessSlotWithBigNum<false>(data);
 }
 
 void gcDecOperator_nopImpl(const BSQType* btype, void** data)
@@ -83,7 +965,7 @@ void gcDecOperator_nopImpl(const BSQType* btype, void** data)
 
 void gcDecOperator_inlineImpl(const BSQType* btype, void** data)
 {
-    Allocator::gcDecSlotsWithMask(data, btype->allocinfo.inlinedmask);
+    Allocator::gcDecSlotsWithPlan(data, btype->inlinedplan);
 }
 
 void gcDecOperator_refImpl(const BSQType* btype, void** data)
@@ -108,7 +990,7 @@ void gcClearOperator_nopImpl(const BSQType* btype, void** data)
 
 void gcClearOperator_inlineImpl(const BSQType* btype, void** data)
 {
-    Allocator::gcClearMarkSlotsWithMask(data, btype->allocinfo.inlinedmask);
+    Allocator::gcClearMarkSlotsWithPlan(data, btype->inlinedplan);
 }
 
 void gcClearOperator_refImpl(const BSQType* btype, void** data)
@@ -133,7 +1015,7 @@ void gcMakeImmortalOperator_nopImpl(const BSQType* btype, void** data)
 
 void gcMakeImmortalOperator_inlineImpl(const BSQType* btype, void** data)
 {
-    Allocator::gcMakeImmortalSlotsWithMask(data, btype->allocinfo.inlinedmask);
+    Allocator::gcMakeImmortalSlotsWithPlan(data, btype->inlinedplan);
 }
 
 void gcMakeImmortalOperator_refImpl(const BSQType* btype, void** data)
@@ -27,6 +27,8 @@ inline void xfree(void* mem)
     free(mem);
 }
 
+GCTracePlan buildGCTracePlan(RefMask mask);
+
 ////
 //BSQType abstract base class
 class BSQType
@@ -40,15 +42,20 @@ public:
     const BSQTypeSizeInfo allocinfo;
     const GCFunctorSet gcops;
 
+    //tracing plans for the heapmask and inlinedmask in allocinfo
+    const GCTracePlan heapplan;
+    const GCTracePlan inlinedplan;
+
     KeyCmpFP fpkeycmp;
+    KeyHashFP fpkeyhash;
     const std::map<BSQVirtualInvokeID, BSQInvokeID> vtable; //TODO: This is slow indirection but nice and simple
 
     DisplayFP fpDisplay;
     const std::string name;
 
     //Constructor that everyone delegates to
-    BSQType(BSQTypeID tid, BSQTypeLayoutKind tkind, BSQTypeSizeInfo allocinfo, GCFunctorSet gcops, std::map<BSQVirtualInvokeID, BSQInvokeID> vtable, KeyCmpFP fpkeycmp, DisplayFP fpDisplay, std::string name): 
-        tid(tid), tkind(tkind), allocinfo(allocinfo), gcops(gcops), fpkeycmp(fpkeycmp), vtable(vtable), fpDisplay(fpDisplay), name(name)
+    BSQType(BSQTypeID tid, BSQTypeLayoutKind tkind, BSQTypeSizeInfo allocinfo, GCFunctorSet gcops, std::map<BSQVirtualInvokeID, BSQInvokeID> vtable, KeyCmpFP fpkeycmp, DisplayFP fpDisplay, std::string name, KeyHashFP fpkeyhash = EMPTY_KEY_HASH): 
+        tid(tid), tkind(tkind), allocinfo(allocinfo), gcops(gcops), heapplan(buildGCTracePlan(allocinfo.heapmask)), inlinedplan(buildGCTracePlan(allocinfo.inlinedmask)), fpkeycmp(fpkeycmp), fpkeyhash(fpkeyhash), vtable(vtable), fpDisplay(fpDisplay), name(name)
     {;}
 
     virtual ~BSQType() {;}
@@ -96,7 +103,11 @@ public:
     std::vector<void*> iterstack;
     void* lcurr;
 
-    BSQCollectionIterator(): iterstack(), lcurr(nullptr) {;}
+    //links in the (intrusive) chain of registered iterators so registering and releasing are O(1) and allocation free
+    BSQCollectionIterator* gcprev;
+    BSQCollectionIterator* gcnext;
+
+    BSQCollectionIterator(): iterstack(), lcurr(nullptr), gcprev(nullptr), gcnext(nullptr) {;}
     virtual ~BSQCollectionIterator() {;}
 };
 
@@ -118,6 +129,14 @@ public:
     BSQTempRootNode(const BSQType* rtype, void* root): rtype(rtype), root(root) {;}
 };
 
+//Where a temp root scope starts in the node stack and the value segments
+struct BSQTempRootScope
+{
+    size_t nodestart;
+    size_t segmentidx;
+    uint8_t* datapos;
+};
+
 struct GCStackEntry
 {
     void** framep;
@@ -127,25 +146,26 @@ struct GCStackEntry
 class GCStack
 {
 public:
-    static GCStackEntry frames[BSQ_MAX_STACK];
+    static GCStackEntry* frames;
     static uint32_t stackp;
+    static uint32_t capacity;
+    static uint32_t maxframes;
 
     static void reset()
     {
         stackp = 1;
     }
 
+    static void growFrames_slow();
+
     inline static void pushFrame(void** framep, RefMask mask)
     {
-        if (GCStack::stackp < BSQ_MAX_STACK)
+        if (GCStack::stackp == GCStack::capacity)
         {
-            GCStack::frames[GCStack::stackp++] = { framep, mask };
-        }
-        else
-        {
-            printf("Out-Of-Stack\n");
-            exit(1);
+            GCStack::growFrames_slow();
         }
+
+        GCStack::frames[GCStack::stackp++] = { framep, mask };
     }
 
     inline static void popFrame()
@@ -182,8 +202,11 @@ private:
     size_t spos;
     size_t epos;
 
+    //kept as the list changes so the telemetry does not walk the block chain in the pause
+    size_t count;
+
 public:
-    GCRefList() : headrl(nullptr), tailrl(nullptr), spos(1), epos(1) 
+    GCRefList() : headrl(nullptr), tailrl(nullptr), spos(1), epos(1), count(0)
     {
         this->headrl = (void**)zxalloc(GC_REF_LIST_BLOCK_SIZE_DEFAULT * sizeof(void*));
         this->tailrl = this->headrl;
@@ -216,11 +239,13 @@ public:
         this->tailrl = other.tailrl;
         this->spos = other.spos;
         this->epos = other.epos;
+        this->count = other.count;
 
         other.headrl = (void**)zxalloc(GC_REF_LIST_BLOCK_SIZE_DEFAULT * sizeof(void*));
         other.tailrl = other.headrl;
         other.spos = 1;
         other.epos = 1;
+        other.count = 0;
     }
 
     void reset()
@@ -237,6 +262,7 @@ public:
         this->tailrl = this->headrl;
         this->spos = 1;
         this->epos = 1;
+        this->count = 0;
     }
 
     bool empty() const
@@ -244,16 +270,24 @@ public:
         return (this->headrl == this->tailrl && this->spos == this->epos);
     }
 
+    size_t size() const
+    {
+        return this->count;
+    }
+
     void enqueSlow(void* v)
     {
         void** tmp = (void**)zxalloc(GC_REF_LIST_BLOCK_SIZE_DEFAULT * sizeof(void*));
         this->tailrl[0] = tmp;
         this->tailrl = tmp;
         this->epos = 1;
+
+        this->tailrl[this->epos++] = v;
     }
 
     inline void enque(void* v)
     {
+        this->count++;
         if(this->epos < GC_REF_LIST_BLOCK_SIZE_DEFAULT)
         {
             this->tailrl[this->epos++] = v;
@@ -279,9 +313,10 @@ public:
     {
         assert(!this->empty());
 
+        this->count--;
         if(this->spos < GC_REF_LIST_BLOCK_SIZE_DEFAULT)
         {
-            return this->tailrl[this->spos++];
+            return this->headrl[this->spos++];
         }
         else
         {
@@ -308,7 +343,8 @@ public:
 
     inline void iterAdvance(GCRefListIterator& iter) const
     {
-        if(iter.cpos < GC_REF_LIST_BLOCK_SIZE_DEFAULT)
+        //stay in a full tail block so the position matches epos (there is no next block to move to)
+        if((iter.cpos + 1 < GC_REF_LIST_BLOCK_SIZE_DEFAULT) | (iter.crl == this->tailrl))
         {
             iter.cpos++;
         }
@@ -319,17 +355,41 @@ public:
     }
 };
 
+//Nursery sizing knobs (--gc-nursery-min/--gc-nursery-max/--gc-target-pause-us or the ICPP_GC_NURSERY_MIN/ICPP_GC_NURSERY_MAX/ICPP_GC_TARGET_PAUSE_US environment variables)
+//Latency sensitive runs want a small target (the nursery shrinks until the pauses fit) and throughput runs a large max with no target (0)
+struct GCNurseryPolicy
+{
+    size_t minsize;
+    size_t maxsize;
+    uint64_t targetpausens;
+};
+
 //A class that implements our bump pointer nursery space
 class BumpSpaceAllocator
 {
 private:
-    //We inline the fields for the current/end of the block that we are allocating from
+    //We inline the fields for the current/end of the block that we are allocating from -- m_endPos is the end of the zeroed space (not the block)
     uint8_t *m_currPos;
     uint8_t *m_endPos;
 
     size_t m_allocsize;
     uint8_t* m_block;
 
+    //memory at or past m_dirtyEnd has never been written since the block was mapped (so it does not need to be zeroed)
+    uint8_t* m_dirtyEnd;
+
+    //bytes allocated in blocks that have already been collected (for the total allocation count)
+    size_t m_flushedbytes;
+
+    //bytes pretenured into the old space since the last collection -- they use up the nursery budget so a pretenuring heavy phase still collects
+    size_t m_chargedbytes;
+
+    GCNurseryPolicy m_policy;
+
+    //smoothed survival fraction and pause time of the recent collections
+    double m_survival;
+    double m_pausens;
+
 #ifdef ENABLE_MEM_STATS
     size_t totalbumpalloc;
 #endif
@@ -338,36 +398,84 @@ private:
     {
         this->m_allocsize = asize;
         this->m_block = (uint8_t*)BSQ_BUMP_SPACE_ALLOC(asize);
+        assert(this->m_block != nullptr && this->m_block != (uint8_t*)-1);
+        BSQ_PAGE_SPACE_ADVISE_HUGE(this->m_block, asize);
+
+        this->m_dirtyEnd = BSQ_PAGE_SPACE_ZEROED ? this->m_block : (this->m_block + asize);
 
         this->m_currPos = this->m_block;
-        this->m_endPos = this->m_block + asize;
+        this->m_endPos = this->m_block;
+        this->extendZeroedSpace(0);
     }
 
-    void resizeAllocatorAsNeeded(size_t rcalloc)
+    //Move the end of the zeroed space so at least required bytes are available past m_currPos -- false if the block does not have the space
+    bool extendZeroedSpace(size_t required)
     {
-        bool shouldgrow = this->m_allocsize < BSQ_MAX_NURSERY_SIZE && this->m_allocsize < rcalloc / 3;
-        bool shouldshrink = BSQ_MIN_NURSERY_SIZE < this->m_allocsize && rcalloc < this->m_allocsize;
+        size_t used = (size_t)(this->m_currPos - this->m_block) + this->m_chargedbytes;
+        if(this->m_allocsize < used || this->m_allocsize - used < required)
+        {
+            return false;
+        }
+
+        size_t zeroed = (size_t)(this->m_endPos - this->m_block);
+        size_t target = std::min(std::max(used + required, zeroed + BSQ_NURSERY_ZERO_CHUNK), this->m_allocsize);
 
-        if (!(shouldgrow || shouldshrink))
+        uint8_t* ntarget = this->m_block + target;
+        if(this->m_endPos < this->m_dirtyEnd)
         {
-            GC_MEM_ZERO(this->m_block, this->m_allocsize);
+            GC_MEM_ZERO(this->m_endPos, std::min(ntarget, this->m_dirtyEnd) - this->m_endPos);
+        }
+
+        this->m_endPos = ntarget;
+        return true;
+    }
+
+    void resizeAllocatorAsNeeded(size_t promotedbytes, uint64_t pausens)
+    {
+        size_t used = this->currentAllocatedSlabBytes();
+        if(used == 0)
+        {
+            return;
+        }
+
+        this->m_survival = (this->m_survival + ((double)promotedbytes / (double)used)) / 2.0;
+        this->m_pausens = (this->m_pausens + (double)pausens) / 2.0;
+
+        size_t nsize = this->m_allocsize;
+        double target = (double)this->m_policy.targetpausens;
+        if(target != 0.0 && target < this->m_pausens)
+        {
+            nsize = (size_t)((double)this->m_allocsize * std::max(0.5, target / this->m_pausens));
+        }
+        else if(this->m_survival < BSQ_NURSERY_GROW_SURVIVAL && (target == 0.0 || 2.0 * this->m_pausens <= target))
+        {
+            nsize = 2 * this->m_allocsize;
         }
         else
         {
-            free(this->m_block);
-            if (shouldgrow)
-            {
-                this->setAllocBlock(2 * this->m_allocsize);
-            }
-            else
-            {
-                this->setAllocBlock(this->m_allocsize / 2);
-            }
+            ;
+        }
+
+        nsize = BumpSpaceAllocator::clampNurserySize(nsize, this->m_policy);
+
+        //small adjustments are not worth remapping the block for
+        size_t slack = this->m_allocsize / 8;
+        if(this->m_allocsize + slack < nsize || nsize + slack < this->m_allocsize)
+        {
+            //a block that is kept is re-zeroed lazily as it is allocated from (so the pause does not scale with the nursery size)
+            BSQ_BUMP_SPACE_RELEASE(this->m_block, this->m_allocsize);
+            this->setAllocBlock(nsize);
         }
     }
 
+    static size_t clampNurserySize(size_t nsize, const GCNurseryPolicy& policy)
+    {
+        size_t csize = std::min(std::max(nsize, policy.minsize), policy.maxsize);
+        return (csize + BSQ_RC_SLAB_SIZE - 1) & ~((size_t)BSQ_RC_SLAB_SIZE - 1);
+    }
+
 public:
-    BumpSpaceAllocator() : m_block(nullptr)
+    BumpSpaceAllocator() : m_block(nullptr), m_flushedbytes(0), m_chargedbytes(0), m_policy({BSQ_MIN_NURSERY_SIZE, BSQ_MAX_NURSERY_SIZE, BSQ_NURSERY_TARGET_PAUSE_US * 1000}), m_survival(0.0), m_pausens(0.0)
     {
         MEM_STATS_OP(this->totalbumpalloc = 0);
         MEM_STATS_OP(this->totalbigalloc = 0);
@@ -377,15 +485,45 @@ public:
 
     ~BumpSpaceAllocator()
     {
-        BSQ_BUMP_SPACE_RELEASE(this->m_block);
+        BSQ_BUMP_SPACE_RELEASE(this->m_block, this->m_allocsize);
+    }
+
+    //called at startup (before anything is allocated) with the knobs from the command line or environment
+    void setPolicy(const GCNurseryPolicy& policy)
+    {
+        this->m_policy = policy;
+        this->m_policy.minsize = std::max(policy.minsize, (size_t)(4 * BSQ_ALLOC_MAX_BLOCK_SIZE));
+        this->m_policy.maxsize = std::max(policy.maxsize, this->m_policy.minsize);
+
+        size_t nsize = BumpSpaceAllocator::clampNurserySize(this->m_allocsize, this->m_policy);
+        if(nsize != this->m_allocsize)
+        {
+            BSQ_BUMP_SPACE_RELEASE(this->m_block, this->m_allocsize);
+            this->setAllocBlock(nsize);
+        }
+    }
+
+    const GCNurseryPolicy& getPolicy() const
+    {
+        return this->m_policy;
+    }
+
+    size_t currentNurserySize() const
+    {
+        return this->m_allocsize;
     }
 
-    void postGCProcess(size_t rcmem)
+    void postGCProcess(size_t promotedbytes, uint64_t pausens)
     {
-        this->resizeAllocatorAsNeeded(rcmem);
+        this->m_flushedbytes += this->currentAllocatedSlabBytes();
+        this->m_dirtyEnd = std::max(this->m_dirtyEnd, this->m_currPos);
 
+        this->resizeAllocatorAsNeeded(promotedbytes, pausens);
+
+        this->m_chargedbytes = 0;
         this->m_currPos = this->m_block;
-        this->m_endPos = this->m_block + this->m_allocsize;
+        this->m_endPos = this->m_block;
+        this->extendZeroedSpace(0);
     }
 
     size_t currentAllocatedSlabBytes() const
@@ -393,7 +531,24 @@ public:
         return (size_t)(this->m_currPos - this->m_block);
     }
 
-    void ensureSpace_slow();
+    size_t totalAllocatedBytes() const
+    {
+        return this->m_flushedbytes + this->currentAllocatedSlabBytes();
+    }
+
+    void ensureSpace_slow(size_t required);
+
+    //Count bytes allocated outside the nursery against it -- the next extension of the zeroed space that runs past the budget collects
+    //(the zeroed end is left alone since ensureSpace callers may still allocateSafe into it)
+    void chargeAllocation(size_t bytes)
+    {
+        this->m_chargedbytes += bytes;
+    }
+
+    bool isOverBudget() const
+    {
+        return this->m_allocsize < this->currentAllocatedSlabBytes() + this->m_chargedbytes;
+    }
 
     //Return uint8_t* of given asize + sizeof(MetaData*)
     inline uint8_t* allocateDynamicSize(size_t asize)
@@ -402,7 +557,7 @@ public:
 
         if(this->m_currPos + rsize > this->m_endPos)
         {
-             this->ensureSpace_slow();
+             this->ensureSpace_slow(rsize);
         }
 
         uint8_t* res = this->m_currPos;
@@ -415,7 +570,7 @@ public:
     {
         if (this->m_currPos + required > this->m_endPos)
         {
-            this->ensureSpace_slow();
+            this->ensureSpace_slow(required);
         }
     }
 
@@ -431,15 +586,312 @@ public:
     }
 };
 
+//Header at the start of each slab -- objects of the size class follow it
+struct RCSlab
+{
+    //link in the partial list for the size class (slabs with free space)
+    RCSlab* next;
+    RCSlab* prev;
+
+    //released objects are threaded through their first word
+    void* freelist;
+
+    //objects past this point have never been allocated
+    uint8_t* bumppos;
+
+    uint32_t sizeclass;
+    uint32_t livecount;
+    uint32_t capacity;
+
+    bool inpartial;
+    bool pendingempty;
+};
+
+//Segregated fit allocator for the old RC space -- a size class for each word multiple up to BSQ_RC_SLAB_MAX_OBJECT_SIZE
+//Slabs are BSQ_RC_SLAB_SIZE aligned so the slab of an object is found by masking its address
+class RCSpaceAllocator
+{
+private:
+    RCSlab* partial[BSQ_RC_SLAB_SIZE_CLASS_COUNT];
+
+    //slabs that hit zero live objects since the last releaseEmptySlabs
+    std::vector<RCSlab*> pendingempty;
+
+    //empty slabs ready for reuse (pages still resident) and ones whose pages have been given back to the OS
+    std::vector<RCSlab*> emptyslabs;
+    std::vector<RCSlab*> decommittedslabs;
+
+    uint8_t* chunkpos;
+    uint8_t* chunkend;
+
+    static inline RCSlab* slabOf(void* m)
+    {
+        return (RCSlab*)((uintptr_t)m & ~((uintptr_t)BSQ_RC_SLAB_SIZE - 1));
+    }
+
+    inline void linkPartial(RCSlab* slab)
+    {
+        slab->prev = nullptr;
+        slab->next = this->partial[slab->sizeclass];
+        if(slab->next != nullptr)
+        {
+            slab->next->prev = slab;
+        }
+
+        this->partial[slab->sizeclass] = slab;
+        slab->inpartial = true;
+    }
+
+    inline void unlinkPartial(RCSlab* slab)
+    {
+        if(slab->prev != nullptr)
+        {
+            slab->prev->next = slab->next;
+        }
+        else
+        {
+            this->partial[slab->sizeclass] = slab->next;
+        }
+
+        if(slab->next != nullptr)
+        {
+            slab->next->prev = slab->prev;
+        }
+
+        slab->inpartial = false;
+    }
+
+    RCSlab* allocateSlab_slow(size_t sclass);
+
+public:
+    static inline size_t sizeClassFor(size_t osize)
+    {
+        return (osize - 1) / sizeof(void*);
+    }
+
+    static inline size_t objectSizeFor(size_t sclass)
+    {
+        return (sclass + 1) * sizeof(void*);
+    }
+
+    //caller ensures the slab is not full
+    static inline void* allocateFromSlab(RCSlab* slab)
+    {
+        void* obj = slab->freelist;
+        if(obj != nullptr)
+        {
+            slab->freelist = *((void**)obj);
+        }
+        else
+        {
+            obj = slab->bumppos;
+            slab->bumppos += RCSpaceAllocator::objectSizeFor(slab->sizeclass);
+        }
+
+        slab->livecount++;
+        return obj;
+    }
+
+    RCSpaceAllocator() : pendingempty(), emptyslabs(), decommittedslabs(), chunkpos(nullptr), chunkend(nullptr)
+    {
+        std::fill(this->partial, this->partial + BSQ_RC_SLAB_SIZE_CLASS_COUNT, nullptr);
+    }
+
+    ~RCSpaceAllocator()
+    {
+        ;
+    }
+
+    //osize includes the meta word
+    inline void* allocate(size_t osize)
+    {
+        if(osize > BSQ_RC_SLAB_MAX_OBJECT_SIZE)
+        {
+            return BSQ_FREE_LIST_ALLOC_LARGE(osize);
+        }
+
+        size_t sclass = RCSpaceAllocator::sizeClassFor(osize);
+        RCSlab* slab = this->partial[sclass];
+        if(slab == nullptr)
+        {
+            slab = this->allocateSlab_slow(sclass);
+        }
+
+        void* obj = RCSpaceAllocator::allocateFromSlab(slab);
+        if(slab->livecount == slab->capacity)
+        {
+            this->unlinkPartial(slab);
+        }
+
+        return obj;
+    }
+
+    inline void release(size_t osize, void* obj)
+    {
+        if(osize > BSQ_RC_SLAB_MAX_OBJECT_SIZE)
+        {
+            BSQ_FREE_LIST_RELEASE_LARGE(obj);
+            return;
+        }
+
+        RCSlab* slab = RCSpaceAllocator::slabOf(obj);
+        *((void**)obj) = slab->freelist;
+        slab->freelist = obj;
+
+        if(!slab->inpartial)
+        {
+            this->linkPartial(slab);
+        }
+
+        slab->livecount--;
+        if(slab->livecount == 0 && !slab->pendingempty)
+        {
+            slab->pendingempty = true;
+            this->pendingempty.push_back(slab);
+        }
+    }
+
+    //Hand a slab of the size class to a parallel GC worker (it is off the partial list until returned) -- callers hold the GC slab lock
+    inline RCSlab* takeSlab(size_t sclass)
+    {
+        RCSlab* slab = this->partial[sclass];
+        if(slab == nullptr)
+        {
+            slab = this->allocateSlab_slow(sclass);
+        }
+
+        this->unlinkPartial(slab);
+        return slab;
+    }
+
+    inline void returnSlab(RCSlab* slab)
+    {
+        if(slab->livecount < slab->capacity)
+        {
+            this->linkPartial(slab);
+        }
+    }
+
+    //Move slabs that are still empty out of the partial lists and give the pages back to the OS once more than BSQ_RC_SLAB_RETAIN_EMPTY are idle -- called after each batch of releases
+    void releaseEmptySlabs();
+};
+
+struct GCParallelWorker;
+
+//Optional parallel minor collection (--gc-threads=N) -- the roots are split over a pool of workers that race to claim young objects, each promotes into its own slabs and traces from its own stack (stealing from the others when it runs dry)
+class GCParallelEvacuator
+{
+public:
+    static uint32_t g_threadcount;
+
+    //start the worker pool -- called once before any collection
+    static void configure(uint32_t nthreads);
+
+    //replaces processRoots + processHeap when g_threadcount > 1
+    static void evacuate();
+
+    //used by the workers for the parts that touch the allocator
+    static RCSlab* takeSlab(size_t sclass);
+    static void processSharedRoots(GCParallelWorker& wk);
+    static void mergeWorker(GCParallelWorker& wk);
+};
+
+//Optional background release (--gc-background-release) -- the pause only finds the dead old objects and a parked thread frees them (cascading the decrements) while the mutator runs
+//The mutator never updates old space headers so the next collection just waits for the thread -- header updates on live objects are atomic since the mutator reads their type bits
+class GCBackgroundReleaser
+{
+public:
+    static bool g_enabled;
+
+    //start the release thread -- called once before any collection
+    static void configure();
+
+    //hand the release list (and the recorded root marks) to the thread
+    static void start();
+    static void waitForIdle();
+
+    //finish any pending release and join the thread -- registered with atexit by configure
+    static void shutdown();
+
+    static void releaseAll();
+};
+
+//Pause time (ns) of the minor collections and where the release work was done
+struct GCPauseStats
+{
+    uint64_t count;
+    uint64_t totalns;
+    uint64_t maxns;
+
+    uint64_t pausereleasens;
+    uint64_t backgroundreleasens;
+    uint64_t releasedbytes;
+};
+
+//Telemetry for a single minor collection (times are in ns) -- the runner emits these as JSON when ICPP_OUTPUT_MODE is not simple
+struct GCCycleTelemetry
+{
+    uint64_t rootsns;
+    uint64_t heapns;
+    uint64_t releasens;
+    uint64_t totalns;
+
+    size_t promotedbytes;
+    size_t releasedbytes;
+    size_t nurserybytes;
+    size_t nurseryusedbytes;
+    size_t liveoldbytes;
+
+    //maybeZeroCounts length and objects left on the release list (for the background release thread or the next pause) when the pause ends
+    size_t maybezerocount;
+    size_t releasebacklog;
+};
+
+//Per type nursery survival counts used to pick the types to pretenure
+struct GCTypeSurvival
+{
+    //counts for the current measurement window
+    uint64_t allocated;
+    uint64_t survived;
+
+    //totals of the closed windows and of the direct old space allocations
+    uint64_t totalallocated;
+    uint64_t totalsurvived;
+    uint64_t totalpretenured;
+
+    //collections left before a pretenured type goes back to the nursery (0 if it is not pretenured)
+    uint32_t pretenuregcs;
+};
+
 class Allocator
 {
+    friend class GCParallelEvacuator;
+    friend class GCBackgroundReleaser;
+
 public:
     static Allocator GlobalAllocator;
 
+    //pretenure the types with high nursery survival (off with --gc-no-pretenure)
+    static bool g_pretenure;
+
+    //keep a GCCycleTelemetry entry per collection (only when the runner reports them -- ICPP_GC_TELEMETRY or a non simple output mode)
+    static bool g_telemetry;
+
+    //collection nodes live in fixed size segments so registered node pointers stay valid as the stack grows
+    static std::vector<BSQCollectionGCReprNode*> collectionsegments;
+    static size_t collectionsegmentidx;
     static BSQCollectionGCReprNode* collectionnodesend;
-    static BSQCollectionGCReprNode collectionnodes[BSQ_MAX_STACK];
-    static std::list<BSQCollectionIterator*> collectioniters;
-    static std::vector<std::list<BSQTempRootNode>> alloctemps;
+    static BSQCollectionGCReprNode* collectionnodeslimit;
+    static size_t maxcollectionnodes;
+    static BSQCollectionIterator* collectioniters;
+
+    //temp roots are a stack of nodes (in registration order) with their values bump allocated from fixed size segments so the value pointers stay valid as the stack grows
+    static std::vector<BSQTempRootNode> temproots;
+    static std::vector<BSQTempRootScope> temprootscopes;
+    static std::vector<uint8_t*> temprootsegments;
+    static size_t temprootsegmentidx;
+    static uint8_t* temprootpos;
+    static uint8_t* temprootlimit;
 
 #ifdef BSQ_DEBUG_BUILD
     static std::map<size_t, std::pair<const BSQType*, void*>> dbg_idToObjMap;
@@ -460,16 +912,23 @@ public:
 
     void reset()
     {
-        Allocator::collectionnodesend = Allocator::collectionnodes;
+        Allocator::collectionsegmentidx = 0;
+        Allocator::collectionnodesend = Allocator::collectionsegments[0];
+        Allocator::collectionnodeslimit = Allocator::collectionsegments[0] + BSQ_INITIAL_STACK;
 
-        Allocator::collectioniters.clear();
-        Allocator::alloctemps.clear();
+        Allocator::collectioniters = nullptr;
+        Allocator::temproots.clear();
+        Allocator::temprootscopes.clear();
+        Allocator::temprootsegmentidx = 0;
+        Allocator::temprootpos = Allocator::temprootsegments[0];
+        Allocator::temprootlimit = Allocator::temprootsegments[0] + BSQ_TEMP_ROOT_SEGMENT_SIZE;
 
         Allocator::dbg_idToObjMap.clear();
     }
 
 private:
     BumpSpaceAllocator bumpalloc;
+    RCSpaceAllocator rcspace;
 
     GCRefList maybeZeroCounts;
     GCRefList newMaybeZeroCounts;
@@ -477,7 +936,22 @@ private:
     GCRefList worklist;
     GCRefList releaselist;
 
+    //objects allocated directly in the old space since the last collection -- their fields may point into the nursery so they are traced like promoted objects
+    GCRefList pretenuredobjs;
+    std::vector<GCTypeSurvival> typesurvival;
+
     size_t liveoldspace;
+    GCPauseStats pausestats;
+
+    //bytes moved out of the nursery in the current collection (the survival feedback for the nursery sizing)
+    size_t cyclepromotedbytes;
+
+    //one entry per collection -- the current one is filled in as the collection runs
+    GCCycleTelemetry currentcycle;
+    std::vector<GCCycleTelemetry> gctelemetry;
+
+    //with background release the root marks are recorded here instead of cleared (the release cascade needs them) and the release thread clears them when it is done
+    std::vector<void*> deferredmarks;
 
     void* globals_mem;
     RefMask globals_mask;
@@ -491,21 +965,25 @@ private:
     template <bool isRoot>
     void* moveBumpObjectToOldRCSpace(void* obj, GC_META_DATA_WORD* addr, GC_META_DATA_WORD w, const BSQType* ometa, size_t osize)
     {
-        void* nobj = BSQ_FREE_LIST_ALLOC_SMALL(osize);
+        void* nobj = this->rcspace.allocate(osize);
 
         this->liveoldspace += osize;
+        this->cyclepromotedbytes += osize;
+        this->typesurvival[ometa->tid].survived++;
         MEM_STATS_OP(this->promotedbytes += osize);
 
         GC_MEM_COPY(nobj, addr, osize);
+        void* robj = (void*)((uint8_t*)nobj + sizeof(GC_META_DATA_WORD));
+
         if (!ometa->isLeaf())
         {
-            this->worklist.enque(nobj);
+            this->worklist.enque(robj);
         }
 
         if constexpr (isRoot)
         {
             GC_INIT_OLD_RC_ROOT_REF(nobj, w);
-            this->newMaybeZeroCounts.enque(nobj);
+            this->newMaybeZeroCounts.enque(robj);
         }
         else
         {
@@ -513,8 +991,6 @@ private:
         }
 
         GC_SET_TYPE_META_DATA_FORWARD_SENTINAL(addr);
-
-        void* robj = (void*)((uint8_t*)nobj + sizeof(GC_META_DATA_WORD));
         GC_SET_FORWARD_PTR(obj, robj);
 
         return robj;
@@ -615,6 +1091,43 @@ public:
         }
     }
 
+    template <bool isRoot>
+    static void gcProcessSlotsWithPlanExtra(void** slots, const GCTracePlan& plan)
+    {
+        for(size_t i = 0; i < plan.ptrslots.size(); ++i)
+        {
+            Allocator::gcProcessSlot<isRoot>(slots + plan.ptrslots[i]);
+        }
+        for(size_t i = 0; i < plan.stringslots.size(); ++i)
+        {
+            Allocator::gcProcessSlotWithString<isRoot>(slots + plan.stringslots[i]);
+        }
+        for(size_t i = 0; i < plan.bignumslots.size(); ++i)
+        {
+            Allocator::gcProcessSlotWithBigNum<isRoot>(slots + plan.bignumslots[i]);
+        }
+        for(size_t i = 0; i < plan.unionslots.size(); ++i)
+        {
+            Allocator::gcProcessSlotsWithUnion<isRoot>(slots + plan.unionslots[i]);
+        }
+    }
+
+    template <bool isRoot>
+    inline static void gcProcessSlotsWithPlan(void** slots, const GCTracePlan& plan)
+    {
+        uint64_t bits = plan.ptrbits;
+        while(bits != 0)
+        {
+            Allocator::gcProcessSlot<isRoot>(slots + std::countr_zero(bits));
+            bits &= (bits - 1);
+        }
+
+        if(plan.hasextra)
+        {
+            Allocator::gcProcessSlotsWithPlanExtra<isRoot>(slots, plan);
+        }
+    }
+
     ////////
     //Operations GC decrement
     inline static void gcDecrement(void* v)
@@ -622,10 +1135,17 @@ public:
         if (v != nullptr)
         {
             GC_META_DATA_WORD* addr = GC_GET_META_DATA_ADDR(v);
-            GC_META_DATA_WORD waddr = GC_LOAD_META_DATA_WORD(addr);
+            GC_META_DATA_WORD w;
+            if(GCBackgroundReleaser::g_enabled)
+            {
+                w = GC_DEC_RC(std::atomic_ref<GC_META_DATA_WORD>(*addr).fetch_sub(GC_RC_ONE, std::memory_order_relaxed));
+            }
+            else
+            {
+                w = GC_DEC_RC(GC_LOAD_META_DATA_WORD(addr));
+                GC_SET_META_DATA_WORD(addr, w);
+            }
 
-            GC_META_DATA_WORD w = GC_DEC_RC(waddr);
-            GC_SET_META_DATA_WORD(addr, w);
             if (GC_TEST_IS_UNREACHABLE(w))
             {
                 Allocator::GlobalAllocator.releaselist.enque(v);
@@ -687,12 +1207,53 @@ public:
         }
     }
 
+    static void gcDecSlotsWithPlanExtra(void** slots, const GCTracePlan& plan)
+    {
+        for(size_t i = 0; i < plan.ptrslots.size(); ++i)
+        {
+            Allocator::gcDecrement(slots[plan.ptrslots[i]]);
+        }
+        for(size_t i = 0; i < plan.stringslots.size(); ++i)
+        {
+            Allocator::gcDecrementString(slots[plan.stringslots[i]]);
+        }
+        for(size_t i = 0; i < plan.bignumslots.size(); ++i)
+        {
+            Allocator::gcDecrementBigNum(slots[plan.bignumslots[i]]);
+        }
+        for(size_t i = 0; i < plan.unionslots.size(); ++i)
+        {
+            Allocator::gcDecrementSlotsWithUnion(slots + plan.unionslots[i]);
+        }
+    }
+
+    inline static void gcDecSlotsWithPlan(void** slots, const GCTracePlan& plan)
+    {
+        uint64_t bits = plan.ptrbits;
+        while(bits != 0)
+        {
+            Allocator::gcDecrement(slots[std::countr_zero(bits)]);
+            bits &= (bits - 1);
+        }
+
+        if(plan.hasextra)
+        {
+            Allocator::gcDecSlotsWithPlanExtra(slots, plan);
+        }
+    }
+
     ////////
     //Operations GC mark clear
     inline static void gcClearMark(void* v)
     {
         if (v != nullptr)
         {
+            if(GCBackgroundReleaser::g_enabled)
+            {
+                Allocator::GlobalAllocator.deferredmarks.push_back(v);
+                return;
+            }
+
             GC_META_DATA_WORD* addr = GC_GET_META_DATA_ADDR(v);
             GC_META_DATA_WORD w = GC_CLEAR_MARK_BIT(GC_LOAD_META_DATA_WORD(addr));
             GC_SET_META_DATA_WORD(addr, w);
@@ -753,6 +1314,41 @@ public:
         }
     }
 
+    static void gcClearMarkSlotsWithPlanExtra(void** slots, const GCTracePlan& plan)
+    {
+        for(size_t i = 0; i < plan.ptrslots.size(); ++i)
+        {
+            Allocator::gcClearMark(slots[plan.ptrslots[i]]);
+        }
+        for(size_t i = 0; i < plan.stringslots.size(); ++i)
+        {
+            Allocator::gcClearMarkString(slots[plan.stringslots[i]]);
+        }
+        for(size_t i = 0; i < plan.bignumslots.size(); ++i)
+        {
+            Allocator::gcClearMarkBigNum(slots[plan.bignumslots[i]]);
+        }
+        for(size_t i = 0; i < plan.unionslots.size(); ++i)
+        {
+            Allocator::gcClearMarkSlotsWithUnion(slots + plan.unionslots[i]);
+        }
+    }
+
+    inline static void gcClearMarkSlotsWithPlan(void** slots, const GCTracePlan& plan)
+    {
+        uint64_t bits = plan.ptrbits;
+        while(bits != 0)
+        {
+            Allocator::gcClearMark(slots[std::countr_zero(bits)]);
+            bits &= (bits - 1);
+        }
+
+        if(plan.hasextra)
+        {
+            Allocator::gcClearMarkSlotsWithPlanExtra(slots, plan);
+        }
+    }
+
     ////////
     //Operations Make Immortal
     inline static void gcMakeImmortal(void* v)
@@ -820,6 +1416,41 @@ public:
         }
     }
 
+    static void gcMakeImmortalSlotsWithPlanExtra(void** slots, const GCTracePlan& plan)
+    {
+        for(size_t i = 0; i < plan.ptrslots.size(); ++i)
+        {
+            Allocator::gcMakeImmortal(slots[plan.ptrslots[i]]);
+        }
+        for(size_t i = 0; i < plan.stringslots.size(); ++i)
+        {
+            Allocator::gcMakeImmortalString(slots[plan.stringslots[i]]);
+        }
+        for(size_t i = 0; i < plan.bignumslots.size(); ++i)
+        {
+            Allocator::gcMakeImmortalBigNum(slots[plan.bignumslots[i]]);
+        }
+        for(size_t i = 0; i < plan.unionslots.size(); ++i)
+        {
+            Allocator::gcMakeImmortalSlotsWithUnion(slots + plan.unionslots[i]);
+        }
+    }
+
+    inline static void gcMakeImmortalSlotsWithPlan(void** slots, const GCTracePlan& plan)
+    {
+        uint64_t bits = plan.ptrbits;
+        while(bits != 0)
+        {
+            Allocator::gcMakeImmortal(slots[std::countr_zero(bits)]);
+            bits &= (bits - 1);
+        }
+
+        if(plan.hasextra)
+        {
+            Allocator::gcMakeImmortalSlotsWithPlanExtra(slots, plan);
+        }
+    }
+
 private:
     ////////
     //GC algorithm
@@ -835,30 +1466,44 @@ private:
             Allocator::gcProcessSlotsWithMask<true>((void**)Allocator::GlobalAllocator.globals_mem, Allocator::GlobalAllocator.globals_mask);
         }
 
-        BSQCollectionGCReprNode* cni = Allocator::collectionnodes;
-        while(cni < Allocator::collectionnodesend)
+        for(size_t j = 0; j <= Allocator::collectionsegmentidx; ++j)
         {
-            Allocator::gcProcessSlot<true>(&(cni->repr));
+            BSQCollectionGCReprNode* cni = Allocator::collectionsegments[j];
+            BSQCollectionGCReprNode* cnend = (j == Allocator::collectionsegmentidx) ? Allocator::collectionnodesend : (cni + BSQ_INITIAL_STACK);
+            while(cni < cnend)
+            {
+                Allocator::gcProcessSlot<true>(&(cni->repr));
+                cni++;
+            }
         }
 
-        for(auto citer = Allocator::collectioniters.begin(); citer != Allocator::collectioniters.end(); ++citer)
+        for(BSQCollectionIterator* citer = Allocator::collectioniters; citer != nullptr; citer = citer->gcnext)
         {
-            Allocator::gcProcessSlot<true>(&((*citer)->lcurr));
-            for(auto piter = (*citer)->iterstack.begin(); piter != (*citer)->iterstack.end(); piter++)
+            Allocator::gcProcessSlot<true>(&(citer->lcurr));
+            for(auto piter = citer->iterstack.begin(); piter != citer->iterstack.end(); piter++)
             {
                 Allocator::gcProcessSlot<true>(&(*piter));
             }
         }
 
-        for(auto titer = Allocator::alloctemps.begin(); titer != Allocator::alloctemps.end(); ++titer)
+        for(size_t i = 0; i < Allocator::temproots.size(); ++i)
         {
-            for(auto iiter = titer->cbegin(); iiter != titer->cend(); ++iiter)
-            {
-                Allocator::gcProcessSlotsWithMask<true>((void**)iiter->root, iiter->rtype->allocinfo.inlinedmask);
-            }
+            Allocator::gcProcessSlotsWithPlan<true>((void**)Allocator::temproots[i].root, Allocator::temproots[i].rtype->inlinedplan);
+        }
+    }
+
+    void processPretenured()
+    {
+        while (!this->pretenuredobjs.empty())
+        {
+            void* obj = this->pretenuredobjs.deque();
+            Allocator::gcProcessSlotsWithPlan<false>((void**)obj, GET_TYPE_META_DATA(obj)->heapplan);
         }
     }
 
+    //close the survival windows that have enough allocations and switch types in and out of pretenuring
+    void updatePretenuring();
+
     void processHeap()
     {
         while (!this->worklist.empty())
@@ -868,7 +1513,7 @@ private:
             const BSQType* umeta = GET_TYPE_META_DATA(obj);
             assert(umeta->allocinfo.heapmask != nullptr);
 
-            Allocator::gcProcessSlotsWithMask<false>((void**)obj, umeta->allocinfo.heapmask);
+            Allocator::gcProcessSlotsWithPlan<false>((void**)obj, umeta->heapplan);
         }
     }
 
@@ -893,14 +1538,16 @@ private:
                     this->newMaybeZeroCounts.enque(obj);
                 }
             }
+
+            this->maybeZeroCounts.iterAdvance(iter);
         }
 
         this->maybeZeroCounts.assignFrom(this->newMaybeZeroCounts);
     }
 
-    void processRelease()
+    //returns the number of bytes freed
+    size_t processRelease(size_t freelimit)
     {
-        size_t freelimit = (3 * this->bumpalloc.currentAllocatedSlabBytes()) / 2;
         size_t freecount = 0;
 
         while (!this->releaselist.empty())
@@ -915,15 +1562,18 @@ private:
             const BSQType* umeta = GET_TYPE_META_DATA(obj);
             if (umeta->allocinfo.heapmask != nullptr)
             {
-                umeta->gcops.fpDecObj(umeta, (void**)obj);
+                Allocator::gcDecSlotsWithPlan((void**)obj, umeta->heapplan);
             }
 
             size_t asize = umeta->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
             freecount += asize;
 
             this->liveoldspace -= asize;
-            BSQ_FREE_LIST_RELEASE(asize, GC_GET_META_DATA_ADDR(obj));
+            this->rcspace.release(asize, GC_GET_META_DATA_ADDR(obj));
         }
+
+        this->rcspace.releaseEmptySlabs();
+        return freecount;
     }
 
     void clearAllMarkRoots()
@@ -938,32 +1588,34 @@ private:
             Allocator::gcClearMarkSlotsWithMask((void**)Allocator::GlobalAllocator.globals_mem, Allocator::GlobalAllocator.globals_mask);
         }
 
-        BSQCollectionGCReprNode* cni = Allocator::collectionnodes;
-        while(cni < Allocator::collectionnodesend)
+        for(size_t j = 0; j <= Allocator::collectionsegmentidx; ++j)
         {
-            Allocator::gcClearMark(cni->repr);
+            BSQCollectionGCReprNode* cni = Allocator::collectionsegments[j];
+            BSQCollectionGCReprNode* cnend = (j == Allocator::collectionsegmentidx) ? Allocator::collectionnodesend : (cni + BSQ_INITIAL_STACK);
+            while(cni < cnend)
+            {
+                Allocator::gcClearMark(cni->repr);
+                cni++;
+            }
         }
 
-        for(auto citer = Allocator::collectioniters.begin(); citer != Allocator::collectioniters.end(); ++citer)
+        for(BSQCollectionIterator* citer = Allocator::collectioniters; citer != nullptr; citer = citer->gcnext)
         {
-            Allocator::gcClearMark((*citer)->lcurr);
-            for(auto piter = (*citer)->iterstack.begin(); piter != (*citer)->iterstack.end(); piter++)
+            Allocator::gcClearMark(citer->lcurr);
+            for(auto piter = citer->iterstack.begin(); piter != citer->iterstack.end(); piter++)
             {
                 Allocator::gcClearMark(*piter);
             }
         }
 
-        for(auto titer = Allocator::alloctemps.begin(); titer != Allocator::alloctemps.end(); ++titer)
+        for(size_t i = 0; i < Allocator::temproots.size(); ++i)
         {
-            for(auto iiter = titer->cbegin(); iiter != titer->cend(); ++iiter)
-            {
-                Allocator::gcClearMarkSlotsWithMask((void**)iiter->root, iiter->rtype->allocinfo.inlinedmask);
-            }
+            Allocator::gcClearMarkSlotsWithPlan((void**)Allocator::temproots[i].root, Allocator::temproots[i].rtype->inlinedplan);
         }
     }
 
 public:
-    Allocator() : bumpalloc(), maybeZeroCounts(), newMaybeZeroCounts(), worklist(), releaselist(), liveoldspace(0), globals_mem(nullptr)
+    Allocator() : bumpalloc(), rcspace(), maybeZeroCounts(), newMaybeZeroCounts(), worklist(), releaselist(), pretenuredobjs(), typesurvival(), liveoldspace(0), pausestats({0, 0, 0, 0, 0, 0}), cyclepromotedbytes(0), currentcycle(), gctelemetry(), deferredmarks(), globals_mem(nullptr)
     {
         MEM_STATS_OP(this->gccount = 0);
         MEM_STATS_OP(this->promotedbytes = 0);
@@ -975,8 +1627,66 @@ public:
         ;
     }
 
+    size_t totalAllocatedBytes() const
+    {
+        return this->bumpalloc.totalAllocatedBytes();
+    }
+
+    void initializeTypeSurvival(size_t typecount)
+    {
+        this->typesurvival.resize(typecount, {0, 0, 0, 0, 0, 0});
+    }
+
+    const GCNurseryPolicy& getNurseryPolicy() const
+    {
+        return this->bumpalloc.getPolicy();
+    }
+
+    void configureNursery(const GCNurseryPolicy& policy)
+    {
+        this->bumpalloc.setPolicy(policy);
+    }
+
+    uint8_t* allocatePretenured(const BSQType* mdata)
+    {
+        size_t osize = mdata->allocinfo.heapsize + sizeof(GC_META_DATA_WORD);
+        uint8_t* nobj = (uint8_t*)this->rcspace.allocate(osize);
+        GC_MEM_ZERO(nobj, osize);
+
+        this->liveoldspace += osize;
+        this->typesurvival[mdata->tid].totalpretenured++;
+
+        //this never collects (allocateSafe callers hold unrooted pointers) -- the next ensureSpace/allocateDynamic that runs past the budget does
+        this->bumpalloc.chargeAllocation(osize);
+
+        //it has no heap references yet so it is checked in the next collection just like a promoted root
+        GC_SET_META_DATA_WORD(nobj, GC_RC_ZERO | mdata->tid);
+        uint8_t* robj = nobj + sizeof(GC_META_DATA_WORD);
+
+        this->maybeZeroCounts.enque(robj);
+        if(!mdata->isLeaf())
+        {
+            this->pretenuredobjs.enque(robj);
+        }
+
+        return robj;
+    }
+
     inline uint8_t* allocateDynamic(const BSQType* mdata)
     {
+        GCTypeSurvival& tsurvival = this->typesurvival[mdata->tid];
+        if(tsurvival.pretenuregcs != 0)
+        {
+            //this is a collection point so a run of pretenured allocations with no nursery allocations still collects
+            if(this->bumpalloc.isOverBudget())
+            {
+                this->collect();
+            }
+
+            return this->allocatePretenured(mdata);
+        }
+        tsurvival.allocated++;
+
         size_t asize = mdata->allocinfo.heapsize;
         uint8_t* alloc = this->bumpalloc.allocateDynamicSize(asize);
 
@@ -996,34 +1706,114 @@ public:
 
     inline uint8_t* allocateSafe(const BSQType* mdata)
     {
+        GCTypeSurvival& tsurvival = this->typesurvival[mdata->tid];
+        if(tsurvival.pretenuregcs != 0)
+        {
+            return this->allocatePretenured(mdata);
+        }
+        tsurvival.allocated++;
+
         uint8_t* alloc = this->bumpalloc.allocateSafe(mdata->allocinfo.heapsize);
 
         GC_INIT_BUMP_SPACE_ALLOC(alloc, mdata->tid);
         return (alloc + sizeof(GC_META_DATA_WORD));
     }
 
+    static inline uint64_t elapsedns(std::chrono::steady_clock::time_point start)
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
     void collect()
     {
+        auto pausestart = std::chrono::steady_clock::now();
+        this->cyclepromotedbytes = 0;
+        this->currentcycle = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+        //the old space is owned by the release thread until it is done with the last batch
+        GCBackgroundReleaser::waitForIdle();
+
         MEM_STATS_OP(this->gccount++);
         MEM_STATS_OP(this->maxheap = std::max(this->maxheap, this->bumpalloc.currentAllocatedSlabBytes() + this->rcalloc + this->liveoldspace));
 
         //mark and move all live objects out of new space
-        this->processRoots();
-        this->processHeap();
+        auto tracestart = std::chrono::steady_clock::now();
+        if(GCParallelEvacuator::g_threadcount > 1)
+        {
+            //the roots time is set by the worker that scans the shared roots
+            GCParallelEvacuator::evacuate();
+        }
+        else
+        {
+            this->processRoots();
+            this->processPretenured();
+            this->currentcycle.rootsns = Allocator::elapsedns(tracestart);
+
+            this->processHeap();
+        }
 
         //Sweep young roots and look possible unreachable old roots in the old with collect them as needed -- new zero counts are rotated in
         this->checkMaybeZeroCountList();
 
-        //Process release of RC space objects as needed
-        this->processRelease();
+        uint64_t tracens = Allocator::elapsedns(tracestart);
+        this->currentcycle.heapns = tracens - std::min(tracens, this->currentcycle.rootsns);
+
+        auto releasestart = std::chrono::steady_clock::now();
+        if(GCBackgroundReleaser::g_enabled)
+        {
+            //Record the marks for the release thread (it frees the release list without a limit and then clears them)
+            this->clearAllMarkRoots();
+        }
+        else
+        {
+            //Process release of RC space objects as needed
+            this->currentcycle.releasedbytes = this->processRelease((3 * this->bumpalloc.currentAllocatedSlabBytes()) / 2);
+            this->pausestats.releasedbytes += this->currentcycle.releasedbytes;
+            this->pausestats.pausereleasens += Allocator::elapsedns(releasestart);
+
+            //Clear any marks
+            this->clearAllMarkRoots();
+        }
+        this->currentcycle.releasens = Allocator::elapsedns(releasestart);
+
+        this->currentcycle.promotedbytes = this->cyclepromotedbytes;
+        this->currentcycle.nurserybytes = this->bumpalloc.currentNurserySize();
+        this->currentcycle.nurseryusedbytes = this->bumpalloc.currentAllocatedSlabBytes();
+
+        //Adjust the new space size from the survival rate and pause time so far and reset/free the newspace allocators
+        this->bumpalloc.postGCProcess(this->cyclepromotedbytes, Allocator::elapsedns(pausestart));
 
-        //Clear any marks
-        this->clearAllMarkRoots();
+        this->updatePretenuring();
 
-        //Adjust the new space size if needed and reset/free the newspace allocators
-        this->bumpalloc.postGCProcess(this->liveoldspace);
+        uint64_t pausens = Allocator::elapsedns(pausestart);
+        this->pausestats.count++;
+        this->pausestats.totalns += pausens;
+        this->pausestats.maxns = std::max(this->pausestats.maxns, pausens);
+
+        if(Allocator::g_telemetry)
+        {
+            this->currentcycle.totalns = pausens;
+            this->currentcycle.liveoldbytes = this->liveoldspace;
+            this->currentcycle.maybezerocount = this->maybeZeroCounts.size();
+            this->currentcycle.releasebacklog = this->releaselist.size();
+            this->gctelemetry.push_back(this->currentcycle);
+        }
+
+        if(GCBackgroundReleaser::g_enabled)
+        {
+            GCBackgroundReleaser::start();
+        }
     }
 
+    //waits for the release thread so the released bytes of the last collection are filled in
+    const std::vector<GCCycleTelemetry>& getGCTelemetry() const
+    {
+        GCBackgroundReleaser::waitForIdle();
+        return this->gctelemetry;
+    }
+
+    void displayGCStats(FILE* fp) const;
+
     void setGlobalsMemory(void* globals, const RefMask mask)
     {
         this->globals_mem = globals;
@@ -1042,12 +1832,33 @@ public:
 
     void registerCollectionIterator(BSQCollectionIterator* iter)
     {
-        Allocator::collectioniters.push_front(iter);
+        iter->gcprev = nullptr;
+        iter->gcnext = Allocator::collectioniters;
+        if(Allocator::collectioniters != nullptr)
+        {
+            Allocator::collectioniters->gcprev = iter;
+        }
+        Allocator::collectioniters = iter;
     }
 
     void releaseCollectionIterator(BSQCollectionIterator* iter)
     {
-        Allocator::collectioniters.erase(std::find(Allocator::collectioniters.begin(), Allocator::collectioniters.end(), iter));
+        if(iter->gcprev != nullptr)
+        {
+            iter->gcprev->gcnext = iter->gcnext;
+        }
+        else
+        {
+            Allocator::collectioniters = iter->gcnext;
+        }
+
+        if(iter->gcnext != nullptr)
+        {
+            iter->gcnext->gcprev = iter->gcprev;
+        }
+
+        iter->gcprev = nullptr;
+        iter->gcnext = nullptr;
     }
 
     BSQCollectionGCReprNode* getCollectionNodeCurrentEnd()
@@ -1055,9 +1866,14 @@ public:
         return Allocator::collectionnodesend;
     }
 
+    static void nextCollectionSegment_slow();
+
     BSQCollectionGCReprNode* registerCollectionNode(void* val)
     {
-        assert(collectionnodesend < collectionnodes + BSQ_MAX_STACK);
+        if(Allocator::collectionnodesend == Allocator::collectionnodeslimit)
+        {
+            Allocator::nextCollectionSegment_slow();
+        }
 
         Allocator::collectionnodesend->repr = val;
         return Allocator::collectionnodesend++;
@@ -1065,7 +1881,14 @@ public:
 
     BSQCollectionGCReprNode* resetCollectionNodeEnd(BSQCollectionGCReprNode* endpoint, void* val=nullptr)
     {
+        //endpoint is in the current segment or an earlier one (an end of a full segment counts as in that segment)
+        while(endpoint < Allocator::collectionsegments[Allocator::collectionsegmentidx] || Allocator::collectionsegments[Allocator::collectionsegmentidx] + BSQ_INITIAL_STACK < endpoint)
+        {
+            Allocator::collectionsegmentidx--;
+        }
+
         Allocator::collectionnodesend = endpoint;
+        Allocator::collectionnodeslimit = Allocator::collectionsegments[Allocator::collectionsegmentidx] + BSQ_INITIAL_STACK;
         if(val == nullptr)
         {
             return nullptr;
@@ -1078,30 +1901,49 @@ public:
 
     void pushTempRootScope()
     {
-        Allocator::alloctemps.push_back({});
+        Allocator::temprootscopes.push_back({Allocator::temproots.size(), Allocator::temprootsegmentidx, Allocator::temprootpos});
+    }
+
+    //the roots of the current scope in registration order -- valid until the next root is registered
+    BSQTempRootNode* getTempRootCurrScopeBegin()
+    {
+        return Allocator::temproots.data() + Allocator::temprootscopes.back().nodestart;
     }
 
-    std::list<BSQTempRootNode>& getTempRootCurrScope()
+    size_t getTempRootCurrScopeSize()
     {
-        return Allocator::alloctemps.back();
+        return Allocator::temproots.size() - Allocator::temprootscopes.back().nodestart;
     }
 
     void popTempRootScope()
     {
-        for(auto iter = Allocator::alloctemps.back().begin(); iter != Allocator::alloctemps.back().end(); ++iter)
-        {
-            xfree(iter->root);
-        }
+        const BSQTempRootScope& scope = Allocator::temprootscopes.back();
+
+        Allocator::temproots.resize(scope.nodestart, BSQTempRootNode(nullptr, nullptr));
+        Allocator::temprootsegmentidx = scope.segmentidx;
+        Allocator::temprootpos = scope.datapos;
+        Allocator::temprootlimit = Allocator::temprootsegments[scope.segmentidx] + BSQ_TEMP_ROOT_SEGMENT_SIZE;
 
-        Allocator::alloctemps.pop_back();
+        Allocator::temprootscopes.pop_back();
     }
 
-    std::list<BSQTempRootNode>::iterator registerTempRoot(const BSQType* btype)
+    static void nextTempRootSegment_slow();
+
+    //the node is only valid until the next root is registered but its (zeroed) value storage stays put until the scope is popped
+    BSQTempRootNode* registerTempRoot(const BSQType* btype)
     {
-        void* root = zxalloc(btype->allocinfo.inlinedatasize);
-        Allocator::alloctemps.back().emplace_front(btype, root);
+        size_t rsize = (btype->allocinfo.inlinedatasize + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+        if(Allocator::temprootpos + rsize > Allocator::temprootlimit)
+        {
+            Allocator::nextTempRootSegment_slow();
+        }
+
+        void* root = Allocator::temprootpos;
+        Allocator::temprootpos += rsize;
+        GC_MEM_ZERO(root, rsize);
 
-        return Allocator::alloctemps.back().begin();
+        Allocator::temproots.emplace_back(btype, root);
+        return &Allocator::temproots.back();
     }
 };
 
@@ -109,6 +109,34 @@ std::map<std::string, BSQPrimitiveImplTag> MarshalEnvironment::g_primitiveinvoke
     {"s_map_remove_ne", BSQPrimitiveImplTag::s_map_remove_ne}
 };
 
+InterpOpArena* InterpOpArena::g_currentarena = nullptr;
+
+InterpOpArena::~InterpOpArena()
+{
+    std::for_each(this->blocks.begin(), this->blocks.end(), [](uint8_t* block) {
+        free(block);
+    });
+}
+
+void* InterpOpArena::allocate(size_t size)
+{
+    size_t asize = (size + (alignof(std::max_align_t) - 1)) & ~(alignof(std::max_align_t) - 1);
+    if((size_t)(this->end - this->curr) < asize)
+    {
+        size_t bsize = std::max(asize, this->blocksize);
+        uint8_t* block = (uint8_t*)malloc(bsize);
+        this->blocks.push_back(block);
+
+        this->curr = block;
+        this->end = block + bsize;
+    }
+
+    void* res = this->curr;
+    this->curr += asize;
+
+    return res;
+}
+
 Argument jsonParse_Argument(json j)
 {
     return Argument{ j["kind"].get<ArgumentTag>(), j["location"].get<uint32_t>() };
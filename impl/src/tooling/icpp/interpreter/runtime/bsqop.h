@@ -174,7 +174,23 @@ enum class OpCodeTag
     LeBigIntOp,
     LeRationalOp,
     LeFloatOp,
-    LeDecimalOp
+    LeDecimalOp,
+
+    //Fused ops -- never emitted by the compiler, created by the load time rewrites in asm_opt.cpp
+    EqNatJumpCondOp,
+    EqIntJumpCondOp,
+    NeqNatJumpCondOp,
+    NeqIntJumpCondOp,
+    LtNatJumpCondOp,
+    LtIntJumpCondOp,
+    LeNatJumpCondOp,
+    LeIntJumpCondOp,
+    LoadEntityFieldDirectAssignOp,
+    VarLifetimeBlockOp,
+    InvokeSelfTailCallOp,
+
+    //Not an op -- count of the tags above (keep last)
+    OpCodeTagCount
 };
 
 struct Argument
@@ -223,6 +239,22 @@ struct BSQStatementGuard
 };
 BSQStatementGuard jsonParse_BSQStatementGuard(json j);
 
+class BSQInvokeBodyDecl;
+
+//Per call site cache of resolved virtual targets keyed on the receiver type
+//Sites fill entries on a miss until the cache is full, after that (megamorphic) misses just use the vtable lookup
+#define BSQ_INLINE_CACHE_SIZE 4
+
+struct BSQVirtualInlineCache
+{
+    BSQTypeID tids[BSQ_INLINE_CACHE_SIZE];
+    const BSQInvokeBodyDecl* targets[BSQ_INLINE_CACHE_SIZE];
+    uint32_t count;
+
+    uint64_t hits;
+    uint64_t misses;
+};
+
 const BSQType* jsonParse_BSQType(json j);
 BSQRecordPropertyID jsonParse_BSQRecordPropertyID(json j);
 BSQFieldID jsonParse_BSQFieldID(json j);
@@ -230,15 +262,52 @@ SourceInfo j_sinfo(json j);
 SourceInfo j_sinfoStart(json j);
 SourceInfo j_sinfoEnd(json j);
 
+//Bump allocated storage for the ops of an invoke body so the parsed ops sit next to each other in body order (ops made by the load time rewrites are appended after them)
+//This is a locality change only -- the body is still an array of pointers to virtual InterpOp objects, not a fixed width encoding
+//Ops are never freed individually -- all the storage is released when the arena is deleted
+class InterpOpArena
+{
+private:
+    std::vector<uint8_t*> blocks;
+    uint8_t* curr;
+    uint8_t* end;
+    const size_t blocksize;
+
+public:
+    //the arena that new ops are allocated from -- set while loading (or rewriting) an invoke body
+    static InterpOpArena* g_currentarena;
+
+    InterpOpArena(size_t blocksize) : blocks(), curr(nullptr), end(nullptr), blocksize(blocksize) {;}
+    ~InterpOpArena();
+
+    void* allocate(size_t size);
+};
+
 class InterpOp
 {
 public:
     const OpCodeTag tag;
     const SourceInfo sinfo;
 
+#ifdef BSQ_THREADED_DISPATCH
+    //handler label in the threaded op loop -- linked after load by Evaluator::linkOpDispatch
+    const void* dispatch = nullptr;
+#endif
+
     InterpOp(SourceInfo sinfo, OpCodeTag tag) : tag(tag), sinfo(sinfo) {;}
     virtual ~InterpOp() {;}
 
+    static void* operator new(size_t size)
+    {
+        assert(InterpOpArena::g_currentarena != nullptr);
+        return InterpOpArena::g_currentarena->allocate(size);
+    }
+
+    static void operator delete(void* p)
+    {
+        ; //storage is owned by the arena
+    }
+
     static InterpOp* jparse(json v);
 };
 
@@ -737,6 +806,8 @@ public:
     const BSQUnionType* rcvrlayouttype;
     const int32_t optmaskoffset;
     const std::vector<Argument> args;
+
+    mutable BSQVirtualInlineCache icache = {};
     
     InvokeVirtualFunctionOp(SourceInfo sinfo, TargetVar trgt, const BSQType* trgttype, BSQVirtualInvokeID invokeId, const BSQUnionType* rcvrlayouttype, std::vector<Argument> args, int32_t optmaskoffset) : InterpOp(sinfo, OpCodeTag::InvokeVirtualFunctionOp), trgt(trgt), trgttype(trgttype), invokeId(invokeId), rcvrlayouttype(rcvrlayouttype), optmaskoffset(optmaskoffset), args(args) {;}
     virtual ~InvokeVirtualFunctionOp() {;}
@@ -1227,3 +1298,58 @@ public:
     static PrimitiveBinaryCompareOp* jparse(json v);
 };
 
+//
+//Fused ops -- the fused op replaces the first op in the body and refers to it (the replaced op is owned by the body replacedops list), the other ops it covers stay in place (so jumps to them still work) and are skipped by the evaluator
+//
+
+template <OpCodeTag ttag>
+class PrimitiveBinaryCompareJumpCondOp : public InterpOp
+{
+public:
+    const TargetVar trgt;
+    const Argument larg;
+    const Argument rarg;
+
+    //offsets are relative to the fused op (so 1 + the offsets in the JumpCondOp)
+    const uint32_t toffset;
+    const uint32_t foffset;
+
+    const InterpOp* cmpop;
+
+    PrimitiveBinaryCompareJumpCondOp(SourceInfo sinfo, TargetVar trgt, Argument larg, Argument rarg, uint32_t toffset, uint32_t foffset, const InterpOp* cmpop) : InterpOp(sinfo, ttag), trgt(trgt), larg(larg), rarg(rarg), toffset(toffset), foffset(foffset), cmpop(cmpop) {;}
+    virtual ~PrimitiveBinaryCompareJumpCondOp() {;}
+};
+
+class LoadEntityFieldDirectAssignOp : public InterpOp
+{
+public:
+    const LoadEntityFieldDirectOp* loadop;
+    const DirectAssignOp* assignop;
+
+    LoadEntityFieldDirectAssignOp(SourceInfo sinfo, const LoadEntityFieldDirectOp* loadop, const DirectAssignOp* assignop) : InterpOp(sinfo, OpCodeTag::LoadEntityFieldDirectAssignOp), loadop(loadop), assignop(assignop) {;}
+    virtual ~LoadEntityFieldDirectAssignOp() {;}
+};
+
+class VarLifetimeBlockOp : public InterpOp
+{
+public:
+    //number of VarLifetimeStart/End ops covered (including the first)
+    const uint32_t count;
+    const InterpOp* firstop;
+
+    VarLifetimeBlockOp(SourceInfo sinfo, uint32_t count, const InterpOp* firstop) : InterpOp(sinfo, OpCodeTag::VarLifetimeBlockOp), count(count), firstop(firstop) {;}
+    virtual ~VarLifetimeBlockOp() {;}
+};
+
+//A call to the enclosing invoke whose result is returned directly -- evaluated by reusing the current frame (refers to the call op it replaces, which is owned by the body replacedops list)
+class InvokeSelfTailCallOp : public InterpOp
+{
+public:
+    const InvokeFixedFunctionOp* invokeop;
+
+    //total bytes of the parameter slots (args are staged here before the frame is overwritten)
+    const uint32_t argstagebytes;
+
+    InvokeSelfTailCallOp(SourceInfo sinfo, const InvokeFixedFunctionOp* invokeop, uint32_t argstagebytes) : InterpOp(sinfo, OpCodeTag::InvokeSelfTailCallOp), invokeop(invokeop), argstagebytes(argstagebytes) {;}
+    virtual ~InvokeSelfTailCallOp() {;}
+};
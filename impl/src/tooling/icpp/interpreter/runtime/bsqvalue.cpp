@@ -624,6 +624,43 @@ int entityStringKeyCmp_impl(const BSQType* btype, StorageLocationPtr data1, Stor
     return BSQStringImplType::keycmp(SLPTR_LOAD_CONTENTS_AS(BSQString, data1), SLPTR_LOAD_CONTENTS_AS(BSQString, data2));
 }
 
+//FNV-1a over the key bytes -- the hashed map uses the low bits so they need to be well mixed
+inline uint64_t keyHashBytes(uint64_t hh, const uint8_t* bytes, size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        hh = (hh ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hh;
+}
+
+#define KEY_HASH_SEED 0xcbf29ce484222325ull
+
+uint64_t entityStringKeyHash_impl(const BSQType* btype, StorageLocationPtr data)
+{
+    BSQString str = SLPTR_LOAD_CONTENTS_AS(BSQString, data);
+    if(BSQStringImplType::empty(str))
+    {
+        return KEY_HASH_SEED;
+    }
+    else if(IS_INLINE_STRING(&str))
+    {
+        return keyHashBytes(KEY_HASH_SEED, BSQInlineString::utf8Bytes(str.u_inlineString), BSQInlineString::utf8ByteCount(str.u_inlineString));
+    }
+    else
+    {
+        //same bytes as an equal inline string (reprs differ but keycmp looks at the bytes)
+        uint64_t hh = KEY_HASH_SEED;
+        BSQStringForwardIterator iter(&str, 0);
+        while(iter.valid())
+        {
+            hh = (hh ^ iter.get_byte()) * 0x100000001b3ull;
+            iter.advance_byte();
+        }
+        return hh;
+    }
+}
+
 uint8_t* BSQStringImplType::boxInlineString(BSQInlineString istr)
 {
     auto res = (uint8_t*)Allocator::GlobalAllocator.allocateSafe(BSQWellKnownType::g_typeStringKRepr16);
@@ -950,6 +987,12 @@ std::string entityUUIDDisplay_impl(const BSQType* btype, StorageLocationPtr data
     return res;
 }
 
+uint64_t entityUUIDKeyHash_impl(const BSQType* btype, StorageLocationPtr data)
+{
+    auto v = SLPTR_LOAD_CONTENTS_AS(BSQUUID, data);
+    return keyHashBytes(KEY_HASH_SEED, v.bytes, sizeof(v.bytes));
+}
+
 int entityUUIDKeyCmp_impl(const BSQType* btype, StorageLocationPtr data1, StorageLocationPtr data2)
 {
     auto v1 = SLPTR_LOAD_CONTENTS_AS(BSQUUID, data1);
@@ -983,6 +1026,16 @@ std::string entityContentHashDisplay_impl(const BSQType* btype, StorageLocationP
     return rr;
 }
 
+uint64_t entityContentHashKeyHash_impl(const BSQType* btype, StorageLocationPtr data)
+{
+    //already a cryptographic hash so the first word is as good as any
+    auto v = (BSQContentHash*)SLPTR_LOAD_CONTENTS_AS_GENERIC_HEAPOBJ(data);
+
+    uint64_t hh;
+    BSQ_MEM_COPY(&hh, v->bytes, sizeof(uint64_t));
+    return hh;
+}
+
 int entityContentHashKeyCmp_impl(const BSQType* btype, StorageLocationPtr data1, StorageLocationPtr data2)
 {
     auto v1 = (BSQContentHash*)SLPTR_LOAD_CONTENTS_AS_GENERIC_HEAPOBJ(data1);
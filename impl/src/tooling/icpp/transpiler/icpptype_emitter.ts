@@ -614,9 +614,10 @@ class ICPPTypeEmitter {
                         const vtype = entity.terms.get("V") as MIRType;
                         const vlayout = this.getICPPTypeInfoInlineLayout(vtype);
 
-                        const allocinfo = ICPPTypeSizeInfo.createByRefSizeInfo(entity.tkey, (ICPP_WORD_SIZE * 2) + klayout.size + vlayout.size, ("22" + klayout.mask + vlayout.mask));
+                        //l, r, and the subtree size (for the weight balancing) then the K and V
+                        const allocinfo = ICPPTypeSizeInfo.createByRefSizeInfo(entity.tkey, (ICPP_WORD_SIZE * 3) + klayout.size + vlayout.size, ("221" + klayout.mask + vlayout.mask));
 
-                        return new ICPPCollectionInternalsLayoutInfo(entity.tkey, allocinfo, [{name: "K", type: ktype.typeID, size: klayout.size, offset: 16}, {name: "V", type: vtype.typeID, size: vlayout.size, offset: 16 + klayout.size}]);
+                        return new ICPPCollectionInternalsLayoutInfo(entity.tkey, allocinfo, [{name: "K", type: ktype.typeID, size: klayout.size, offset: 24}, {name: "V", type: vtype.typeID, size: vlayout.size, offset: 24 + klayout.size}]);
                     }
                     else {
                         assert(false, "Unknown primitive internal entity");